@@ -120,6 +120,8 @@ int main(int argc, char** argv)
 
     StrategyPtr players[] = {gChampion, gOpponent, gOpponent, gOpponent};
     runGame(players);
+    gChampion->printCounters();
+    gOpponent->printCounters();
 
     return 0;
 }
@@ -0,0 +1,283 @@
+#include "lib/combinatorics.h"
+#include "lib/CompactFeatures.h"
+#include "lib/Deal.h"
+#include "lib/Distribution.h"
+#include "lib/DoubleDummySolver.h"
+#include "lib/EndgameDoubleDummy.h"
+#include "lib/EndgameSolver.h"
+#include "lib/FastRollout.h"
+#include "lib/GameState.h"
+#include "lib/KnowableState.h"
+#include "lib/PackedGameState.h"
+#include "lib/PackedKnowableState.h"
+#include "lib/random.h"
+#include "lib/timer.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+// Microbenchmarks for the counting that every sampled deal and every ExpectedDistribution() depends on.
+// Each benchmark compares the compile time tables of combinatorics.h with the run time computation
+// that they replaced.
+
+static uint128_t runtimeCombinations128(unsigned n, unsigned k)
+{
+  // combinations128() before it used the table: n!/(n-k)! / k!, computed with 128-bit multiplies and a divide.
+  const unsigned U = std::max(k, n-k);
+  const unsigned L = std::min(k, n-k);
+
+  uint128_t numer = 1;
+  for (unsigned N=n; N>U; --N)
+    numer = numer * N;
+
+  uint128_t denom = 1;
+  for (unsigned N=L; N>1; --N)
+    denom = denom * N;
+
+  return numer/denom;
+}
+
+static uint128_t runtimePossibleDeals(const unsigned capacities[4])
+{
+  uint128_t result = 1;
+  unsigned D = capacities[0] + capacities[1] + capacities[2] + capacities[3];
+  for (int i=0; i<4; i++) {
+    result *= runtimeCombinations128(D, capacities[i]);
+    D -= capacities[i];
+  }
+  return result;
+}
+
+struct Capacities
+{
+  unsigned c[4];
+};
+
+static std::vector<KnowableState> randomKnowableStates(unsigned numGames)
+{
+  // Every decision of randomly played games, so that the states cover all stages of a game.
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  std::vector<KnowableState> result;
+  for (unsigned game=0; game<numGames; ++game) {
+    GameState state;
+    while (!state.Done()) {
+      result.emplace_back(state);
+      state.PlayCard(result.back().LegalPlays().aCardAtRandom(rng));
+    }
+  }
+  return result;
+}
+
+static std::vector<Capacities> randomCapacities(unsigned count)
+{
+  // Hand capacities as they occur in a game: each player has 0..13 unknown cards.
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  std::vector<Capacities> result(count);
+  for (Capacities& caps : result)
+    for (int p=0; p<4; ++p)
+      caps.c[p] = unsigned(rng.range64(kCardsPerHand + 1));
+  return result;
+}
+
+template <typename Function>
+static void report(const char* name, unsigned count, Function function)
+{
+  uint128_t sum = 0;
+  const double start = now();
+  for (unsigned i=0; i<count; ++i)
+    sum += function(i);
+  const double elapsed = now() - start;
+  printf("%-28s %8.1f ns  (%s)\n", name, 1e9 * elapsed / count, asHexString(sum).c_str());
+}
+
+int main(int argc, char *argv[])
+{
+  const unsigned kCount = 1000000;
+  const std::vector<Capacities> caps = randomCapacities(kCount);
+
+  printf("Binomial coefficients C(n, k), n <= 52, k <= 13:\n");
+  report("  run time", kCount, [&](unsigned i) {
+    const Capacities& c = caps[i];
+    return runtimeCombinations128(c.c[0] + c.c[1] + c.c[2] + c.c[3], c.c[0]);
+  });
+  report("  combinations128 table", kCount, [&](unsigned i) {
+    const Capacities& c = caps[i];
+    return combinations128(c.c[0] + c.c[1] + c.c[2] + c.c[3], c.c[0]);
+  });
+
+  printf("Possible deals to four hands:\n");
+  report("  run time", kCount, [&](unsigned i) { return runtimePossibleDeals(caps[i].c); });
+  report("  multinomial128 table", kCount, [&](unsigned i) { return multinomial128(caps[i].c); });
+
+  printf("Distribution::DistributeRemaining, 39 unknown cards:\n");
+  CardHands hands;
+  for (int p=0; p<3; ++p)
+    hands[p].PrepForDeal(kCardsPerHand);
+  hands[3].PrepForDeal(0);
+  const CardDeck unknowns(((uint64_t(1) << 39) - 1) << 13, kEmpty);
+  const uint128_t possibles = PossibleDealUnknownsToHands(unknowns, hands);
+  Distribution distribution;
+  report("  DistributeRemaining", kCount / 10, [&](unsigned i) {
+    distribution.DistributeRemaining(unknowns, possibles, hands);
+    return uint128_t(i);
+  });
+
+  printf("Distribution arithmetic, 39 unknown cards:\n");
+  Distribution narrow;
+  narrow.DistributeRemainingToPlayer(unknowns, 0, 1000000);
+  Distribution wide;
+  wide.DistributeRemaining(unknowns, possibles, hands);
+  Distribution sum;
+  report("  += counts < 2^64", kCount / 10, [&](unsigned i) {
+    sum += narrow;
+    return uint128_t(i);
+  });
+  report("  += counts >= 2^64", kCount / 10, [&](unsigned i) {
+    sum += wide;
+    return uint128_t(i);
+  });
+  float probs[kCardsPerDeck][kNumPlayers];
+  report("  AsProbabilities", kCount / 10, [&](unsigned i) {
+    wide.AsProbabilities(probs);
+    return uint128_t(probs[13][0] > 0.5);
+  });
+
+  printf("Card location probabilities of a knowable state:\n");
+  const std::vector<KnowableState> states = randomKnowableStates(200);
+  const unsigned kNumStates = unsigned(states.size());
+  float prob[kCardsPerDeck][kNumPlayers];
+  report("  uniform AsProbabilities", kNumStates, [&](unsigned i) {
+    states[i].AsProbabilities(prob);
+    return uint128_t(prob[0][0] > 0.5);
+  });
+  report("  exact, analyzer cached", kNumStates, [&](unsigned i) {
+    states[i].ExactProbabilities(prob);
+    return uint128_t(prob[0][0] > 0.5);
+  });
+  report("  exact, analyzer built", kNumStates, [&](unsigned i) {
+    ClearAnalyzerCache();
+    states[i].ExactProbabilities(prob);
+    return uint128_t(prob[0][0] > 0.5);
+  });
+  report("  ExpectedDistribution", kNumStates, [&](unsigned i) {
+    const KnowableState& state = states[i];
+    const PossibilityAnalyzerPtr analyzer = state.Analyze();
+    Distribution distribution;
+    CardHands hands;
+    state.PrepareHands(hands);
+    analyzer->ExpectedDistribution(distribution, hands);
+    distribution.DistributeRemainingToPlayer(state.CurrentPlayersHand(), state.CurrentPlayer(), analyzer->Possibilities());
+    distribution.AsProbabilities(prob);
+    return uint128_t(prob[0][0] > 0.5);
+  });
+
+  printf("Features of a knowable state, as stored in training data:\n");
+  std::vector<float> rows(kNumStates * KnowableState::kNumFeatures);
+  std::vector<CompactFeatures> compact(kNumStates);
+  for (unsigned i=0; i<kNumStates; ++i) {
+    states[i].EncodeFeatures(&rows[i * KnowableState::kNumFeatures]);
+    compact[i] = CompactFeatures(&rows[i * KnowableState::kNumFeatures]);
+  }
+  std::vector<PackedKnowableState> packedStates;
+  for (const KnowableState& state : states)
+    packedStates.emplace_back(state);
+  printf("  bytes per state: %zu as floats, %zu compact, %zu packed state\n"
+        , KnowableState::kNumFeatures * sizeof(float), sizeof(CompactFeatures), sizeof(PackedKnowableState));
+  float features[KnowableState::kNumFeatures];
+  report("  EncodeFeatures", kNumStates, [&](unsigned i) {
+    states[i].EncodeFeatures(features);
+    return uint128_t(features[i % KnowableState::kNumFeatures] > 0.5);
+  });
+  report("  EncodeFeatures from packed", kNumStates, [&](unsigned i) {
+    KnowableState(packedStates[i]).EncodeFeatures(features);
+    return uint128_t(features[i % KnowableState::kNumFeatures] > 0.5);
+  });
+  report("  copy of the floats", kNumStates, [&](unsigned i) {
+    std::copy_n(&rows[i * KnowableState::kNumFeatures], KnowableState::kNumFeatures, features);
+    return uint128_t(features[i % KnowableState::kNumFeatures] > 0.5);
+  });
+  report("  CompactFeatures encode", kNumStates, [&](unsigned i) {
+    const CompactFeatures encoded(&rows[i * KnowableState::kNumFeatures]);
+    return uint128_t(encoded.mFlags[i % kCardsPerDeck]);
+  });
+  report("  CompactFeatures decode", kNumStates, [&](unsigned i) {
+    compact[i].Decode(features);
+    return uint128_t(features[i % KnowableState::kNumFeatures] > 0.5);
+  });
+
+  printf("Copying a game state for each legal play:\n");
+  std::vector<GameState> games;
+  for (unsigned game=0; game<200; ++game) {
+    GameState state;
+    while (!state.Done()) {
+      games.push_back(state);
+      state.PlayCard(state.LegalPlays().aCardAtRandom(RandomGenerator::ThreadSpecific()));
+    }
+  }
+  std::vector<PackedGameState> packedGames(games.begin(), games.end());
+  const unsigned kNumGames = unsigned(games.size());
+  printf("  sizeof(GameState) %zu, sizeof(PackedGameState) %zu\n", sizeof(GameState), sizeof(PackedGameState));
+  report("  GameState copy", kNumGames, [&](unsigned i) {
+    const GameState copy(games[i]);
+    return uint128_t(copy.PointsPlayed());
+  });
+  report("  PackedGameState copy", kNumGames, [&](unsigned i) {
+    const PackedGameState copy(packedGames[i]);
+    return uint128_t(copy.mNextPlay);
+  });
+  report("  GameState from packed", kNumGames, [&](unsigned i) {
+    const GameState copy(packedGames[i]);
+    return uint128_t(copy.PointsPlayed());
+  });
+  report("  FastRollout from GameState", kNumGames, [&](unsigned i) {
+    const FastRollout fast(games[i]);
+    return uint128_t(fast.CurrentPlayer());
+  });
+  report("  FastRollout from packed", kNumGames, [&](unsigned i) {
+    const FastRollout fast(packedGames[i]);
+    return uint128_t(fast.CurrentPlayer());
+  });
+
+  printf("Playing out the last tricks of a game:\n");
+  for (unsigned numTricks=2; numTricks<=4; ++numTricks) {
+    std::vector<FastRollout> endgames;
+    for (const GameState& state : games) {
+      if (state.PlayNumber() == kCardsPerDeck - 4*numTricks && state.PointsPlayed() != kMaxPointsPerHand)
+        endgames.emplace_back(state);
+    }
+    const unsigned kNumEndgames = unsigned(endgames.size());
+    char name[64];
+    snprintf(name, sizeof(name), "  %u tricks, random", numTricks);
+    report(name, kNumEndgames, [&](unsigned i) {
+      FastRollout game(endgames[i]);
+      return uint128_t(game.PlayOutRandomly(RandomGenerator::ThreadSpecific()).PointsTaken(0));
+    });
+    EndgameSolver solver;
+    snprintf(name, sizeof(name), "  %u tricks, solved", numTricks);
+    report(name, kNumEndgames, [&](unsigned i) { return uint128_t(solver.Solve(endgames[i]).PointsTaken(0)); });
+    snprintf(name, sizeof(name), "  %u tricks, solved again", numTricks);
+    report(name, kNumEndgames, [&](unsigned i) { return uint128_t(solver.Solve(endgames[i]).PointsTaken(0)); });
+  }
+
+  printf("Solving the rest of a game double dummy:\n");
+  for (unsigned numTricks=4; numTricks<=EndgameDoubleDummy::kMaxSolvedTricks; ++numTricks) {
+    std::vector<FastRollout> positions;
+    std::vector<unsigned> players;
+    for (const GameState& state : games) {
+      if (state.PlayNumber() == kCardsPerDeck - 4*numTricks && state.PointsPlayed() != kMaxPointsPerHand) {
+        positions.emplace_back(state);
+        players.push_back(state.CurrentPlayer());
+      }
+    }
+    DoubleDummySolver solver;
+    char name[64];
+    snprintf(name, sizeof(name), "  %u tricks", numTricks);
+    report(name, unsigned(positions.size()), [&](unsigned i) {
+      return uint128_t(2 * solver.Score(positions[i], players[i]) + 39);
+    });
+    printf("  %-28s %8.0f\n", "  positions per solve", double(solver.NodesSearched()) / positions.size());
+  }
+
+  return 0;
+}
@@ -4,6 +4,7 @@
 #include "lib/PossibilityAnalyzer.h"
 #include "lib/RandomStrategy.h"
 #include "lib/MonteCarlo.h"
+#include "lib/TaskExecutor.h"
 
 #include <iostream>
 #include <fstream>
@@ -28,7 +29,7 @@ int run()
   StrategyPtr monte(new MonteCarlo(intuition, kNumAlternates, parallel, annotator));
 
   GameState state;
-  PossibilityAnalyzer* analyzer = 0;
+  PossibilityAnalyzerPtr analyzer;
 
   const uint128_t kThresh = 10000;
 
@@ -62,13 +63,14 @@ int run()
 
   Distribution distribution;
 
-  for (uint128_t possibility=0; possibility<possibilities; ++possibility) {
-    KnowableState knowableState(state);
+  const KnowableState knowableState(state);
+  Distribution::ParallelAccumulate(distribution, unsigned(possibilities), TaskExecutor::Shared().MaxSlots()
+                                 , [&](unsigned possibility, Distribution& slotDistribution) {
     CardHands hands;
     knowableState.PrepareHands(hands);
     analyzer->ActualizePossibility(possibility, hands);
-    distribution.CountOccurrences(hands);
-  }
+    slotDistribution.CountOccurrences(hands);
+  });
 
 
   if (analyzedDistribution == distribution)
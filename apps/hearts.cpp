@@ -11,8 +11,10 @@
 
 #include <signal.h>
 #include <stdlib.h>
+#include <string.h>
 
 std::string gIntuitionName;
+WriteTrainingDataSets::Layout gLayout = WriteTrainingDataSets::kWithFeatures;
 
 volatile sig_atomic_t gRunning = 1;
 void trapCtrlC(int sig)
@@ -33,7 +35,7 @@ float run_iterations_task(int kIterationsPerTask, StrategyPtr opponent)
 
     // The `player` uses monte carlo and will generate data
     // AnnotatorPtr annotator(new WriteDataAnnotator());
-    AnnotatorPtr annotator(new WriteTrainingDataSets());
+    AnnotatorPtr annotator(new WriteTrainingDataSets("data/", WriteTrainingDataSets::kDefaultMaxShardBytes, gLayout));
     StrategyPtr player(new MonteCarlo(opponent, kNumAlternates, false, annotator));
 
     StrategyPtr players[4];
@@ -95,7 +97,12 @@ int main(int argc, char** argv)
 
     const bool kUseDNN = argc >= 3;
     gIntuitionName = kUseDNN ? argv[2] : "random";
-    StrategyPtr intuition = makePlayer(gIntuitionName);
+    // With --state-only the records hold the packed states and outputs, without the features.
+    if (argc >= 4 && strcmp(argv[3], "--state-only") == 0)
+        gLayout = WriteTrainingDataSets::kStateOnly;
+    // The intuition is shared by all kConcurrency tasks, so let their model predictions be batched together.
+    const bool kPooled = true;
+    StrategyPtr intuition = loadIntuition(gIntuitionName, kPooled);
 
     int remainingIterations = kTotalIterations;
 
@@ -130,6 +137,7 @@ int main(int argc, char** argv)
         printf("Total Elapsed time: %4.2f, Avg per iteration: %4.3f\n", elapsed, avgTimePerRun);
         printf("Estimated time remaining: %4.2f %4.2fh\n\n", estimateRemaining, estimateRemaining / 3600.0);
     }
+    intuition->printCounters();
 
     return 0;
 }
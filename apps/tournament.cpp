@@ -24,6 +24,7 @@ StrategyPtr gChampion;
 
 bool gSaveMoonDeals = true;
 bool gQuiet = false;
+unsigned gNumJobs = 1;
 
 const char* PlayerName(PlayerRole role) { return role == kChampion ? "Champion" : "Opponent"; }
 
@@ -36,6 +37,10 @@ void usage()
         "    -o,--opponent <strategy>   the strategy to use for the `opponent` (default:random)",
         "    -c,--champion <strategy>   the strategy to use for the `champion` (default: simple)",
         "    -d,--deals <dealIndexFile> a file containing deal indexes to play from (default: choose deals at random)",
+        "    -j,--jobs <int>            the number of games to play in parallel (default:1)",
+        "  A strategy is <intuition>[#<rollouts>][:threads=<n>][:adaptive][:crn][:endgame=<tricks>], e.g. random#1000:threads=8",
+        "  The intuition `endgame-dds` plays perfect-information Monte Carlo once 6 tricks remain, and until then"
+        " chooses by random rollouts, e.g. endgame-dds#20 solves 20 sampled deals per play",
         "    -h,--help                  print this message", 0};
     for (int i = 0; lines[i] != 0; ++i)
         printf("%s\n", lines[i]);
@@ -85,14 +90,14 @@ void parseArgs(int argc, char** argv)
 {
     const struct option longopts[] = {{"model", required_argument, NULL, 'm'}, {"games", required_argument, NULL, 'g'},
         {"opponent", required_argument, NULL, 'o'}, {"champion", required_argument, NULL, 'c'},
-        {"deals", required_argument, NULL, 'd'}, {"quiet", no_argument, NULL, 'q'}, {"help", no_argument, NULL, 'h'},
-        {NULL, 0, NULL, 0}};
+        {"deals", required_argument, NULL, 'd'}, {"quiet", no_argument, NULL, 'q'},
+        {"jobs", required_argument, NULL, 'j'}, {"help", no_argument, NULL, 'h'}, {NULL, 0, NULL, 0}};
 
     while (true)
     {
 
         int longindex = 0;
-        int ch = getopt_long(argc, argv, "m:g:o:c:d:qh", longopts, &longindex);
+        int ch = getopt_long(argc, argv, "m:g:o:c:d:j:qh", longopts, &longindex);
         if (ch == -1)
         {
             break;
@@ -121,6 +126,11 @@ void parseArgs(int argc, char** argv)
             gSaveMoonDeals = false;
             break;
         }
+        case 'j':
+        {
+            gNumJobs = std::max(1, atoi(optarg));
+            break;
+        }
         case 'q':
         {
             gQuiet = true;
@@ -149,9 +159,11 @@ int main(int argc, char** argv)
     gChampion = makePlayer(gChampionStr);
     gOpponent = makePlayer(gOpponentStr);
 
-    Tournament tournament(gChampion, gOpponent, gQuiet, gSaveMoonDeals);
+    Tournament tournament(gChampion, gOpponent, gQuiet, gSaveMoonDeals, gNumJobs);
 
     tournament.runOneTournament(gNumMatches, gDeals);
+    gChampion->printCounters();
+    gOpponent->printCounters();
 
     return 0;
 }
@@ -3,7 +3,6 @@
 #include <unistd.h>
 
 #include "lib/Deal.h"
-#include "lib/DnnModelIntuition.h"
 #include "lib/GameState.h"
 #include "lib/MonteCarlo.h"
 #include "lib/RandomStrategy.h"
@@ -13,24 +12,6 @@
 #include "lib/random.h"
 #include "lib/timer.h"
 
-#include <tensorflow/cc/saved_model/loader.h>
-#include <tensorflow/cc/saved_model/tag_constants.h>
-
-tensorflow::SavedModelBundle gModel;
-
-void loadModel(const char* modelDirPath)
-{
-    using namespace tensorflow;
-    SessionOptions session_options;
-    RunOptions run_options;
-    auto status = LoadSavedModel(session_options, run_options, modelDirPath, {kSavedModelTagServe}, &gModel);
-    if (!status.ok())
-    {
-        std::cerr << "Failed: " << status;
-        exit(1);
-    }
-}
-
 RandomGenerator rng;
 
 void run(uint128_t dealIndex, StrategyPtr player, StrategyPtr opponent)
@@ -65,8 +46,6 @@ int main(int argc, char** argv)
 
     AnnotatorPtr annotator(new WriteDataAnnotator(true));
 
-    const bool parallel = true;
-
     StrategyPtr player;
     StrategyPtr opponent;
     if (argc > 2)
@@ -82,6 +61,8 @@ int main(int argc, char** argv)
     }
 
     run(dealIndex, player, opponent);
+    player->printCounters();
+    opponent->printCounters();
 
     return 0;
 }
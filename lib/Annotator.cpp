@@ -10,7 +10,7 @@ Annotator::Annotator()
 {}
 
 void Annotator::On_DnnMonteCarlo_choosePlay(const KnowableState& state
-                                  , PossibilityAnalyzer* analyzer
+                                  , const PossibilityAnalyzer* analyzer
                                   , const float expectedScore[13], const float moonProb[13][3])
 {
   assert(false);
@@ -21,7 +21,7 @@ void Annotator::OnGameStateBeforePlay(const GameState& state)
   assert(false);
 }
 
-void Annotator::OnWriteData(const KnowableState& state, PossibilityAnalyzer* analyzer, const float expectedScore[13]
+void Annotator::OnWriteData(const KnowableState& state, const PossibilityAnalyzer* analyzer, const float expectedScore[13]
                           , const float moonProb[13][3], const float winsTrickProb[13])
 {
   assert(false);
@@ -0,0 +1,52 @@
+// lib/Arena.cpp
+
+#include "lib/Arena.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstddef>
+#include <stdint.h>
+
+Arena::~Arena()
+{
+  for (char* block : mBlocks)
+    ::operator delete(block);
+}
+
+Arena::Arena()
+: mBlocks()
+, mNext(0)
+, mEnd(0)
+, mBytesReserved(0)
+{
+}
+
+void* Arena::Allocate(size_t size, size_t alignment)
+{
+  // Blocks come from operator new, so they are aligned for any fundamental type.
+  assert(alignment <= alignof(std::max_align_t));
+
+  char* p = (char*) ((uintptr_t(mNext) + alignment - 1) & ~uintptr_t(alignment - 1));
+  if (mNext == 0 || p + size > mEnd)
+  {
+    // An allocation larger than a block gets a block of its own.
+    const size_t blockSize = std::max(size, kBlockSize);
+    char* block = (char*) ::operator new(blockSize);
+    mBlocks.push_back(block);
+    mBytesReserved += blockSize;
+    p = block;
+    mEnd = block + blockSize;
+  }
+  mNext = p + size;
+  return p;
+}
+
+const ArenaPtr& Arena::ThreadSpecific()
+{
+  // Every analyzer node allocation looks up the arena, so this uses thread_local rather than the locked
+  // lookup of dlib::thread_specific_data.
+  static thread_local ArenaPtr arena;
+  if (!arena || arena->BytesReserved() >= kMaxThreadArenaSize)
+    arena = std::make_shared<Arena>();
+  return arena;
+}
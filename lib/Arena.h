@@ -0,0 +1,76 @@
+// lib/Arena.h
+
+#pragma once
+
+#include <memory>
+#include <stddef.h>
+#include <vector>
+
+class Arena;
+
+typedef std::shared_ptr<Arena> ArenaPtr;
+
+// Arena is a bump allocator for small objects that are built by one thread and released together.
+//
+// Memory is taken from the system in large blocks and handed out by advancing a pointer, so objects built
+// one after another are contiguous in memory, and building them takes no locks. Freeing an object does
+// nothing: all of the blocks are freed when the arena itself is destroyed. With ArenaAllocator and
+// std::allocate_shared(), each object holds a reference to its arena, so the arena lives exactly as long as
+// the last object allocated from it.
+//
+// An arena is not thread safe. Only the thread that allocates from an arena may allocate from it, but the
+// objects may be shared with and released by any thread.
+class Arena
+{
+public:
+  static const size_t kBlockSize = 64 * 1024;
+
+  static const size_t kMaxThreadArenaSize = 1024 * 1024;
+
+  ~Arena();
+
+  Arena();
+
+  void* Allocate(size_t size, size_t alignment);
+
+  size_t BytesReserved() const { return mBytesReserved; }
+    // The total size of the blocks taken from the system.
+
+  static const ArenaPtr& ThreadSpecific();
+    // The calling thread's current arena. Once it has reserved kMaxThreadArenaSize bytes the thread starts a
+    // new arena, and the old one is freed when the objects allocated from it have been released.
+
+private:
+  std::vector<char*> mBlocks;
+  char* mNext;
+  char* mEnd;
+  size_t mBytesReserved;
+};
+
+// A standard allocator that allocates from an arena, and keeps the arena alive.
+template <typename T>
+class ArenaAllocator
+{
+public:
+  typedef T value_type;
+
+  ArenaAllocator(const ArenaPtr& arena) : mArena(arena) {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : mArena(other.mArena) {}
+
+  T* allocate(size_t n) { return static_cast<T*>(mArena->Allocate(n * sizeof(T), alignof(T))); }
+
+  void deallocate(T* p, size_t n) {}
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const { return mArena == other.mArena; }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const { return mArena != other.mArena; }
+
+private:
+  template <typename U> friend class ArenaAllocator;
+
+  ArenaPtr mArena;
+};
@@ -23,3 +23,14 @@ inline uint64_t IsolateGreatestBit(uint64_t x) {
 inline int CountBits(uint64_t bits) {
   return _popcnt64(bits);
 }
+
+// Returns the bit index of the n-th (counting from zero) least set bit. n must be less than CountBits(x).
+inline int NthSetBitIndex(uint64_t x, unsigned n) {
+#ifdef __BMI2__
+  return LeastSetBitIndex(_pdep_u64(1UL << n, x));
+#else
+  for (; n > 0; --n)
+    x &= x - 1;
+  return LeastSetBitIndex(x);
+#endif
+}
@@ -0,0 +1,92 @@
+// lib/BlockWriter.cpp
+
+#include "lib/BlockWriter.h"
+#include "lib/IoThread.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <system_error>
+#include <unistd.h>
+
+BlockWriter::~BlockWriter()
+{
+  if (!mBlock.empty())
+    WriteBlock();
+  mSpareBlockFree.Acquire();
+
+  const int file = mFile;
+  IoThread::Shared().Post([file]() { ::close(file); });
+}
+
+BlockWriter::BlockWriter(const std::string& path)
+: mFile(::open(path.c_str(), O_CREAT|O_WRONLY|O_TRUNC, 0644))
+, mSpareBlockFree(1)
+, mBlockOffset(0)
+{
+  if (mFile == -1) {
+    throw std::system_error(std::error_code(), "Error opening file for write access" );
+  }
+  mBlock.reserve(kBlockBytes);
+  mSpareBlock.reserve(kBlockBytes);
+}
+
+void BlockWriter::Write(int file, const void* buffer, size_t numBytes, off_t offset)
+{
+  const char* bytes = static_cast<const char*>(buffer);
+  while (numBytes > 0) {
+    const ssize_t actual = ::pwrite(file, bytes, numBytes, offset);
+    if (actual <= 0) {
+      fprintf(stderr, "Failed to write file: %s\n", strerror(errno));
+      exit(1);
+    }
+    bytes += actual;
+    numBytes -= actual;
+    offset += actual;
+  }
+}
+
+void BlockWriter::Append(const void* buffer, size_t numBytes)
+{
+  const char* bytes = static_cast<const char*>(buffer);
+  mBlock.insert(mBlock.end(), bytes, bytes + numBytes);
+  if (mBlock.size() >= kBlockBytes)
+    WriteBlock();
+}
+
+char* BlockWriter::Reserve(size_t numBytes)
+{
+  // The block is written before it would have to grow, so that the space stays where it is until the next call.
+  if (!mBlock.empty() && mBlock.size() + numBytes > kBlockBytes)
+    WriteBlock();
+  const size_t offset = mBlock.size();
+  mBlock.resize(offset + numBytes);
+  return mBlock.data() + offset;
+}
+
+void BlockWriter::WriteAt(off_t offset, const std::string& bytes)
+{
+  assert(offset + off_t(bytes.size()) <= Size());
+  if (!mBlock.empty())
+    WriteBlock();
+  const int file = mFile;
+  IoThread::Shared().Post([file, offset, bytes]() { Write(file, bytes.data(), bytes.size(), offset); });
+}
+
+void BlockWriter::WriteBlock()
+{
+  // Wait for the IoThread to finish with the spare block, then swap the blocks and have it write the full one.
+  mSpareBlockFree.Acquire();
+  std::swap(mBlock, mSpareBlock);
+  mBlock.clear();
+
+  const off_t offset = mBlockOffset;
+  mBlockOffset += mSpareBlock.size();
+  IoThread::Shared().Post([this, offset]() {
+    Write(mFile, mSpareBlock.data(), mSpareBlock.size(), offset);
+    mSpareBlockFree.Release();
+  });
+}
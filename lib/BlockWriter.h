@@ -0,0 +1,60 @@
+// lib/BlockWriter.h
+
+#pragma once
+
+#include "lib/Semaphore.h"
+
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+// BlockWriter appends to a file through the IoThread. The bytes are appended to an in-memory block, and each full
+// block is written by the IoThread in one call while the writer fills a second block. Appending only waits when
+// the IoThread is a whole block behind.
+//
+// A BlockWriter should only be used by one thread.
+class BlockWriter
+{
+public:
+  ~BlockWriter();
+    // Writes the last block, then closes the file. Those writes are left to the IoThread: the file is complete
+    // once IoThread::Shared().Wait() returns.
+
+  BlockWriter(const std::string& path);
+    // Creates or truncates the file at path. Throws std::system_error if it can't.
+
+  void Append(const void* buffer, size_t numBytes);
+
+  char* Reserve(size_t numBytes);
+    // Appends numBytes of zeros, returning where they are so that the caller can fill them in place.
+    // The space is only valid until the next call.
+
+  void WriteAt(off_t offset, const std::string& bytes);
+    // Overwrites bytes already appended (such as a header), after the writes of everything appended so far.
+
+  off_t Size() const { return mBlockOffset + mBlock.size(); }
+    // The number of bytes appended so far.
+
+  static constexpr size_t kBlockBytes = 1 << 20;
+    // The size of the blocks written by the IoThread.
+
+private:
+  void WriteBlock();
+
+  static void Write(int file, const void* buffer, size_t numBytes, off_t offset);
+    // Called on the IoThread, where there is no caller to throw to, so a failure exits the process.
+
+private:
+  const int mFile;
+
+  std::vector<char> mBlock;
+    // The block being filled.
+
+  std::vector<char> mSpareBlock;
+    // The block being written by the IoThread, if mSpareBlockFree is not available.
+
+  Semaphore mSpareBlockFree;
+
+  off_t mBlockOffset;
+    // The offset in the file of mBlock.
+};
@@ -19,15 +19,7 @@ Card CardArray::NthCard(unsigned n) const
 {
   assert(n < Size());
   assert(mCardBits != 0);
-  if (n == 0) {
-    return FirstCard();
-  }
-  iterator it(*this);
-  while (n>0) {
-    it.next();
-    --n;
-  }
-  return it.next();
+  return NthSetBitIndex(mCardBits, n);
 }
 
 
@@ -157,6 +157,8 @@ public:
 
   static inline uint64_t SuitMask(Suit suit) { return ((1ul<<13) - 1) << (suit*13); }
 
+  uint64_t Bits() const { return mCardBits; }
+
   unsigned CountCardsWithMask(uint64_t mask) const { return CountBits(mCardBits & mask); }
 
   unsigned CountCardsWithSuit(Suit suit) const { return CountCardsWithMask(SuitMask(suit)); }
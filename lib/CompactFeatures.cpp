@@ -0,0 +1,122 @@
+// lib/CompactFeatures.cpp
+
+#include "lib/CompactFeatures.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+// GCC vector extensions, as in MultiRollout. One card's ten features fit in one vector of 16 floats, so Decode()
+// builds each card's features in a vector and stores them all at once. With -march=native these are one AVX-512
+// register, or two AVX2 registers.
+const unsigned kLanes = 16;
+typedef int32_t IntLanes __attribute__((vector_size(kLanes * sizeof(int32_t))));
+typedef float FloatLanes __attribute__((vector_size(kLanes * sizeof(float))));
+
+// The value of eCardPoints for a heart, as in KnowableState::EncodeFeatures(). The queen of spades is fixed up.
+const float kHeartPoints = float(1) / 26.0;
+
+// The flag of each feature column, and the value of the column when its flag is set.
+// The three probabilities of other players are filled in separately.
+const IntLanes kColumnFlags = {
+  CompactFeatures::kLegalPlay, CompactFeatures::kHeldByPlayer, 0, 0, 0, CompactFeatures::kPoints,
+  CompactFeatures::kOnTable, CompactFeatures::kHighCardInTrick, CompactFeatures::kPlayerNotRuledOutForMoon,
+  CompactFeatures::kOtherNotRuledOutForMoon,
+};
+const FloatLanes kColumnValues = {1.0f, 1.0f, 0.0f, 0.0f, 0.0f, kHeartPoints, 1.0f, 1.0f, 1.0f, 1.0f};
+
+struct ProbabilityTable
+{
+  ProbabilityTable() {
+    for (unsigned q=0; q<=CompactFeatures::kProbabilityScale; ++q)
+      mValue[q] = float(q) / float(CompactFeatures::kProbabilityScale);
+  }
+  float mValue[CompactFeatures::kProbabilityScale + 1];
+};
+const ProbabilityTable kProbability;
+
+uint8_t Quantize(float probability)
+{
+  return uint8_t(probability * CompactFeatures::kProbabilityScale + 0.5f);
+}
+
+const float* Features(const float* row, Card card) { return row + card*KnowableState::kNumFeaturesPerCard; }
+
+}  // namespace
+
+CompactFeatures::CompactFeatures(const float* row)
+{
+  for (Card card=0; card<kCardsPerDeck; ++card) {
+    const float* features = Features(row, card);
+    uint8_t flags = 0;
+    if (features[eLegalPlay] != 0.0f)
+      flags |= kLegalPlay;
+    if (features[eCardProbPlayer0] != 0.0f)
+      flags |= kHeldByPlayer;
+    if (features[eCardPoints] != 0.0f)
+      flags |= kPoints;
+    if (features[eCardOnTable] != 0.0f)
+      flags |= kOnTable;
+    if (features[eCardIsHighCardInTrick] != 0.0f)
+      flags |= kHighCardInTrick;
+    if (features[ePlayerNotRuledOutForMoon] != 0.0f)
+      flags |= kPlayerNotRuledOutForMoon;
+    if (features[eOtherNotRuledOutForMoon] != 0.0f)
+      flags |= kOtherNotRuledOutForMoon;
+
+    const float* others = features + eCardProbPlayer1;
+    mProbability[card][0] = 0;
+    mProbability[card][1] = 0;
+    if (others[0] != 0.0f || others[1] != 0.0f || others[2] != 0.0f) {
+      // The rounding error of the first two players is left to the last one.
+      assert(fabsf(others[0] + others[1] + others[2] - 1.0f) < 1e-4);
+      flags |= kUnknown;
+      mProbability[card][0] = Quantize(others[0]);
+      mProbability[card][1] = std::min<unsigned>(Quantize(others[1]), kProbabilityScale - mProbability[card][0]);
+    }
+    mFlags[card] = flags;
+
+    assert(features[eLegalPlay] == 0.0f || features[eLegalPlay] == 1.0f);
+    assert(features[eCardProbPlayer0] == 0.0f || features[eCardProbPlayer0] == 1.0f);
+    assert(features[eCardPoints] == 0.0f || features[eCardPoints] == float(float(PointsFor(card)) / 26.0));
+  }
+}
+
+void CompactFeatures::Decode(float* row) const
+{
+  for (Card card=0; card<kCardsPerDeck; ++card) {
+    const IntLanes set = (mFlags[card] & kColumnFlags) != 0;
+    const FloatLanes features = (FloatLanes) (set & (IntLanes) kColumnValues);
+
+    // Each vector also covers the first columns of the next card, which the next card's vector overwrites.
+    // The last card's vector would run past the row.
+    float* out = row + card*KnowableState::kNumFeaturesPerCard;
+    if (card + 1 < kCardsPerDeck)
+      memcpy(out, &features, sizeof(features));
+    else
+      memcpy(out, &features, KnowableState::kNumFeaturesPerCard * sizeof(float));
+
+    // The probabilities are zero for cards that are not unknown, so only the last one needs the flag.
+    // Written without a branch, since the unknown cards are scattered through the deck.
+    const unsigned q0 = mProbability[card][0];
+    const unsigned q1 = mProbability[card][1];
+    const unsigned q2 = (kProbabilityScale - q0 - q1) & -unsigned((mFlags[card] & kUnknown) != 0);
+    out[eCardProbPlayer1] = kProbability.mValue[q0];
+    out[eCardProbPlayer2] = kProbability.mValue[q1];
+    out[eCardProbPlayer3] = kProbability.mValue[q2];
+  }
+
+  const Card queen = TheQueen();
+  if (mFlags[queen] & kPoints)
+    row[queen*KnowableState::kNumFeaturesPerCard + eCardPoints] = float(PointsFor(queen)) / 26.0;
+}
+
+FloatMatrix CompactFeatures::AsFloatMatrix() const
+{
+  FloatMatrix result(kCardsPerDeck, KnowableState::kNumFeaturesPerCard);
+  Decode(result.data());
+  return result;
+}
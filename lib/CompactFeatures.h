@@ -0,0 +1,51 @@
+// lib/CompactFeatures.h
+
+#pragma once
+
+#include "lib/KnowableState.h"
+
+#include <stdint.h>
+#include <type_traits>
+
+// CompactFeatures is the main input of one sample (KnowableState::kNumFeatures floats, 2080 bytes) in 156 bytes,
+// for training data. Six of the ten feature columns are flags, and the probabilities of the three other players sum
+// to one for each unknown card, so each card needs one byte of flags and two bytes of probabilities:
+//   - the flags hold eLegalPlay, eCardProbPlayer0 (the current player holds the card), whether the card is unknown,
+//     whether eCardPoints is set, eCardOnTable, eCardIsHighCardInTrick and the two moon columns.
+//   - the probabilities of the next two players are quantized to multiples of 1/240, and the last player's
+//     probability is the rest. Since 240 is a multiple of 2 and 3, the probabilities of AsProbabilities() decode to
+//     exactly the same floats. Those of ExactProbabilities() decode to within 1/240.
+// Decode() expands the features again with vector operations, one card per vector.
+struct CompactFeatures
+{
+  CompactFeatures() = default;
+
+  explicit CompactFeatures(const float* row);
+    // Encodes a row of features, as written by KnowableState::EncodeFeatures().
+
+  void Decode(float* row) const;
+    // Writes all kNumFeatures floats of the row, as EncodeFeatures() does.
+
+  FloatMatrix AsFloatMatrix() const;
+
+  enum Flags {
+    kLegalPlay = 1,
+    kHeldByPlayer = 2,
+    kUnknown = 4,
+    kPoints = 8,
+    kOnTable = 16,
+    kHighCardInTrick = 32,
+    kPlayerNotRuledOutForMoon = 64,
+    kOtherNotRuledOutForMoon = 128,
+  };
+
+  static const unsigned kProbabilityScale = 240;
+
+  uint8_t mFlags[kCardsPerDeck];
+  uint8_t mProbability[kCardsPerDeck][2];
+    // The quantized probabilities of the next two players holding each unknown card.
+};
+
+static_assert(sizeof(CompactFeatures) == 156, "CompactFeatures should be 156 bytes");
+static_assert(std::is_trivial<CompactFeatures>::value && std::is_standard_layout<CompactFeatures>::value
+            , "CompactFeatures should be a POD type");
@@ -46,6 +46,11 @@ uint128_t Deal::RandomDealIndex()
   return gRand.range128(kPossibleDistinguishableDeals);
 }
 
+uint128_t Deal::NumPossibleDeals()
+{
+  return kPossibleDistinguishableDeals;
+}
+
 void Deal::DealHands(uint128_t I)
 {
   DealUnknownsToHands(CardDeck(kFull, kCardsPerDeck), mHands, I);
@@ -63,22 +68,55 @@ void ValidateDealUnknowns(const CardDeck& unknowns, const CardHands& hands)
   assert(T == unknowns.Size());
 }
 
-uint128_t PossibleDealUnknownsToHands(const CardDeck& unknowns, const CardHands& hands)
+namespace {
+
+uint128_t PossibleDeals(const unsigned capacities[4], unsigned numUnknowns)
 {
-  ValidateDealUnknowns(unknowns, hands);
+  assert(capacities[0] + capacities[1] + capacities[2] + capacities[3] == numUnknowns);
+  return multinomial128(capacities);
+}
 
-  uint128_t result = 1;
+template <typename Count>
+void UnrankDeal(const CardDeck& unknowns, CardHands& hands, unsigned capacities[4], Count index, Count possibleDeals)
+{
+  // This code is adapted from http://www.rpbridge.net/7z68.htm
+  // K * capacities[i] must fit in a Count, which the caller ensures by choosing the narrowest Count for which
+  // possibleDeals * kCardsPerHand fits.
+  CardArray::iterator it(unknowns);
+  uint64_t dealt[4] = {0};
 
-  unsigned D = unknowns.Size();
-  for (int i=0; i<4; i++) {
-    unsigned H = hands[i].AvailableCapacity();
-//     printf("D:%u H:%u, i:%d\n", D, H, i);
-    assert(H <= D);
-    result *= combinations128(D, H);
-    D -= H;
+  Count K = possibleDeals;
+  for (unsigned C = unknowns.Size(); C>0; --C) {
+    const Card card = it.next();
+    Count X = 0;
+    for (int i=0; i<4; i++) {
+      index -= X;
+      X = (K * capacities[i]) / C;
+      if (index < X) {
+        dealt[i] |= uint64_t(1) << card;
+        --capacities[i];
+        break;
+      }
+    }
+    K = X;
   }
-  assert(D == 0);
-  return result;
+
+  for (int i=0; i<4; i++)
+    hands[i].Merge(CardDeck(dealt[i], kEmpty));
+}
+
+} // namespace
+
+uint128_t PossibleDealUnknownsToHands(const CardDeck& unknowns, const CardHands& hands)
+{
+#ifndef NDEBUG
+  ValidateDealUnknowns(unknowns, hands);
+#endif
+
+  unsigned capacities[4];
+  for (int i=0; i<4; i++)
+    capacities[i] = hands[i].AvailableCapacity();
+  return PossibleDeals(capacities, unknowns.Size());
 }
 
 void DealUnknownsToHands(const CardDeck& unknowns, CardHands& hands)
@@ -90,27 +128,23 @@ void DealUnknownsToHands(const CardDeck& unknowns, CardHands& hands)
 
 void DealUnknownsToHands(const CardDeck& unknowns, CardHands& hands, uint128_t index)
 {
+#ifndef NDEBUG
   ValidateDealUnknowns(unknowns, hands);
+#endif
 
-  // This code is adapted from http://www.rpbridge.net/7z68.htm
-  const uint128_t kPossibleDeals = PossibleDealUnknownsToHands(unknowns, hands);
+  unsigned capacities[4];
+  for (int i=0; i<4; i++)
+    capacities[i] = hands[i].AvailableCapacity();
+  const uint128_t kPossibleDeals = PossibleDeals(capacities, unknowns.Size());
   assert(index < kPossibleDeals);
 
-  CardArray::iterator it(unknowns);
-
-  uint128_t K = kPossibleDeals;
-  for (unsigned C = unknowns.Size(); C>0; --C) {
-    uint128_t X = 0;
-    for (int i=0; i<4; i++) {
-      index -= X;
-      X = (K * hands[i].AvailableCapacity()) / C;
-      if (index < X) {
-        hands[i].Insert(it.next());
-        break;
-      }
-    }
-    K = X;
-  }
+  // From mid game on, the counts fit in 32 or 64 bits, and the divisions are much cheaper than in 128 bits.
+  if (kPossibleDeals <= UINT32_MAX / kCardsPerHand)
+    UnrankDeal<uint32_t>(unknowns, hands, capacities, uint32_t(index), uint32_t(kPossibleDeals));
+  else if (kPossibleDeals <= UINT64_MAX / kCardsPerHand)
+    UnrankDeal<uint64_t>(unknowns, hands, capacities, uint64_t(index), uint64_t(kPossibleDeals));
+  else
+    UnrankDeal<uint128_t>(unknowns, hands, capacities, index, kPossibleDeals);
 }
 
 void Deal::printDeal() const
@@ -33,6 +33,9 @@ public:
   static uint128_t RandomDealIndex();
     // Generate a random bignum in the range [0, 52!/(13!^4))
 
+  static uint128_t NumPossibleDeals();
+    // 52!/(13!^4), one more than the greatest deal index.
+
   Card PeekAt(int p, int c) const { return mHands[p].NthCard(c); }
   Card PeekAt(int i) const { return PeekAt(i/13, i%13); }
     // For unit tests, peak at the card at a given card location
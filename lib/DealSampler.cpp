@@ -0,0 +1,170 @@
+// lib/DealSampler.cpp
+
+#include "lib/DealSampler.h"
+#include "lib/Bits.h"
+#include "lib/PossibilityAnalyzer.h"
+#include "lib/random.h"
+
+#include <assert.h>
+
+namespace {
+
+uint64_t RandomSubset(uint64_t cards, unsigned size, const RandomGenerator& rng)
+{
+  // Choose the smaller of the subset and its complement, one card at a time.
+  unsigned numCards = CountBits(cards);
+  assert(size <= numCards);
+  const bool complement = 2 * size > numCards;
+  unsigned numToChoose = complement ? numCards - size : size;
+
+  uint64_t chosen = 0;
+  uint64_t left = cards;
+  for (; numToChoose > 0; --numToChoose, --numCards)
+  {
+    const uint64_t card = uint64_t(1) << NthSetBitIndex(left, unsigned(rng.range64(numCards)));
+    chosen |= card;
+    left &= ~card;
+  }
+  return complement ? left : chosen;
+}
+
+} // namespace
+
+DealSampler::DealSampler(const PossibilityAnalyzer& analyzer)
+: mStages()
+, mWays()
+, mRoot(0)
+, mLowered()
+{
+  assert(analyzer.Possibilities() > 0);
+  mRoot = StageFor(analyzer);
+  mLowered.clear();
+}
+
+unsigned DealSampler::StageFor(const PossibilityAnalyzer& analyzer)
+{
+  auto it = mLowered.find(&analyzer);
+  if (it != mLowered.end())
+    return it->second;
+  const unsigned stage = analyzer.AddToSampler(*this);
+  mLowered.emplace(&analyzer, stage);
+  return stage;
+}
+
+unsigned DealSampler::AddStage(const Stage& stage)
+{
+  mStages.push_back(stage);
+  return unsigned(mStages.size() - 1);
+}
+
+unsigned DealSampler::AddGiveSuit(unsigned opponent, const CardDeck& cards, const PossibilityAnalyzer& next)
+{
+  Stage stage = {kGiveSuit};
+  stage.mPlayers[0] = uint8_t(opponent);
+  stage.mCards = cards.Bits();
+  stage.mNext = StageFor(next);
+  return AddStage(stage);
+}
+
+unsigned DealSampler::AddSplitSuit(unsigned a, unsigned b, const CardDeck& cards, unsigned numFirst
+                                 , const PossibilityAnalyzer& next)
+{
+  Stage stage = {kSplitSuit};
+  stage.mPlayers[0] = uint8_t(a);
+  stage.mPlayers[1] = uint8_t(b);
+  stage.mNumFirst = uint8_t(numFirst);
+  stage.mCards = cards.Bits();
+  stage.mNext = StageFor(next);
+  return AddStage(stage);
+}
+
+unsigned DealSampler::AddChooseWay(const std::vector<const PossibilityAnalyzer*>& ways)
+{
+  // Lower the ways first, since lowering them adds their own ways to mWays.
+  std::vector<Way> chooseFrom;
+  uint128_t upperBound = 0;
+  for (const PossibilityAnalyzer* way : ways)
+  {
+    if (way->Possibilities() == 0)
+      continue;
+    upperBound += way->Possibilities();
+    chooseFrom.push_back(Way{upperBound, StageFor(*way)});
+  }
+  assert(!chooseFrom.empty());
+
+  Stage stage = {kChooseWay};
+  stage.mNext = unsigned(mWays.size());
+  stage.mNumWays = unsigned(chooseFrom.size());
+  mWays.insert(mWays.end(), chooseFrom.begin(), chooseFrom.end());
+  return AddStage(stage);
+}
+
+unsigned DealSampler::AddDealRest(const CardDeck& cards, const CardHands& hands)
+{
+  Stage stage = {kDealRest};
+  for (unsigned p = 0; p < 4; ++p)
+    stage.mCapacities[p] = uint8_t(hands[p].AvailableCapacity());
+  stage.mCards = cards.Bits();
+  return AddStage(stage);
+}
+
+unsigned DealSampler::AddNoneRemaining()
+{
+  return AddStage(Stage{kNoneRemaining});
+}
+
+void DealSampler::Sample(const RandomGenerator& rng, CardHands& hands) const
+{
+  unsigned next = mRoot;
+  while (true)
+  {
+    const Stage& stage = mStages[next];
+    switch (stage.mKind)
+    {
+      case kNoneRemaining:
+        return;
+
+      case kGiveSuit:
+        hands[stage.mPlayers[0]].Merge(CardDeck(stage.mCards, kEmpty));
+        next = stage.mNext;
+        break;
+
+      case kSplitSuit:
+      {
+        const uint64_t first = RandomSubset(stage.mCards, stage.mNumFirst, rng);
+        hands[stage.mPlayers[0]].Merge(CardDeck(first, kEmpty));
+        hands[stage.mPlayers[1]].Merge(CardDeck(stage.mCards & ~first, kEmpty));
+        next = stage.mNext;
+        break;
+      }
+
+      case kChooseWay:
+      {
+        // The total usually fits in 64 bits, and then the draw needs no 128-bit division.
+        const Way* ways = &mWays[stage.mNext];
+        const uint128_t total = ways[stage.mNumWays - 1].mUpperBound;
+        const uint128_t r = total >> 64 ? rng.range128(total) : rng.range64(uint64_t(total));
+        unsigned i = 0;
+        while (r >= ways[i].mUpperBound)
+          ++i;
+        next = ways[i].mStage;
+        break;
+      }
+
+      case kDealRest:
+      {
+        uint64_t cards = stage.mCards;
+        for (unsigned p = 0; p < 4; ++p)
+        {
+          if (stage.mCapacities[p] == 0)
+            continue;
+          const uint64_t dealt = RandomSubset(cards, stage.mCapacities[p], rng);
+          hands[p].Merge(CardDeck(dealt, kEmpty));
+          cards &= ~dealt;
+        }
+        assert(cards == 0);
+        return;
+      }
+    }
+  }
+}
@@ -0,0 +1,85 @@
+// lib/DealSampler.h
+
+#pragma once
+
+#include "lib/CardArray.h"
+#include "lib/math.h"
+
+#include <unordered_map>
+#include <vector>
+
+class PossibilityAnalyzer;
+class RandomGenerator;
+
+// DealSampler draws uniformly random deals of the unknown cards from the possibilities of a PossibilityAnalyzer
+// tree, without computing a possibility index.
+//
+// The tree is lowered into a flat table of stages, one per node, so sampling is a loop over the table rather
+// than a descent through virtual calls. At the branches of the tree, a way is chosen with probability
+// proportional to its possibilities by comparing one random draw against a table of cumulative counts.
+// Within each stage, the cards are dealt by choosing random subsets of the stage's cards with 64-bit random
+// draws, where ActualizePossibility() does 128-bit divisions for every card.
+//
+// A sampler only refers to its analyzer while it is constructed.
+class DealSampler
+{
+public:
+  DealSampler(const PossibilityAnalyzer& analyzer);
+
+  void Sample(const RandomGenerator& rng, CardHands& hands) const;
+    // Deals the unknown cards into hands prepared as for ActualizePossibility(). Every possibility of the
+    // analyzer is equally likely.
+
+  unsigned NumStages() const { return unsigned(mStages.size()); }
+
+public:
+  // Called by the analyzers from PossibilityAnalyzer::AddToSampler(), each returning the index of its stage.
+
+  unsigned StageFor(const PossibilityAnalyzer& analyzer);
+    // The stage for the analyzer, lowering it first if it has not been lowered. Subtrees shared between
+    // branches of the tree are lowered once.
+
+  unsigned AddGiveSuit(unsigned opponent, const CardDeck& cards, const PossibilityAnalyzer& next);
+    // All of the cards go to the opponent.
+
+  unsigned AddSplitSuit(unsigned a, unsigned b, const CardDeck& cards, unsigned numFirst, const PossibilityAnalyzer& next);
+    // A random numFirst of the cards go to opponent a, and the rest to b.
+
+  unsigned AddChooseWay(const std::vector<const PossibilityAnalyzer*>& ways);
+    // One of the ways with possibilities, chosen in proportion to its possibilities.
+
+  unsigned AddDealRest(const CardDeck& cards, const CardHands& hands);
+    // The cards are dealt at random to fill the available capacity of the hands.
+
+  unsigned AddNoneRemaining();
+
+private:
+  enum StageKind : uint8_t { kNoneRemaining, kGiveSuit, kSplitSuit, kChooseWay, kDealRest };
+
+  struct Stage
+  {
+    StageKind mKind;
+    uint8_t mPlayers[2];
+    uint8_t mNumFirst;
+    uint8_t mCapacities[4];
+    unsigned mNext;
+      // For kChooseWay, the index in mWays of the first way.
+    unsigned mNumWays;
+    uint64_t mCards;
+  };
+
+  struct Way
+  {
+    uint128_t mUpperBound;
+      // The sum of the possibilities of this way and the ways before it.
+    unsigned mStage;
+  };
+
+  unsigned AddStage(const Stage& stage);
+
+private:
+  std::vector<Stage> mStages;
+  std::vector<Way> mWays;
+  unsigned mRoot;
+  std::unordered_map<const PossibilityAnalyzer*, unsigned> mLowered;
+};
@@ -0,0 +1,359 @@
+// lib/DenseMlpBackend.cpp
+
+#include "lib/DenseMlpBackend.h"
+#include "lib/KnowableState.h"
+
+#include <x86intrin.h>
+
+#include <algorithm>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// The kernels below are written once against this minimal vector abstraction.
+#if defined(__AVX512F__)
+typedef __m512 Vec;
+constexpr unsigned kLanes = 16;
+inline Vec Zero() { return _mm512_setzero_ps(); }
+inline Vec Broadcast(float x) { return _mm512_set1_ps(x); }
+inline Vec Load(const float* p) { return _mm512_load_ps(p); }
+inline Vec LoadUnaligned(const float* p) { return _mm512_loadu_ps(p); }
+inline void Store(float* p, Vec v) { _mm512_store_ps(p, v); }
+inline Vec Add(Vec a, Vec b) { return _mm512_add_ps(a, b); }
+inline Vec Max(Vec a, Vec b) { return _mm512_max_ps(a, b); }
+inline Vec Fma(Vec a, Vec b, Vec c) { return _mm512_fmadd_ps(a, b, c); }
+#elif defined(__AVX2__) && defined(__FMA__)
+typedef __m256 Vec;
+constexpr unsigned kLanes = 8;
+inline Vec Zero() { return _mm256_setzero_ps(); }
+inline Vec Broadcast(float x) { return _mm256_set1_ps(x); }
+inline Vec Load(const float* p) { return _mm256_load_ps(p); }
+inline Vec LoadUnaligned(const float* p) { return _mm256_loadu_ps(p); }
+inline void Store(float* p, Vec v) { _mm256_store_ps(p, v); }
+inline Vec Add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+inline Vec Max(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+inline Vec Fma(Vec a, Vec b, Vec c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+typedef float Vec;
+constexpr unsigned kLanes = 1;
+inline Vec Zero() { return 0.0f; }
+inline Vec Broadcast(float x) { return x; }
+inline Vec Load(const float* p) { return *p; }
+inline Vec LoadUnaligned(const float* p) { return *p; }
+inline void Store(float* p, Vec v) { *p = v; }
+inline Vec Add(Vec a, Vec b) { return a + b; }
+inline Vec Max(Vec a, Vec b) { return a > b ? a : b; }
+inline Vec Fma(Vec a, Vec b, Vec c) { return a * b + c; }
+#endif
+
+// Each step of the inner loop updates a tile of kRowBlock rows by kTileColumns outputs held in registers.
+constexpr unsigned kVecsPerTile = 4;
+constexpr unsigned kTileColumns = kVecsPerTile * kLanes;
+constexpr unsigned kRowBlock = 4;
+
+// Rows are run through all layers in chunks small enough to keep the activations in cache.
+constexpr unsigned kRowChunk = 64;
+
+constexpr size_t kAlignment = 64;
+
+unsigned PaddedColumns(unsigned n) { return (n + kTileColumns - 1) / kTileColumns * kTileColumns; }
+
+void Fail(const std::string& path, const char* message)
+{
+  fprintf(stderr, "Failed to load model %s: %s\n", path.c_str(), message);
+  exit(1);
+}
+
+template <typename T>
+T ReadValue(FILE* file, const std::string& path)
+{
+  T value;
+  if (fread(&value, sizeof(value), 1, file) != 1)
+    Fail(path, "unexpected end of file");
+  return value;
+}
+
+void ReadFloats(FILE* file, const std::string& path, float* dst, size_t count)
+{
+  if (fread(dst, sizeof(float), count, file) != count)
+    Fail(path, "unexpected end of file");
+}
+
+}  // namespace
+
+DenseMlpBackend::AlignedFloats DenseMlpBackend::AllocateFloats(size_t count)
+{
+  const size_t bytes = std::max(kAlignment, (count * sizeof(float) + kAlignment - 1) / kAlignment * kAlignment);
+  float* p = static_cast<float*>(aligned_alloc(kAlignment, bytes));
+  memset(p, 0, bytes);
+  return AlignedFloats(p);
+}
+
+DenseMlpBackend::~DenseMlpBackend()
+{}
+
+DenseMlpBackend::DenseMlpBackend(const std::string& path)
+: mNumBuffers(0)
+{
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == 0)
+    Fail(path, strerror(errno));
+
+  char magic[8];
+  if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) || memcmp(magic, kMagic, sizeof(magic)) != 0)
+    Fail(path, "not a dense MLP model file");
+
+  const unsigned inputs = ReadValue<uint32_t>(file, path);
+  if (inputs != KnowableState::kNumFeatures)
+    Fail(path, "the model input size does not match KnowableState::kNumFeatures");
+
+  ReadStack(file, path, inputs, mTrunk);
+  ReadStack(file, path, mTrunk.mOutputs, mScoreHead);
+  ReadStack(file, path, mTrunk.mOutputs, mMoonHead);
+
+  if (mTrunk.mLayers.empty() || mScoreHead.mLayers.empty() || mMoonHead.mLayers.empty())
+    Fail(path, "the trunk and both heads must each have at least one layer");
+  if (mScoreHead.mOutputs != kScoresPerRow || mMoonHead.mOutputs != kMoonProbsPerRow)
+    Fail(path, "the model outputs do not match kScoresPerRow and kMoonProbsPerRow");
+  if (mTrunk.mOutputActivation != kLinear)
+    Fail(path, "the trunk must have a linear output");
+  if (mMoonHead.mOutputActivation != kSoftmaxMoonClasses)
+    Fail(path, "the moon head must end with a softmax over the moon classes");
+  if (mScoreHead.mOutputActivation == kSoftmaxMoonClasses)
+    Fail(path, "the score head can't end with a softmax");
+  for (const Layer& layer : mTrunk.mLayers)
+  {
+    // The model input rows are not padded for the SIMD kernels.
+    if (layer.mResidualFrom == 0)
+      Fail(path, "the model input cannot be used as a residual");
+  }
+
+  if (fgetc(file) != EOF)
+    Fail(path, "unexpected data at end of file");
+  fclose(file);
+}
+
+void DenseMlpBackend::ReadStack(FILE* file, const std::string& path, unsigned inputs, Stack& stack)
+{
+  const unsigned numLayers = ReadValue<uint32_t>(file, path);
+  stack.mInputs = inputs;
+  stack.mOutputs = inputs;
+  stack.mOutputActivation = Activation(ReadValue<uint32_t>(file, path));
+  stack.mFirstBuffer = mNumBuffers;
+  if (stack.mOutputActivation > kSoftmaxMoonClasses)
+    Fail(path, "unknown output activation");
+
+  std::vector<float> weights;
+  for (unsigned i = 0; i < numLayers; ++i)
+  {
+    Layer layer;
+    layer.mInputs = ReadValue<uint32_t>(file, path);
+    layer.mOutputs = ReadValue<uint32_t>(file, path);
+    layer.mActivation = Activation(ReadValue<uint32_t>(file, path));
+    const unsigned flags = ReadValue<uint32_t>(file, path);
+    layer.mResidualFrom = ReadValue<int32_t>(file, path);
+    layer.mHasAffine = (flags & kHasAffine) != 0;
+    layer.mPaddedOutputs = PaddedColumns(layer.mOutputs);
+
+    if (layer.mInputs != stack.mOutputs)
+      Fail(path, "layer inputs do not match the outputs of the previous layer");
+    if (layer.mOutputs == 0)
+      Fail(path, "layer has no outputs");
+    if (layer.mActivation != kLinear && layer.mActivation != kRelu)
+      Fail(path, "unknown layer activation");
+    if (layer.mResidualFrom > int(i) || layer.mResidualFrom < -1)
+      Fail(path, "residual must come from the input of this or an earlier layer");
+    if (layer.mResidualFrom >= 0)
+    {
+      const int j = layer.mResidualFrom;
+      const unsigned residualInputs = j == int(i) ? layer.mInputs : stack.mLayers[j].mInputs;
+      if (residualInputs != layer.mOutputs)
+        Fail(path, "residual input size does not match layer outputs");
+    }
+
+    weights.resize(size_t(layer.mInputs) * layer.mOutputs);
+    ReadFloats(file, path, weights.data(), weights.size());
+    layer.mWeights = AllocateFloats(size_t(layer.mInputs) * layer.mPaddedOutputs);
+    for (unsigned o = 0; o < layer.mOutputs; ++o)
+    {
+      for (unsigned in = 0; in < layer.mInputs; ++in)
+        layer.mWeights[size_t(in) * layer.mPaddedOutputs + o] = weights[size_t(o) * layer.mInputs + in];
+    }
+
+    layer.mBias = AllocateFloats(layer.mPaddedOutputs);
+    ReadFloats(file, path, layer.mBias.get(), layer.mOutputs);
+    if (layer.mHasAffine)
+    {
+      layer.mScale = AllocateFloats(layer.mPaddedOutputs);
+      layer.mShift = AllocateFloats(layer.mPaddedOutputs);
+      ReadFloats(file, path, layer.mScale.get(), layer.mOutputs);
+      ReadFloats(file, path, layer.mShift.get(), layer.mOutputs);
+    }
+
+    stack.mOutputs = layer.mOutputs;
+    stack.mLayers.push_back(std::move(layer));
+    ++mNumBuffers;
+  }
+}
+
+unsigned DenseMlpBackend::NumLayers() const
+{
+  return mTrunk.mLayers.size() + mScoreHead.mLayers.size() + mMoonHead.mLayers.size();
+}
+
+template <unsigned kRows>
+void DenseMlpBackend::Layer::ForwardRows(const float* in, size_t inStride, const float* residual,
+                                         size_t residualStride, float* out, size_t outStride) const
+{
+  for (unsigned column = 0; column < mPaddedOutputs; column += kTileColumns)
+  {
+    Vec acc[kRows][kVecsPerTile];
+    for (unsigned r = 0; r < kRows; ++r)
+      for (unsigned v = 0; v < kVecsPerTile; ++v)
+        acc[r][v] = Load(mBias.get() + column + v * kLanes);
+
+    const float* w = mWeights.get() + column;
+    for (unsigned i = 0; i < mInputs; ++i, w += mPaddedOutputs)
+    {
+      // Our inputs are sparse (many features are zero, and relu makes many activations zero), so skip
+      // the whole row of weights when it would not contribute to any row of the block.
+      float x[kRows];
+      bool any = false;
+      for (unsigned r = 0; r < kRows; ++r)
+      {
+        x[r] = in[r * inStride + i];
+        any |= x[r] != 0.0f;
+      }
+      if (!any)
+        continue;
+
+      Vec wv[kVecsPerTile];
+      for (unsigned v = 0; v < kVecsPerTile; ++v)
+        wv[v] = Load(w + v * kLanes);
+      for (unsigned r = 0; r < kRows; ++r)
+      {
+        const Vec xv = Broadcast(x[r]);
+        for (unsigned v = 0; v < kVecsPerTile; ++v)
+          acc[r][v] = Fma(xv, wv[v], acc[r][v]);
+      }
+    }
+
+    for (unsigned r = 0; r < kRows; ++r)
+    {
+      for (unsigned v = 0; v < kVecsPerTile; ++v)
+      {
+        const unsigned c = column + v * kLanes;
+        Vec y = acc[r][v];
+        if (mActivation == kRelu)
+          y = Max(y, Zero());
+        if (mHasAffine)
+          y = Fma(y, Load(mScale.get() + c), Load(mShift.get() + c));
+        if (residual)
+          y = Add(y, LoadUnaligned(residual + r * residualStride + c));
+        Store(out + r * outStride + c, y);
+      }
+    }
+  }
+}
+
+void DenseMlpBackend::Layer::Forward(const float* in, size_t inStride, const float* residual, size_t residualStride,
+                                     unsigned numRows, float* out, size_t outStride) const
+{
+  unsigned row = 0;
+  for (; row + kRowBlock <= numRows; row += kRowBlock)
+  {
+    ForwardRows<kRowBlock>(in + row * inStride, inStride, residual ? residual + row * residualStride : 0,
+                           residualStride, out + row * outStride, outStride);
+  }
+  for (; row < numRows; ++row)
+  {
+    ForwardRows<1>(in + row * inStride, inStride, residual ? residual + row * residualStride : 0, residualStride,
+                   out + row * outStride, outStride);
+  }
+}
+
+const float* DenseMlpBackend::RunStack(const Stack& stack, const float* in, size_t inStride, unsigned numRows,
+                                       Workspace& workspace, size_t& outStride) const
+{
+  const float* layerIn = in;
+  size_t layerInStride = inStride;
+  for (unsigned i = 0; i < stack.mLayers.size(); ++i)
+  {
+    const Layer& layer = stack.mLayers[i];
+
+    const float* residual = 0;
+    size_t residualStride = 0;
+    if (layer.mResidualFrom >= 0)
+    {
+      // The input of layer j is the output of layer j-1, or the stack input for j == 0.
+      const int j = layer.mResidualFrom;
+      residual = j == 0 ? in : workspace.mBuffers[stack.mFirstBuffer + j - 1].get();
+      residualStride = j == 0 ? inStride : stack.mLayers[j - 1].mPaddedOutputs;
+    }
+
+    float* out = workspace.mBuffers[stack.mFirstBuffer + i].get();
+    layer.Forward(layerIn, layerInStride, residual, residualStride, numRows, out, layer.mPaddedOutputs);
+    layerIn = out;
+    layerInStride = layer.mPaddedOutputs;
+  }
+
+  outStride = layerInStride;
+  return layerIn;
+}
+
+void DenseMlpBackend::Run(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const
+{
+  Workspace& workspace = mWorkspaces.data();
+  if (workspace.mBuffers.size() != mNumBuffers)
+  {
+    workspace.mBuffers.clear();
+    for (const Stack* stack : {&mTrunk, &mScoreHead, &mMoonHead})
+      for (const Layer& layer : stack->mLayers)
+        workspace.mBuffers.push_back(AllocateFloats(size_t(kRowChunk) * layer.mPaddedOutputs));
+  }
+
+  for (unsigned first = 0; first < numRows; first += kRowChunk)
+  {
+    const unsigned rows = std::min(kRowChunk, numRows - first);
+
+    size_t trunkStride;
+    const float* trunk = RunStack(
+        mTrunk, mainData + size_t(first) * KnowableState::kNumFeatures, KnowableState::kNumFeatures, rows,
+        workspace, trunkStride);
+
+    size_t scoreStride;
+    const float* score = RunStack(mScoreHead, trunk, trunkStride, rows, workspace, scoreStride);
+    for (unsigned r = 0; r < rows; ++r)
+    {
+      float* dst = expectedScore + size_t(first + r) * kScoresPerRow;
+      const float* src = score + r * scoreStride;
+      for (unsigned c = 0; c < kScoresPerRow; ++c)
+        dst[c] = mScoreHead.mOutputActivation == kRelu ? std::max(src[c], 0.0f) : src[c];
+    }
+
+    size_t moonStride;
+    const float* moon = RunStack(mMoonHead, trunk, trunkStride, rows, workspace, moonStride);
+    for (unsigned r = 0; r < rows; ++r)
+    {
+      float* dst = moonProbs + size_t(first + r) * kMoonProbsPerRow;
+      const float* src = moon + r * moonStride;
+      for (unsigned c = 0; c < kMoonProbsPerRow; c += kNumMoonClasses)
+      {
+        float maxLogit = src[c];
+        for (unsigned k = 1; k < kNumMoonClasses; ++k)
+          maxLogit = std::max(maxLogit, src[c + k]);
+        float sum = 0.0f;
+        for (unsigned k = 0; k < kNumMoonClasses; ++k)
+        {
+          dst[c + k] = expf(src[c + k] - maxLogit);
+          sum += dst[c + k];
+        }
+        for (unsigned k = 0; k < kNumMoonClasses; ++k)
+          dst[c + k] /= sum;
+      }
+    }
+  }
+}
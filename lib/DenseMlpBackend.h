@@ -0,0 +1,123 @@
+// lib/DenseMlpBackend.h
+
+#pragma once
+
+#include "lib/InferenceBackend.h"
+
+#include "dlib/threads.h"
+
+#include <stdlib.h>
+#include <vector>
+
+// A native evaluator for models exported by python/export_mlp.py.
+//
+// The model is a shared trunk followed by two heads, expected score and moon probabilities.
+// Each of these three stacks is a sequence of dense layers, where each layer computes
+//     y = act(W x + b) * scale + shift          (scale/shift are optional, e.g. a BatchNormalization in inference mode)
+//     y = y + x'                                (optional: x' is the input of an earlier layer of the same stack)
+// and then a final output activation is applied to the last layer of the stack. The trunk's output activation must
+// be kLinear (any activation belongs in its last layer), the score head's kLinear or kRelu, and the moon head's
+// kSoftmaxMoonClasses.
+// The convolutions over ranks in python/model.py are exported as block sparse dense layers.
+//
+// The file is little endian:
+//     char    magic[8]        "HNNMLP01"
+//     uint32  inputs          must be KnowableState::kNumFeatures
+//     and then for each of the three stacks (trunk, score head, moon head):
+//       uint32  numLayers
+//       uint32  outputActivation
+//       and then for each layer:
+//         uint32  inputs, outputs, activation, flags
+//         int32   residualFrom    -1, or the index of the earlier layer in this stack whose input is added
+//         float   weights[outputs][inputs]
+//         float   bias[outputs]
+//         float   scale[outputs], shift[outputs]      (only when flags has kHasAffine)
+class DenseMlpBackend : public InferenceBackend
+{
+public:
+  static constexpr const char* kFileSuffix = ".mlp";
+  static constexpr const char* kMagic = "HNNMLP01";
+
+  enum Activation
+  {
+    kLinear = 0,
+    kRelu = 1,
+    kSoftmaxMoonClasses = 2,
+      // Only valid as the output activation of a stack: softmax over each group of kNumMoonClasses outputs.
+  };
+
+  enum LayerFlags
+  {
+    kHasAffine = 1,
+  };
+
+  virtual ~DenseMlpBackend();
+
+  DenseMlpBackend(const std::string& path);
+    // Exits with an error message if the file can't be read or is not a valid model.
+
+  virtual void Run(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const;
+
+  unsigned NumLayers() const;
+
+private:
+  struct FreeDeleter
+  {
+    void operator()(float* p) const { free(p); }
+  };
+  typedef std::unique_ptr<float[], FreeDeleter> AlignedFloats;
+
+  static AlignedFloats AllocateFloats(size_t count);
+    // Returns count zeroed floats, aligned for the widest SIMD loads.
+
+  struct Layer
+  {
+    unsigned mInputs;
+    unsigned mOutputs;
+    unsigned mPaddedOutputs;
+    Activation mActivation;
+    bool mHasAffine;
+    int mResidualFrom;
+    AlignedFloats mWeights;
+      // Transposed to [mInputs][mPaddedOutputs], with zeros in the padding.
+    AlignedFloats mBias;
+    AlignedFloats mScale;
+    AlignedFloats mShift;
+
+    void Forward(const float* in, size_t inStride, const float* residual, size_t residualStride, unsigned numRows,
+                 float* out, size_t outStride) const;
+      // Computes the outputs for numRows rows. Strides are in floats.
+
+    template <unsigned kRows>
+    void ForwardRows(const float* in, size_t inStride, const float* residual, size_t residualStride, float* out,
+                     size_t outStride) const;
+  };
+
+  struct Stack
+  {
+    unsigned mInputs;
+    unsigned mOutputs;
+    Activation mOutputActivation;
+    unsigned mFirstBuffer;
+      // The index in the Workspace of the output buffer of this stack's first layer.
+    std::vector<Layer> mLayers;
+  };
+
+  struct Workspace
+  {
+    std::vector<AlignedFloats> mBuffers;
+      // One buffer of kRowChunk rows for each layer of all stacks
+  };
+
+  void ReadStack(FILE* file, const std::string& path, unsigned inputs, Stack& stack);
+
+  const float* RunStack(const Stack& stack, const float* in, size_t inStride, unsigned numRows, Workspace& workspace,
+                        size_t& outStride) const;
+
+private:
+  Stack mTrunk;
+  Stack mScoreHead;
+  Stack mMoonHead;
+  unsigned mNumBuffers;
+  mutable dlib::thread_specific_data<Workspace> mWorkspaces;
+};
@@ -1,14 +1,60 @@
 #include "lib/Distribution.h"
 #include "lib/Card.h"
 #include "lib/combinatorics.h"
+#include "lib/TaskExecutor.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <string.h>
 #include <strings.h>
+#include <vector>
+
+namespace {
+
+// GCC vector extensions, as in MultiRollout. One vector holds the counts of one card for the four players.
+typedef uint64_t Lanes __attribute__((vector_size(4 * sizeof(uint64_t))));
+typedef double DoubleLanes __attribute__((vector_size(4 * sizeof(double))));
+typedef float FloatLanes __attribute__((vector_size(4 * sizeof(float))));
+
+const unsigned kNumCards = 52;
+const uint128_t kMax64 = ~uint64_t(0);
+
+inline Lanes Load(const uint64_t* counts, Card card)
+{
+  Lanes x;
+  memcpy(&x, counts + 4*card, sizeof(x));
+  return x;
+}
+
+inline void Store(uint64_t* counts, Card card, Lanes x)
+{
+  memcpy(counts + 4*card, &x, sizeof(x));
+}
+
+inline Lanes Carry(Lanes sum, Lanes addend)
+{
+  // The lanes where sum = addend + something wrapped around, as 1 or 0.
+  return (Lanes) (sum < addend) & 1;
+}
+
+inline void StoreRow(double row[4], DoubleLanes x)
+{
+  memcpy(row, &x, sizeof(x));
+}
+
+inline void StoreRow(float row[4], DoubleLanes x)
+{
+  const FloatLanes f = __builtin_convertvector(x, FloatLanes);
+  memcpy(row, &f, sizeof(f));
+}
+
+}  // namespace
 
 Distribution::Distribution()
+: mBound(0)
+, mWide(false)
 {
-  bzero(mCounts, sizeof(mCounts));
+  bzero(mLow, sizeof(mLow));
 }
 
 Distribution::Distribution(const Distribution& other)
@@ -19,28 +65,95 @@ Distribution::Distribution(const Distribution& other)
 void Distribution::operator=(const Distribution& other)
 {
   assert(this != &other);
-  memcpy(mCounts, other.mCounts, sizeof(mCounts));
+  memcpy(mLow, other.mLow, sizeof(mLow));
+  if (other.mWide)
+    memcpy(mHigh, other.mHigh, sizeof(mHigh));
+  mBound = other.mBound;
+  mWide = other.mWide;
+}
+
+void Distribution::Widen()
+{
+  if (!mWide) {
+    bzero(mHigh, sizeof(mHigh));
+    mWide = true;
+  }
+}
+
+void Distribution::AddToBound(uint128_t count)
+{
+  mBound += count;
+  if (mBound > kMax64)
+    Widen();
+}
+
+void Distribution::Add(unsigned index, uint128_t count)
+{
+  if (!mWide) {
+    mLow[index] += uint64_t(count);
+  } else {
+    const uint128_t sum = ((uint128_t(mHigh[index]) << 64) | mLow[index]) + count;
+    mLow[index] = uint64_t(sum);
+    mHigh[index] = uint64_t(sum >> 64);
+  }
+}
+
+uint128_t Distribution::Count(Card card, unsigned player) const
+{
+  const unsigned index = card*4 + player;
+  return mWide ? (uint128_t(mHigh[index]) << 64) | mLow[index] : mLow[index];
 }
 
 void Distribution::operator+=(const Distribution& other)
 {
-  for (int c=0; c<52; ++c)
-    for (int p=0; p<4; ++p)
-      mCounts[c][p] += other.mCounts[c][p];
+  AddToBound(other.mBound);
+
+  if (!mWide) {
+    for (Card c=0; c<kNumCards; ++c)
+      Store(mLow, c, Load(mLow, c) + Load(other.mLow, c));
+  } else if (!other.mWide) {
+    for (Card c=0; c<kNumCards; ++c) {
+      const Lanes low = Load(mLow, c) + Load(other.mLow, c);
+      Store(mHigh, c, Load(mHigh, c) + Carry(low, Load(other.mLow, c)));
+      Store(mLow, c, low);
+    }
+  } else {
+    for (Card c=0; c<kNumCards; ++c) {
+      const Lanes low = Load(mLow, c) + Load(other.mLow, c);
+      Store(mHigh, c, Load(mHigh, c) + Load(other.mHigh, c) + Carry(low, Load(other.mLow, c)));
+      Store(mLow, c, low);
+    }
+  }
 }
 
 void Distribution::operator*=(uint128_t multiplier)
 {
-  for (int c=0; c<52; ++c)
-    for (int p=0; p<4; ++p)
-      mCounts[c][p] *= multiplier;
+  if (!mWide && (multiplier == 0 || mBound <= kMax64 / multiplier)) {
+    mBound *= multiplier;
+    const Lanes m = Lanes{} + uint64_t(multiplier);
+    for (Card c=0; c<kNumCards; ++c)
+      Store(mLow, c, Load(mLow, c) * m);
+    return;
+  }
+
+  // Vector units have no 128-bit multiply, so wide counts are multiplied one at a time.
+  mBound *= multiplier;
+  Widen();
+  for (unsigned i=0; i<kNumCounts; ++i) {
+    const uint128_t product = ((uint128_t(mHigh[i]) << 64) | mLow[i]) * multiplier;
+    mLow[i] = uint64_t(product);
+    mHigh[i] = uint64_t(product >> 64);
+  }
 }
 
 bool Distribution::operator==(const Distribution& other) const
 {
+  if (!mWide && !other.mWide)
+    return memcmp(mLow, other.mLow, sizeof(mLow)) == 0;
+
   for (int c=0; c<52; ++c)
     for (int p=0; p<4; ++p)
-      if (mCounts[c][p] != other.mCounts[c][p])
+      if (Count(c, p) != other.Count(c, p))
         return false;
   return true;
 }
@@ -50,79 +163,113 @@ void Distribution::DistributeRemaining(const CardDeck& remaining, uint128_t poss
 {
   const uint128_t total = hands.TotalCapacity();
   assert(total == remaining.Size());
-  unsigned cardsLeft = total;
-  uint128_t ways = 1;
   unsigned capacities[4];
-  for (int p=0; p<4; ++p) {
+  for (int p=0; p<4; ++p)
     capacities[p] = hands[p].AvailableCapacity();
-    ways *= combinations128(cardsLeft, capacities[p]);
-    cardsLeft -= capacities[p];
+  assert(multinomial128(capacities) == possibles);
+
+  // Every card has the same share of the possibilities for each player, so divide once per player,
+  // and add all four shares to each card at once.
+  uint128_t shares[4];
+  Lanes lowShares, highShares;
+  for (int p=0; p<4; ++p) {
+    shares[p] = capacities[p] ? possibles * capacities[p] / total : 0;
+    lowShares[p] = uint64_t(shares[p]);
+    highShares[p] = uint64_t(shares[p] >> 64);
   }
-  assert(ways == possibles);
+  AddToBound(*std::max_element(shares, shares+4));
 
   CardArray::iterator it(remaining);
   while (!it.done()) {
-    Card card = it.next();
-    for (int p=0; p<4; ++p) {
-      if (capacities[p])
-        mCounts[card][p] += possibles * capacities[p] / total;
-    }
+    const Card card = it.next();
+    const Lanes low = Load(mLow, card) + lowShares;
+    if (mWide)
+      Store(mHigh, card, Load(mHigh, card) + highShares + Carry(low, lowShares));
+    Store(mLow, card, low);
   }
 }
 
 void Distribution::CountOccurrences(const CardHands& hands)
 {
+  AddToBound(1);
   for (int player=0; player<4; player++) {
     const CardHand& hand = hands[player];
     CardArray::iterator it(hand);
     while (!it.done()) {
       Card card = it.next();
-      mCounts[card][player] += 1;
+      Add(card*4 + player, 1);
     }
   }
 }
 
+void Distribution::ParallelAccumulate(Distribution& total, unsigned numTasks, unsigned numSlots
+                                    , const AccumulateFunction& accumulate)
+{
+  TaskExecutor& executor = TaskExecutor::Shared();
+  std::vector<Distribution> slotDistributions(std::min(std::max(numSlots, 1u), executor.MaxSlots()));
+
+  executor.ParallelFor(numTasks, unsigned(slotDistributions.size()), [&](unsigned task, unsigned slot) {
+    accumulate(task, slotDistributions[slot]);
+  });
+
+  for (const Distribution& distribution : slotDistributions)
+    total += distribution;
+}
+
 void Distribution::Print() const
 {
   for (Card c=0; c<52; c++) {
     uint128_t total = 0;
     for (int p=0; p<4; ++p) {
-      total += mCounts[c][p];
+      total += Count(c, p);
     }
     if (total > 0) {
       printf("%3s %5s %5s %5s %5s\n", NameOf(c)
-        , asDecimalString(mCounts[c][0]).c_str()
-        , asDecimalString(mCounts[c][1]).c_str()
-        , asDecimalString(mCounts[c][2]).c_str()
-        , asDecimalString(mCounts[c][3]).c_str());
+        , asDecimalString(Count(c, 0)).c_str()
+        , asDecimalString(Count(c, 1)).c_str()
+        , asDecimalString(Count(c, 2)).c_str()
+        , asDecimalString(Count(c, 3)).c_str());
     }
   }
 }
 
-void Distribution::AsProbabilities(float prob[52][4]) const
+template <typename Real>
+void Distribution::Normalize(Real prob[52][4]) const
 {
   uint128_t possibilities = 0;
-  float scale = 0.0;
+  for (Card c=0; c<52 && possibilities==0; ++c) {
+    for (int p=0; p<4; ++p)
+      possibilities += Count(c, p);
+  }
+
+#ifndef NDEBUG
   for (Card c=0; c<52; ++c) {
     uint128_t sum = 0;
-    for (int p=0; p<4; ++p) {
-      sum += mCounts[c][p];
-    }
-    if (sum>0 && possibilities==0) {
-      possibilities = sum;
-      scale = 1.0 / float(possibilities);
-    }
-    if (sum == 0) {
-      for (int p=0; p<4; ++p) {
-        prob[c][p] = 0.0;
-      }
-    } else {
-      assert(sum == possibilities);
-      for (int p=0; p<4; ++p) {
-        prob[c][p] = scale * mCounts[c][p];
-      }
-    }
+    for (int p=0; p<4; ++p)
+      sum += Count(c, p);
+    assert(sum == 0 || sum == possibilities);
   }
+#endif
+
+  // Cards that were not dealt have zero counts, so they need no special case.
+  const double scale = possibilities ? 1.0 / double(possibilities) : 0.0;
+  const double kTwoTo64 = 18446744073709551616.0;
+  for (Card c=0; c<kNumCards; ++c) {
+    DoubleLanes counts = __builtin_convertvector(Load(mLow, c), DoubleLanes);
+    if (mWide)
+      counts += __builtin_convertvector(Load(mHigh, c), DoubleLanes) * kTwoTo64;
+    StoreRow(prob[c], counts * scale);
+  }
+}
+
+void Distribution::AsProbabilities(float prob[52][4]) const
+{
+  Normalize(prob);
+}
+
+void Distribution::AsProbabilities(double prob[52][4]) const
+{
+  Normalize(prob);
 }
 
 static bool NonZero(float prob[4]) {
@@ -156,7 +303,7 @@ void Distribution::Validate(const CardDeck& allUnplayed, uint128_t possibilities
   for (Card c=0; c<52; c++) {
     uint128_t total = 0;
     for (int p=0; p<4; ++p) {
-      total += mCounts[c][p];
+      total += Count(c, p);
     }
     if (total > 0) {
       assert(total == possibilities);
@@ -171,9 +318,10 @@ void Distribution::Validate(const CardDeck& allUnplayed, uint128_t possibilities
 
 void Distribution::DistributeRemainingToPlayer(const CardArray& remaining, unsigned player, uint128_t possibles)
 {
+  AddToBound(possibles);
   CardArray::iterator it(remaining);
   while (!it.done()) {
     Card card = it.next();
-    mCounts[card][player] += possibles;
+    Add(card*4 + player, possibles);
   }
 }
@@ -2,8 +2,16 @@
 
 #include "CardArray.h"
 
+#include <functional>
+
 typedef __uint128_t uint128_t;
 
+// Distribution counts, for each card and player, the number of possible deals in which the player holds the card.
+//
+// The counts are stored as separate arrays of their low and high 64 bits, with the four players' counts of a
+// card adjacent, so that the arithmetic is done on one card per vector register. Distribution keeps an upper
+// bound of its counts, and until the bound exceeds 64 bits the high halves are neither stored nor read.
+// Late in a game, and in disttest, the counts always fit in 64 bits.
 class Distribution
 {
 public:
@@ -15,6 +23,11 @@ public:
 
   bool operator==(const Distribution& other) const;
 
+  uint128_t Count(Card card, unsigned player) const;
+
+  bool IsWide() const { return mWide; }
+    // Whether the high 64 bits of the counts are in use.
+
   void DistributeRemaining(const CardDeck& remaining, uint128_t possibles, const CardHands& hands);
     // possibles should already be scaled correctly, i.e. total possibles divided by players with available capacity
     // Called from NoVoidsAnalyzer
@@ -27,14 +40,43 @@ public:
     // Given one sample hands configuration, count the occurences, i.e. increment each (card, player) seen.
     // Called from disttest
 
+  typedef std::function<void(unsigned task, Distribution& distribution)> AccumulateFunction;
+
+  static void ParallelAccumulate(Distribution& total, unsigned numTasks, unsigned numSlots
+                               , const AccumulateFunction& accumulate);
+    // Calls accumulate(i, distribution) for each i in [0, numTasks) on the shared TaskExecutor, with at most
+    // numSlots threads. Each thread accumulates into its own distribution, and their sum is added to total.
+
   void Print() const;
 
   void AsProbabilities(float prob[52][4]) const;
+  void AsProbabilities(double prob[52][4]) const;
+    // Each count divided by the number of possibilities, which is the sum of the counts of any card that was dealt.
+    // Cards that were not dealt have zero probability.
 
   static void PrintProbabilities(float prob[52][4], FILE* out=stdout);
 
   void Validate(const CardDeck& allUnplayed, uint128_t possibilities) const;
 
 private:
-  uint128_t mCounts[52][4];
+  static const unsigned kNumCounts = 52*4;
+
+  void Widen();
+    // Start using the high halves of the counts, which are zero until now.
+
+  void AddToBound(uint128_t count);
+    // Account for adding count to some of the counts, widening if they may no longer fit in 64 bits.
+
+  void Add(unsigned index, uint128_t count);
+
+  template <typename Real>
+  void Normalize(Real prob[52][4]) const;
+
+private:
+  alignas(64) uint64_t mLow[kNumCounts];
+  alignas(64) uint64_t mHigh[kNumCounts];
+    // Indexed by card*4 + player. mHigh is only valid when mWide.
+  uint128_t mBound;
+    // No count exceeds mBound.
+  bool mWide;
 };
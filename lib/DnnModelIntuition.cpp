@@ -8,44 +8,39 @@
 #include "lib/timer.h"
 
 using namespace std;
-using namespace tensorflow;
 
 DnnModelIntuition::~DnnModelIntuition() { delete mPredictor; }
 
 DnnModelIntuition::DnnModelIntuition(const std::string& modelPath, bool pooled)
-    : mPredictor(0)
+    : mBackend(LoadInferenceBackend(modelPath))
+    , mPredictor(0)
 {
-    using namespace tensorflow;
-    SessionOptions session_options;
-    RunOptions run_options;
-    auto status = LoadSavedModel(session_options, run_options, modelPath, {kSavedModelTagServe}, &mModel);
-    if (!status.ok())
-    {
-        std::cerr << "Failed: " << status;
-        exit(1);
-    }
-
     if (pooled)
-        mPredictor = new PooledPredictor(mModel);
+        mPredictor = new PooledPredictor(mBackend);
     else
-        mPredictor = new SynchronousPredictor(mModel);
+        mPredictor = new SynchronousPredictor(mBackend);
+}
+
+void DnnModelIntuition::printCounters() const
+{
+    if (const PooledPredictor* pooled = dynamic_cast<const PooledPredictor*>(mPredictor))
+        pooled->PrintCounters();
 }
 
 Card DnnModelIntuition::predictOutcomes(
     const KnowableState& state, const RandomGenerator& rng, float playExpectedValue[13]) const
 {
-    FloatMatrix matrix = state.AsFloatMatrix();
-    Tensor mainData(DT_FLOAT, TensorShape({1, kCardsPerDeck, KnowableState::kNumFeaturesPerCard}));
-
-    const float* srcData = matrix.data();
-    float* dstData = mainData.flat<float>().data();
-
-    memcpy(dstData, srcData, kCardsPerDeck * KnowableState::kNumFeaturesPerCard * sizeof(float));
+    float mainData[KnowableState::kNumFeatures];
+    float* input = mPredictor->InputBuffer(1);
+    if (input == 0)
+        input = mainData;
+    state.EncodeFeatures(input);
 
-    std::vector<tensorflow::Tensor> outputs;
-    mPredictor->Predict(mainData, outputs);
+    float expectedScore[kScoresPerRow];
+    float moonProbs[kMoonProbsPerRow];
+    mPredictor->Predict(input, 1, expectedScore, moonProbs);
 
-    return state.ParsePrediction(outputs, playExpectedValue);
+    return state.ParsePrediction(expectedScore, moonProbs, playExpectedValue);
 }
 
 Card DnnModelIntuition::choosePlay(const KnowableState& state, const RandomGenerator& rng) const
@@ -53,3 +48,34 @@ Card DnnModelIntuition::choosePlay(const KnowableState& state, const RandomGener
     float playExpectedValue[13];
     return predictOutcomes(state, rng, playExpectedValue);
 }
+
+void DnnModelIntuition::choosePlays(const std::vector<KnowableState>& states, const RandomGenerator& rng, Card* plays) const
+{
+    const unsigned kNumStates = states.size();
+    if (kNumStates == 0)
+        return;
+
+    constexpr unsigned kNumFeatures = KnowableState::kNumFeatures;
+    BatchBuffers& buffers = mBatchBuffers.data();
+    buffers.mExpectedScore.resize(kNumStates * kScoresPerRow);
+    buffers.mMoonProbs.resize(kNumStates * kMoonProbsPerRow);
+
+    // Encode the states directly into the backend's input buffer when it has one.
+    float* input = mPredictor->InputBuffer(kNumStates);
+    if (input == 0)
+    {
+        buffers.mMainData.resize(kNumStates * kNumFeatures);
+        input = buffers.mMainData.data();
+    }
+    for (unsigned i = 0; i < kNumStates; ++i)
+        states[i].EncodeFeatures(input + i * kNumFeatures);
+
+    mPredictor->Predict(input, kNumStates, buffers.mExpectedScore.data(), buffers.mMoonProbs.data());
+
+    float playExpectedValue[13];
+    for (unsigned i = 0; i < kNumStates; ++i)
+    {
+        plays[i] = states[i].ParsePrediction(&buffers.mExpectedScore[i * kScoresPerRow],
+            &buffers.mMoonProbs[i * kMoonProbsPerRow], playExpectedValue);
+    }
+}
@@ -1,28 +1,42 @@
 #pragma once
 
 #include "lib/CardArray.h"
+#include "lib/InferenceBackend.h"
 #include "lib/Predictor.h"
 #include "lib/Strategy.h"
 
-#include <tensorflow/cc/framework/ops.h>
-#include <tensorflow/cc/saved_model/loader.h>
-#include <tensorflow/cc/saved_model/tag_constants.h>
-#include <tensorflow/core/protobuf/meta_graph.pb.h>
-#include <tensorflow/core/public/session.h>
-
 class DnnModelIntuition : public Strategy
 {
 public:
     virtual ~DnnModelIntuition();
 
     DnnModelIntuition(const std::string& modelPath, bool pooled = false);
+    // The model is loaded with LoadInferenceBackend(), so modelPath may be a native .mlp file or a SavedModel.
+    // When pooled is true, predictions requested by different threads are batched together by a PooledPredictor.
 
     virtual Card choosePlay(const KnowableState& state, const RandomGenerator& rng) const;
 
     virtual Card predictOutcomes(
         const KnowableState& state, const RandomGenerator& rng, float playExpectedValue[13]) const;
 
+    virtual void choosePlays(const std::vector<KnowableState>& states, const RandomGenerator& rng, Card* plays) const;
+    // Evaluates all of the states with a single model prediction.
+
+    virtual bool prefersBatches() const { return true; }
+
+    virtual void printCounters() const;
+    // Prints the counters of the PooledPredictor, when pooled.
+
 private:
-    tensorflow::SavedModelBundle mModel;
+    struct BatchBuffers
+    {
+        std::vector<float> mMainData;
+        std::vector<float> mExpectedScore;
+        std::vector<float> mMoonProbs;
+    };
+
+    InferenceBackendPtr mBackend;
     Predictor* mPredictor;
+    mutable dlib::thread_specific_data<BatchBuffers> mBatchBuffers;
+    // Reused by choosePlays() so that batches don't need to allocate.
 };
@@ -2,6 +2,7 @@
 #include "lib/GameState.h"
 #include "lib/KnowableState.h"
 #include "lib/PossibilityAnalyzer.h"
+#include "lib/random.h"
 #include <stdio.h>
 
 DnnMonteCarloAnnotator::~DnnMonteCarloAnnotator()
@@ -9,12 +10,12 @@ DnnMonteCarloAnnotator::~DnnMonteCarloAnnotator()
 
 }
 
-DnnMonteCarloAnnotator::DnnMonteCarloAnnotator(const tensorflow::SavedModelBundle& model)
-: mModel(model)
+DnnMonteCarloAnnotator::DnnMonteCarloAnnotator(const StrategyPtr& intuition)
+: mIntuition(intuition)
 {
 }
 
-void DnnMonteCarloAnnotator::On_DnnMonteCarlo_choosePlay(const KnowableState& state, PossibilityAnalyzer* analyzer
+void DnnMonteCarloAnnotator::On_DnnMonteCarlo_choosePlay(const KnowableState& state, const PossibilityAnalyzer* analyzer
                                , const float empiricalExpectedScore[13], const float empiricalMoonProb[13][3])
 {
   const CardHand choices = state.LegalPlays();
@@ -51,7 +52,7 @@ void DnnMonteCarloAnnotator::On_DnnMonteCarlo_choosePlay(const KnowableState& st
   Distribution::PrintProbabilities(prob, stdout);
 
   float predictedExpectedScore[13];
-  state.TransformAndPredict(mModel, predictedExpectedScore);
+  mIntuition->predictOutcomes(state, RandomGenerator::ThreadSpecific(), predictedExpectedScore);
 
   CardArray::iterator it(choices);
   for (unsigned i=0; i<choices.Size(); ++i) {
@@ -69,7 +70,7 @@ void DnnMonteCarloAnnotator::OnGameStateBeforePlay(const GameState& state)
   state.PrintState();
 }
 
-void DnnMonteCarloAnnotator::OnWriteData(const KnowableState& state, PossibilityAnalyzer* analyzer, const float empiricalExpectedScore[13]
+void DnnMonteCarloAnnotator::OnWriteData(const KnowableState& state, const PossibilityAnalyzer* analyzer, const float empiricalExpectedScore[13]
                           , const float empiricalMoonProb[13][3], const float winsTrickProb[13])
 {
 }
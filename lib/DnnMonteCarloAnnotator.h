@@ -2,24 +2,22 @@
 #pragma once
 
 #include "lib/Annotator.h"
-
-namespace tensorflow {
-  struct SavedModelBundle;
-};
+#include "lib/Strategy.h"
 
 class DnnMonteCarloAnnotator : public Annotator {
 public:
   ~DnnMonteCarloAnnotator();
-  DnnMonteCarloAnnotator(const tensorflow::SavedModelBundle& model);
+  DnnMonteCarloAnnotator(const StrategyPtr& intuition);
+    // The intuition's predictions are printed alongside the empirical monte carlo results.
 
-  virtual void On_DnnMonteCarlo_choosePlay(const KnowableState& state, PossibilityAnalyzer* analyzer
+  virtual void On_DnnMonteCarlo_choosePlay(const KnowableState& state, const PossibilityAnalyzer* analyzer
                                  , const float expectedScore[13], const float moonProb[13][3]);
 
   virtual void OnGameStateBeforePlay(const GameState& state);
 
-  virtual void OnWriteData(const KnowableState& state, PossibilityAnalyzer* analyzer, const float expectedScore[13]
+  virtual void OnWriteData(const KnowableState& state, const PossibilityAnalyzer* analyzer, const float expectedScore[13]
   , const float moonProb[13][3], const float winsTrickProb[13]);
 
 private:
-  const tensorflow::SavedModelBundle& mModel;
+  const StrategyPtr mIntuition;
 };
@@ -0,0 +1,250 @@
+// lib/DoubleDummySolver.cpp
+
+#include "lib/DoubleDummySolver.h"
+#include "lib/FastRollout.h"
+#include "lib/SplitMix64.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace {
+
+const int kInfinity = 100;
+const int kValueIfPlayerShoots = -39;
+const int kValueIfOtherShoots = 13;
+  // Twice the zero-mean standard scores of GameOutcome::ZeroMeanStandardScore().
+
+enum Bound { kExact = 0, kLowerBound = 1, kUpperBound = 2 };
+
+const uint64_t kValid = 1ul << 63;
+const unsigned kBoundShift = 8;
+const unsigned kPlayShift = 16;
+
+// One random key for each value of each part of a position. A position's hash is the xor of the keys of its parts.
+struct ZobristKeys
+{
+  ZobristKeys()
+  {
+    uint64_t seed = 0x4475626c6544756dul;
+    FillRandomKeys(mHand, seed);
+    FillRandomKeys(mLead, seed);
+    FillRandomKeys(mPlayer, seed);
+    FillRandomKeys(mTakers, seed);
+  }
+
+  uint64_t mHand[4][kCardsPerDeck];
+  uint64_t mLead[4];
+  uint64_t mPlayer[4];
+  uint64_t mTakers[6];
+};
+
+const ZobristKeys kZobrist;
+
+const Card kQueenOfSpades = CardFor(kQueen, kSpades);
+
+inline int Points(Card card)
+{
+  return SuitOf(card) == kHearts ? 1 : card == kQueenOfSpades ? 13 : 0;
+}
+
+inline uint64_t CardsBetween(Card low, Card high)
+{
+  return ((1ul << high) - 1) & ~((2ul << low) - 1);
+}
+
+// Which players have taken points, as far as shooting the moon is concerned: 0 for none, 1 + p when only player p
+// has, and 5 when two or more players have, so that nobody can shoot the moon.
+unsigned PointTakers(const std::array<unsigned, 4>& scores)
+{
+  unsigned takers = 0;
+  for (unsigned p=0; p<4; ++p) {
+    if (scores[p] != 0)
+      takers = takers == 0 ? 1 + p : 5;
+  }
+  return takers;
+}
+
+int FinalValue(const std::array<unsigned, 4>& scores, unsigned player)
+{
+  for (unsigned p=0; p<4; ++p) {
+    if (scores[p] == kMaxPointsPerHand)
+      return p == player ? kValueIfPlayerShoots : kValueIfOtherShoots;
+  }
+  return 2 * int(scores[player]) - 13;
+}
+
+int OrderKey(const FastRollout& state, Card card, bool midTrick, Card highCard)
+{
+  // Higher keys are searched first. Leads are tried from low to high. Following suit, cards that duck under the
+  // high card come first, highest first, then the winners from lowest. When void, the points and high cards are
+  // discarded first.
+  const int rank = RankOf(card);
+  if (!midTrick)
+    return -rank;
+  if (SuitOf(card) == SuitOf(highCard))
+    return card < highCard ? 100 + rank : -rank;
+  return 200 + 16 * Points(card) + rank;
+}
+
+}  // namespace
+
+DoubleDummySolver::~DoubleDummySolver() {}
+
+DoubleDummySolver::DoubleDummySolver(unsigned log2Entries)
+: mIndexMask((1ul << log2Entries) - 1)
+, mEntries(new Entry[1ul << log2Entries])
+, mNodes(0)
+{
+  for (uint64_t i=0; i<=mIndexMask; ++i) {
+    mEntries[i].mCheck.store(0, std::memory_order_relaxed);
+    mEntries[i].mData.store(0, std::memory_order_relaxed);
+  }
+}
+
+DoubleDummySolver& DoubleDummySolver::Shared()
+{
+  static DoubleDummySolver solver;
+  return solver;
+}
+
+uint64_t DoubleDummySolver::PositionHash(const FastRollout& state, uint64_t handsHash, unsigned player) const
+{
+  // At the start of a trick, the play number and the points played follow from the hands.
+  assert(state.mNextPlay % 4 == 0);
+  return handsHash ^ kZobrist.mLead[state.mLead] ^ kZobrist.mPlayer[player] ^ kZobrist.mTakers[PointTakers(state.mScore)];
+}
+
+int DoubleDummySolver::Search(const FastRollout& state, uint64_t handsHash, unsigned player, int alpha, int beta,
+                              uint64_t& nodes)
+{
+  ++nodes;
+  const bool midTrick = state.mNextPlay % 4 != 0;
+  if (!midTrick && state.mPointsPlayed == kMaxPointsPerHand)
+    return FinalValue(state.mScore, player);
+
+  // The range of values that the points still to be taken allow. Only a player who has taken all of the points so
+  // far can still shoot the moon.
+  const unsigned score = state.mScore[player];
+  const unsigned takers = PointTakers(state.mScore);
+  int low = 2 * int(score) - 13;
+  int high = 2 * int(kMaxPointsPerHand - state.mPointsPlayed + score) - 13;
+  if (score == state.mPointsPlayed)
+    low = kValueIfPlayerShoots;
+  if (takers != 5 && score == 0)
+    high = std::max(high, kValueIfOtherShoots);
+  if (low >= beta)
+    return low;
+  if (high <= alpha)
+    return high;
+
+  // The table holds the positions at the start of tricks, which are the ones that can be reached by different
+  // orders of play. Its entries hold the value less twice the player's score so far.
+  const int offset = 2 * int(score);
+  Entry* entry = 0;
+  uint64_t hash = 0;
+  int tablePlay = -1;
+  if (!midTrick) {
+    hash = PositionHash(state, handsHash, player);
+    entry = &mEntries[hash & mIndexMask];
+    const uint64_t cached = entry->mData.load(std::memory_order_relaxed);
+    if ((cached & kValid) != 0 && (entry->mCheck.load(std::memory_order_relaxed) ^ cached) == hash) {
+      const int value = int(int8_t(cached & 0xff)) + offset;
+      const unsigned bound = (cached >> kBoundShift) & 3;
+      if (bound == kExact)
+        return value;
+      if (bound == kLowerBound) {
+        if (value >= beta)
+          return value;
+        alpha = std::max(alpha, value);
+      } else {
+        if (value <= alpha)
+          return value;
+        beta = std::min(beta, value);
+      }
+      tablePlay = (cached >> kPlayShift) & 0xff;
+    }
+  }
+
+  // The legal plays, without equivalent cards (as in the EndgameSolver), in the order to search them.
+  const unsigned mover = state.CurrentPlayer();
+  const uint64_t inPlay = state.mHands[0] | state.mHands[1] | state.mHands[2] | state.mHands[3]
+                        | (midTrick ? 1ul << state.mHighCard : 0);
+  Card plays[13];
+  int keys[13];
+  unsigned numPlays = 0;
+  int previous = -1;
+  for (uint64_t choices = state.LegalPlays(); choices != 0; choices &= choices - 1) {
+    const Card card = __builtin_ctzl(choices);
+    const bool equivalent = previous >= 0 && SuitOf(previous) == SuitOf(card) && card != kQueenOfSpades
+                         && previous != kQueenOfSpades
+                         && (CardsBetween(previous, card) & inPlay) == 0;
+    previous = card;
+    if (equivalent)
+      continue;
+
+    const int key = card == tablePlay ? 1000 : OrderKey(state, card, midTrick, state.mHighCard);
+    unsigned i = numPlays++;
+    for (; i > 0 && keys[i - 1] < key; --i) {
+      plays[i] = plays[i - 1];
+      keys[i] = keys[i - 1];
+    }
+    plays[i] = card;
+    keys[i] = key;
+  }
+  assert(numPlays > 0);
+
+  // The player minimizes their score, and the other players maximize it.
+  const bool maximize = mover != player;
+  int best = maximize ? -kInfinity : kInfinity;
+  Card bestPlay = plays[0];
+  int a = alpha;
+  int b = beta;
+  for (unsigned i=0; i<numPlays && a < b; ++i) {
+    FastRollout next(state);
+    next.PlayCard(plays[i]);
+    const int value = Search(next, handsHash ^ kZobrist.mHand[mover][plays[i]], player, a, b, nodes);
+    if (maximize ? value > best : value < best) {
+      best = value;
+      bestPlay = plays[i];
+      if (maximize)
+        a = std::max(a, best);
+      else
+        b = std::min(b, best);
+    }
+  }
+
+  if (entry != 0) {
+    const unsigned bound = best <= alpha ? kUpperBound : best >= beta ? kLowerBound : kExact;
+    const uint64_t data = uint64_t(uint8_t(int8_t(best - offset))) | (uint64_t(bound) << kBoundShift)
+                        | (uint64_t(bestPlay) << kPlayShift) | kValid;
+    entry->mData.store(data, std::memory_order_relaxed);
+    entry->mCheck.store(hash ^ data, std::memory_order_relaxed);
+  }
+  return best;
+}
+
+float DoubleDummySolver::Score(const FastRollout& state, unsigned player)
+{
+  uint64_t handsHash = 0;
+  for (unsigned p=0; p<4; ++p) {
+    for (uint64_t hand = state.mHands[p]; hand != 0; hand &= hand - 1)
+      handsHash ^= kZobrist.mHand[p][__builtin_ctzl(hand)];
+  }
+
+  // MTD(f): a series of null-window searches, each of which only finds whether the value is above or below a
+  // guess, converging on the value. Null windows cut off far more than a full window does.
+  uint64_t nodes = 0;
+  int lower = -kInfinity;
+  int upper = kInfinity;
+  int value = 2 * int(state.mScore[player]) - 13;
+  while (lower < upper) {
+    const int beta = value == lower ? value + 1 : value;
+    value = Search(state, handsHash, player, beta - 1, beta, nodes);
+    if (value < beta)
+      upper = value;
+    else
+      lower = value;
+  }
+  mNodes.fetch_add(nodes, std::memory_order_relaxed);
+  return 0.5 * value;
+}
@@ -0,0 +1,62 @@
+// lib/DoubleDummySolver.h
+
+#pragma once
+
+#include "lib/Card.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+class FastRollout;
+
+// DoubleDummySolver finds a player's score for the rest of a game with all four hands known, from any point of
+// the game, when the player plays to minimize their own zero-mean standard score and the other three play together
+// to maximize it. Assuming the worst of the opponents (the "paranoid" assumption) makes the game two-sided, so unlike
+// the max^n search of the EndgameSolver it can be searched with alpha-beta, which is fast enough for whole deals.
+//
+// Moves are generated from the 52-bit hands. Cards of one hand with nothing left between them are equivalent, and
+// only the lowest is searched. Plays are ordered by the best play found in an earlier search of the position, then
+// by simple heuristics (ducking under the high card, discarding points and high cards when void). Positions are
+// cut off as soon as the points still to be taken can't bring the score into the search window.
+//
+// Search results are kept in a transposition table shared by all threads, written without locks as in the
+// EndgameSolver. Values are stored relative to the player's score so far. A position's value relative to that
+// score depends only on which players have taken points, not on how many, so positions reached by different
+// tricks share entries.
+class DoubleDummySolver
+{
+public:
+  ~DoubleDummySolver();
+
+  DoubleDummySolver(unsigned log2Entries = kDefaultLog2Entries);
+
+  static DoubleDummySolver& Shared();
+    // The process-wide solver, created on first use.
+
+  float Score(const FastRollout& state, unsigned player);
+    // The zero-mean standard score of player (as GameOutcome::ZeroMeanStandardScore()) at the end of the game.
+
+  uint64_t NodesSearched() const { return mNodes.load(std::memory_order_relaxed); }
+    // The number of positions searched by all calls so far, including those found in the table.
+
+  static constexpr unsigned kDefaultLog2Entries = 22;
+
+private:
+  struct Entry
+  {
+    std::atomic<uint64_t> mCheck;
+    std::atomic<uint64_t> mData;
+  };
+
+  int Search(const FastRollout& state, uint64_t handsHash, unsigned player, int alpha, int beta, uint64_t& nodes);
+    // Twice player's score, exact if it is within (alpha, beta), otherwise a bound beyond that side of the window.
+
+  uint64_t PositionHash(const FastRollout& state, uint64_t handsHash, unsigned player) const;
+    // The hash of a position at the start of a trick, given the hash of its hands.
+
+private:
+  const uint64_t mIndexMask;
+  std::unique_ptr<Entry[]> mEntries;
+  std::atomic<uint64_t> mNodes;
+};
@@ -0,0 +1,91 @@
+// lib/EndgameDoubleDummy.cpp
+
+#include "lib/EndgameDoubleDummy.h"
+#include "lib/DealSampler.h"
+#include "lib/DoubleDummySolver.h"
+#include "lib/FastRollout.h"
+#include "lib/KnowableState.h"
+#include "lib/PossibilityAnalyzer.h"
+#include "lib/TaskExecutor.h"
+#include "lib/random.h"
+
+#include <algorithm>
+#include <array>
+#include <assert.h>
+
+EndgameDoubleDummy::~EndgameDoubleDummy() {}
+
+EndgameDoubleDummy::EndgameDoubleDummy(unsigned numDeals, unsigned threadBudget)
+    : kNumDeals(numDeals)
+    , kThreadBudget(threadBudget)
+{
+    assert(numDeals > 0);
+}
+
+Card EndgameDoubleDummy::choosePlay(const KnowableState& state, const RandomGenerator& rng) const
+{
+    float playExpectedValue[13];
+    return predictOutcomes(state, rng, playExpectedValue);
+}
+
+Card EndgameDoubleDummy::predictOutcomes(
+    const KnowableState& state, const RandomGenerator& rng, float playExpectedValue[13]) const
+{
+    const CardHand choices = state.LegalPlays();
+    const unsigned kNumChoices = choices.Size();
+    for (unsigned i = 0; i < 13; ++i)
+        playExpectedValue[i] = 0.0;
+
+    if (kNumChoices == 1 || state.PointsPlayed() == kMaxPointsPerHand)
+        return choices.FirstCard();
+
+    const unsigned player = state.CurrentPlayer();
+    const PossibilityAnalyzerPtr analyzer = state.Analyze();
+    const DealSampler sampler(*analyzer);
+    const unsigned kSolvedPlay = kCardsPerDeck - 4 * kMaxSolvedTricks;
+    const bool kSolveNow = state.PlayNumber() >= kSolvedPlay;
+
+    TaskExecutor& executor = TaskExecutor::Shared();
+    const unsigned kNumSlots = kThreadBudget == 0 ? executor.MaxSlots() : std::min(kThreadBudget, executor.MaxSlots());
+
+    // The total scores of each play, per thread working on the deals.
+    std::vector<std::array<double, 13>> slotTotals(kNumSlots);
+    for (std::array<double, 13>& totals : slotTotals)
+        totals.fill(0.0);
+
+    executor.ParallelFor(kNumDeals, kNumSlots, [&](unsigned, unsigned slot) {
+        const RandomGenerator& threadRng = RandomGenerator::ThreadSpecific();
+        CardHands hands;
+        state.PrepareHands(hands);
+        sampler.Sample(threadRng, hands);
+        const FastRollout deal(state, hands);
+
+        CardArray::iterator it(choices);
+        for (unsigned i = 0; i < kNumChoices; ++i)
+        {
+            FastRollout next(deal);
+            next.PlayCard(it.next());
+            if (!kSolveNow)
+                next.PlayRandomly(threadRng, kSolvedPlay);
+            slotTotals[slot][i] += DoubleDummySolver::Shared().Score(next, player);
+        }
+    });
+
+    Card bestPlay = choices.FirstCard();
+    float bestScore = 1e9;
+    CardArray::iterator it(choices);
+    for (unsigned i = 0; i < kNumChoices; ++i)
+    {
+        const Card card = it.next();
+        double total = 0.0;
+        for (const std::array<double, 13>& totals : slotTotals)
+            total += totals[i];
+        playExpectedValue[i] = total / kNumDeals;
+        if (playExpectedValue[i] < bestScore)
+        {
+            bestScore = playExpectedValue[i];
+            bestPlay = card;
+        }
+    }
+    return bestPlay;
+}
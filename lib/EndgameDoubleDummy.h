@@ -0,0 +1,33 @@
+// lib/EndgameDoubleDummy.h
+
+#pragma once
+
+#include "lib/Strategy.h"
+
+// EndgameDoubleDummy is perfect-information Monte Carlo for the end of a game: for each decision it samples deals of
+// the unknown cards with the PossibilityAnalyzer, solves each legal play of each deal with the DoubleDummySolver, and
+// chooses the play with the best mean score. Solving whole deals takes too long, so the deals are solved from the
+// current play only once kMaxSolvedTricks tricks remain. Before that, each play of a deal is followed by random plays
+// up to that point, so earlier choices are only as good as random rollouts: it is meant as an endgame player, to
+// compare with the endgame of other strategies, rather than for whole games.
+class EndgameDoubleDummy : public Strategy
+{
+public:
+    virtual ~EndgameDoubleDummy();
+
+    EndgameDoubleDummy(unsigned numDeals, unsigned threadBudget = 0);
+    // The deals are solved on the process-wide TaskExecutor, using at most threadBudget threads, as for MonteCarlo.
+
+    virtual Card choosePlay(const KnowableState& state, const RandomGenerator& rng) const;
+
+    virtual Card predictOutcomes(
+        const KnowableState& state, const RandomGenerator& rng, float playExpectedValue[13]) const;
+    // playExpectedValue[i] is the mean zero-mean standard score of the i-th legal play over the sampled deals.
+
+    static constexpr unsigned kMaxSolvedTricks = 6;
+    // Solving a deal takes about seven times longer for each additional trick, about 1.2 ms for 6 tricks.
+
+private:
+    const unsigned kNumDeals;
+    const unsigned kThreadBudget;
+};
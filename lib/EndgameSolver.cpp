@@ -0,0 +1,184 @@
+// lib/EndgameSolver.cpp
+
+#include "lib/EndgameSolver.h"
+#include "lib/FastRollout.h"
+#include "lib/SplitMix64.h"
+
+#include <assert.h>
+
+namespace {
+
+const uint64_t kValid = 1ul << 63;
+const unsigned kPlayShift = 32;
+
+// One random key for each value of each part of a position. A position's hash is the xor of the keys of its parts.
+struct ZobristKeys
+{
+  ZobristKeys()
+  {
+    uint64_t seed = 0x48656172747321ul;
+    FillRandomKeys(mHand, seed);
+    FillRandomKeys(mScore, seed);
+    FillRandomKeys(mLead, seed);
+    FillRandomKeys(mHighPlayer, seed);
+    FillRandomKeys(mHighCard, seed);
+    FillRandomKeys(mPointsOnTable, seed);
+  }
+
+  uint64_t mHand[4][kCardsPerDeck];
+  uint64_t mScore[4][kMaxPointsPerHand + 1];
+  uint64_t mLead[4];
+  uint64_t mHighPlayer[4];
+  uint64_t mHighCard[kCardsPerDeck];
+  uint64_t mPointsOnTable[kMaxPointsPerHand + 1];
+};
+
+const ZobristKeys kZobrist;
+
+inline unsigned FinalScore(uint64_t data, unsigned player)
+{
+  return (data >> (8*player)) & 0xff;
+}
+
+inline float StandardScore(uint64_t data, unsigned player)
+{
+  // As GameOutcome::ZeroMeanStandardScore(): whoever takes all of the points shot the moon.
+  for (unsigned p=0; p<4; ++p) {
+    if (FinalScore(data, p) == kMaxPointsPerHand)
+      return p == player ? -19.5 : 6.5;
+  }
+  return float(FinalScore(data, player)) - 6.5;
+}
+
+inline uint64_t CardsBetween(Card low, Card high)
+{
+  return ((1ul << high) - 1) & ~((2ul << low) - 1);
+}
+
+}  // namespace
+
+EndgameSolver::~EndgameSolver() {}
+
+EndgameSolver::EndgameSolver(unsigned log2Entries)
+: mIndexMask((1ul << log2Entries) - 1)
+, mEntries(new Entry[1ul << log2Entries])
+{
+  for (uint64_t i=0; i<=mIndexMask; ++i) {
+    mEntries[i].mCheck.store(0, std::memory_order_relaxed);
+    mEntries[i].mData.store(0, std::memory_order_relaxed);
+  }
+}
+
+EndgameSolver& EndgameSolver::Shared()
+{
+  static EndgameSolver solver;
+  return solver;
+}
+
+uint64_t EndgameSolver::HashOfHands(const FastRollout& state) const
+{
+  uint64_t hash = 0;
+  for (unsigned p=0; p<4; ++p) {
+    for (uint64_t hand = state.mHands[p]; hand != 0; hand &= hand - 1)
+      hash ^= kZobrist.mHand[p][__builtin_ctzl(hand)];
+  }
+  return hash;
+}
+
+uint64_t EndgameSolver::Hash(const FastRollout& state) const
+{
+  return PositionHash(state, HashOfHands(state));
+}
+
+uint64_t EndgameSolver::PositionHash(const FastRollout& state, uint64_t handsHash) const
+{
+  // The play number and the trick suit follow from the hands and the high card, and the points played are the
+  // sum of the scores. Only the high card of the trick in progress matters to the rest of the game.
+  uint64_t hash = handsHash ^ kZobrist.mLead[state.mLead];
+  for (unsigned p=0; p<4; ++p)
+    hash ^= kZobrist.mScore[p][state.mScore[p]];
+  if (state.mNextPlay % 4 != 0) {
+    hash ^= kZobrist.mHighCard[state.mHighCard] ^ kZobrist.mHighPlayer[state.mHighPlayer]
+          ^ kZobrist.mPointsOnTable[state.mPointsOnTable];
+  }
+  return hash;
+}
+
+uint64_t EndgameSolver::Search(const FastRollout& state, uint64_t handsHash)
+{
+  uint64_t scores = 0;
+  for (unsigned p=0; p<4; ++p)
+    scores |= uint64_t(state.mScore[p]) << (8*p);
+
+  // Once all of the points have been taken, the remaining plays can't change the outcome.
+  if (state.mNextPlay % 4 == 0 && (state.mPointsPlayed == kMaxPointsPerHand || state.Done()))
+    return scores;
+
+  const uint64_t hash = PositionHash(state, handsHash);
+  Entry& entry = mEntries[hash & mIndexMask];
+  const uint64_t cached = entry.mData.load(std::memory_order_relaxed);
+  if ((cached & kValid) != 0 && (entry.mCheck.load(std::memory_order_relaxed) ^ cached) == hash)
+    return cached;
+
+  const unsigned player = state.CurrentPlayer();
+  const bool midTrick = state.mNextPlay % 4 != 0;
+  const uint64_t inPlay = state.mHands[0] | state.mHands[1] | state.mHands[2] | state.mHands[3]
+                        | (midTrick ? 1ul << state.mHighCard : 0);
+
+  uint64_t best = 0;
+  float bestScore = 0.0;
+  int previous = -1;
+  for (uint64_t choices = state.LegalPlays(); choices != 0; choices &= choices - 1) {
+    const Card card = __builtin_ctzl(choices);
+
+    // A card is equivalent to the next lower legal play when it has the same suit and points, and every
+    // card between them has been played (other than a high card on the table, which they compare differently to).
+    const bool equivalent = previous >= 0 && SuitOf(previous) == SuitOf(card) && PointsFor(previous) == PointsFor(card)
+                         && (CardsBetween(previous, card) & inPlay) == 0;
+    previous = card;
+    if (equivalent)
+      continue;
+
+    FastRollout next(state);
+    next.PlayCard(card);
+    const uint64_t result = Search(next, handsHash ^ kZobrist.mHand[player][card]);
+    const float score = StandardScore(result, player);
+    if (best == 0 || score < bestScore) {
+      best = (result & 0xffffffff) | (uint64_t(card) << kPlayShift) | kValid;
+      bestScore = score;
+    }
+  }
+  assert(best != 0);
+
+  entry.mData.store(best, std::memory_order_relaxed);
+  entry.mCheck.store(hash ^ best, std::memory_order_relaxed);
+  return best;
+}
+
+GameOutcome EndgameSolver::Solve(const FastRollout& state)
+{
+  const uint64_t result = Search(state, HashOfHands(state));
+
+  // GameOutcome only distinguishes players with no point tricks from players with some.
+  std::array<unsigned, 4> scores;
+  unsigned pointTricks[4];
+  for (unsigned p=0; p<4; ++p) {
+    scores[p] = FinalScore(result, p);
+    pointTricks[p] = state.mPointTricks[p] + (scores[p] > state.mScore[p] ? 1 : 0);
+  }
+
+  GameOutcome outcome;
+  outcome.Set(pointTricks, scores);
+  return outcome;
+}
+
+Card EndgameSolver::BestPlay(const FastRollout& state)
+{
+  assert(!state.Done());
+  const uint64_t result = Search(state, HashOfHands(state));
+  if ((result & kValid) == 0) {
+    // All of the points have been taken, so any legal play is as good as any other.
+    return __builtin_ctzl(state.LegalPlays());
+  }
+  return Card(result >> kPlayShift);
+}
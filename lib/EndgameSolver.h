@@ -0,0 +1,66 @@
+// lib/EndgameSolver.h
+
+#pragma once
+
+#include "lib/Card.h"
+#include "lib/GameOutcome.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+
+class FastRollout;
+
+// EndgameSolver finds the outcome of the rest of a game with all four hands known, when each player plays to
+// minimize their own standard score (GameOutcome::ZeroMeanStandardScore()). With four players there is no single
+// value to minimax, so this is a max^n search: the player to move takes the play whose outcome is best for them,
+// and ties go to the lowest card. Cards held by one player with nothing left between them (such as the 9 and 10
+// of a suit after the other cards between them are played) are equivalent, and only the lowest is searched.
+//
+// The results of all positions searched are kept in a transposition table shared by all threads. Each entry is
+// written and read without locks, as two 64-bit words, the first being the position's Zobrist hash xor the second.
+// An entry torn by a concurrent write does not verify, and is treated as a miss.
+//
+// The search is exponential in the number of tricks left, so it is meant for the last few tricks of a rollout.
+class EndgameSolver
+{
+public:
+  ~EndgameSolver();
+
+  EndgameSolver(unsigned log2Entries = kDefaultLog2Entries);
+
+  static EndgameSolver& Shared();
+    // The process-wide solver, created on first use. All of the rollouts of a process share its table.
+
+  GameOutcome Solve(const FastRollout& state);
+    // The outcome of the game when every remaining play is the one the search chooses.
+
+  Card BestPlay(const FastRollout& state);
+    // The play the search chooses for the current player. The state must not be done.
+
+  uint64_t Hash(const FastRollout& state) const;
+    // The Zobrist hash of the state: its hands, lead, scores and the cards that matter of the trick in progress.
+
+  static constexpr unsigned kDefaultLog2Entries = 20;
+  static constexpr unsigned kMaxTricks = 5;
+    // Solving more than kMaxTricks tricks takes too long to be useful in rollouts.
+
+private:
+  struct Entry
+  {
+    std::atomic<uint64_t> mCheck;
+    std::atomic<uint64_t> mData;
+  };
+
+  uint64_t Search(const FastRollout& state, uint64_t handsHash);
+    // Returns the final scores (one byte per player) and the chosen play, packed as in the table entries.
+
+  uint64_t HashOfHands(const FastRollout& state) const;
+
+  uint64_t PositionHash(const FastRollout& state, uint64_t handsHash) const;
+    // Hash(), given the hash of the hands, which Search() updates as cards are played.
+
+private:
+  const uint64_t mIndexMask;
+  std::unique_ptr<Entry[]> mEntries;
+};
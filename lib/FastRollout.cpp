@@ -0,0 +1,170 @@
+// lib/FastRollout.cpp
+
+#include "lib/FastRollout.h"
+#include "lib/GameState.h"
+#include "lib/HeartsState.h"
+#include "lib/random.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace {
+  const Card kTwoOfClubs = CardFor(kTwo, kClubs);
+  const Card kQueenOfSpades = CardFor(kQueen, kSpades);
+
+  inline unsigned PointsInMask(uint64_t cards) {
+    return CountBits(cards & kAllHeartsMask) + (((cards >> kQueenOfSpades) & 1) ? 13 : 0);
+  }
+}
+
+FastRollout::FastRollout(const GameState& state)
+: FastRollout(state, CardHands())
+{
+  for (unsigned p=0; p<4; ++p)
+    mHands[p] = state.HandForPlayer(p).Bits();
+}
+
+FastRollout::FastRollout(const HeartsState& state, const CardHands& hands)
+: mNextPlay(state.PlayNumber())
+, mLead(state.PlayerLeadingTrick())
+, mTrickSuitMask(0)
+, mHighCard(0)
+, mHighPlayer(0)
+, mPointsOnTable(0)
+, mPointsPlayed(state.PointsPlayed())
+, mFirstTrickWinner(-1)
+, mScore(state.PointsSoFar())
+{
+  for (unsigned p=0; p<4; ++p) {
+    mHands[p] = hands[p].Bits();
+    mPointTricks[p] = state.GetPointTricksFor(p);
+  }
+
+  const unsigned playInTrick = state.PlayInTrick();
+  if (playInTrick > 0) {
+    mTrickSuitMask = CardArray::SuitMask(state.TrickSuit());
+    mHighCard = state.HighCardOnTable();
+    for (unsigned i=0; i<playInTrick; ++i) {
+      const Card card = state.GetTrickPlay(i);
+      mPointsOnTable += PointsFor(card);
+      if (card == mHighCard)
+        mHighPlayer = (mLead + i) % 4;
+    }
+  }
+}
+
+FastRollout::FastRollout(const PackedGameState& state)
+: mNextPlay(state.mNextPlay)
+, mLead(state.mLead)
+, mTrickSuitMask(0)
+, mHighCard(0)
+, mHighPlayer(0)
+, mPointsOnTable(0)
+, mPointsPlayed(0)
+, mFirstTrickWinner(-1)
+{
+  for (unsigned p=0; p<4; ++p) {
+    mHands[p] = state.mHands[p];
+    mScore[p] = state.mScore[p];
+    mPointTricks[p] = state.mPointTricks[p];
+    mPointsPlayed += state.mScore[p];
+  }
+
+  const unsigned playInTrick = state.PlayInTrick();
+  if (playInTrick > 0) {
+    mTrickSuitMask = CardArray::SuitMask(SuitOf(state.mTrick[0]));
+    mHighCard = state.mTrick[0];
+    for (unsigned i=0; i<playInTrick; ++i) {
+      const Card card = state.mTrick[i];
+      mPointsOnTable += PointsFor(card);
+      if (SuitOf(card) == SuitOf(mHighCard) && card >= mHighCard) {
+        mHighCard = card;
+        mHighPlayer = (mLead + i) % 4;
+      }
+    }
+  }
+}
+
+uint64_t FastRollout::LegalPlays() const
+{
+  if (mNextPlay == 0)
+    return 1ul << kTwoOfClubs;
+
+  const uint64_t hand = mHands[CurrentPlayer()];
+  uint64_t choices;
+  if (mNextPlay % 4 == 0)
+    choices = mPointsPlayed == 0 ? hand & kNonPointCardsMask : hand;
+  else
+    choices = hand & mTrickSuitMask;
+
+  if (choices == 0) {
+    // No points may be played in the first trick, unless the hand holds nothing else.
+    if (mNextPlay < 4)
+      choices = hand & kNonPointCardsMask;
+    if (choices == 0)
+      choices = hand;
+  }
+
+  assert(choices != 0);
+  return choices;
+}
+
+void FastRollout::PlayCard(Card card)
+{
+  const unsigned player = CurrentPlayer();
+  const uint64_t bit = 1ul << card;
+  assert((LegalPlays() & bit) != 0);
+  mHands[player] &= ~bit;
+
+  if (mNextPlay % 4 == 0) {
+    mTrickSuitMask = CardArray::SuitMask(SuitOf(card));
+    mHighCard = card;
+    mHighPlayer = player;
+    mPointsOnTable = 0;
+  } else if ((mTrickSuitMask & bit) != 0 && card > mHighCard) {
+    mHighCard = card;
+    mHighPlayer = player;
+  }
+  mPointsOnTable += PointsInMask(bit);
+
+  ++mNextPlay;
+  if (mNextPlay % 4 == 0) {
+    // The trick is complete. The winner takes the points and leads the next trick.
+    if (mFirstTrickWinner < 0)
+      mFirstTrickWinner = mHighPlayer;
+    if (mPointsOnTable != 0) {
+      mScore[mHighPlayer] += mPointsOnTable;
+      mPointTricks[mHighPlayer] += 1;
+      mPointsPlayed += mPointsOnTable;
+    }
+    mLead = mHighPlayer;
+  }
+}
+
+GameOutcome FastRollout::PlayOutRandomly(const RandomGenerator& rng)
+{
+  PlayRandomly(rng, kCardsPerDeck);
+  return Outcome();
+}
+
+void FastRollout::PlayRandomly(const RandomGenerator& rng, unsigned endPlay)
+{
+  // Once all of the points have been taken, the remaining plays can't change the outcome. This is always the
+  // case at a trick boundary, so the first trick win (if pending) has been determined by then too.
+  while (!(mNextPlay % 4 == 0 && (mPointsPlayed == kMaxPointsPerHand || mNextPlay >= endPlay))) {
+    const uint64_t choices = LegalPlays();
+    const unsigned numChoices = CountBits(choices);
+    const unsigned choice = numChoices == 1 ? 0 : unsigned(rng.range64(numChoices));
+    PlayCard(NthSetBitIndex(choices, choice));
+  }
+}
+
+GameOutcome FastRollout::Outcome() const
+{
+  assert(mPointsPlayed == kMaxPointsPerHand);
+  GameOutcome outcome;
+  unsigned pointTricks[4];
+  std::copy(mPointTricks, mPointTricks + 4, pointTricks);
+  outcome.Set(pointTricks, mScore);
+  return outcome;
+}
@@ -0,0 +1,67 @@
+// lib/FastRollout.h
+
+#pragma once
+
+#include "lib/Card.h"
+#include "lib/CardArray.h"
+#include "lib/GameOutcome.h"
+#include "lib/PackedGameState.h"
+
+#include <array>
+
+class GameState;
+class HeartsState;
+
+// FastRollout plays out the rest of a game with uniformly random legal plays. It gives the same outcomes as
+// GameState::PlayOutGameMonteCarlo() with the RandomStrategy, but works directly on the four 52-bit hands.
+// It keeps only what the rules and scoring need: no KnowableState is constructed, there are no hooks, and
+// voids and unplayed cards are not tracked. It is a small value type, so copying one for each legal play
+// is cheap.
+class FastRollout
+{
+public:
+  FastRollout(const HeartsState& state, const CardHands& hands);
+  FastRollout(const GameState& state);
+  FastRollout(const PackedGameState& state);
+
+  unsigned CurrentPlayer() const { return (mLead + mNextPlay) % 4; }
+  bool Done() const { return mNextPlay == kCardsPerDeck; }
+
+  uint64_t LegalPlays() const;
+    // The mask of cards in HeartsState::LegalPlays(), except that all legal plays are returned when all
+    // of the points have been played.
+
+  void PlayCard(Card card);
+    // card must be one of LegalPlays().
+
+  GameOutcome PlayOutRandomly(const RandomGenerator& rng);
+    // Plays uniformly random legal plays until all points have been taken, and returns the outcome.
+
+  void PlayRandomly(const RandomGenerator& rng, unsigned endPlay);
+    // Plays uniformly random legal plays until the first trick boundary at or after play number endPlay, or until
+    // all points have been taken. With endPlay kCardsPerDeck, this is PlayOutRandomly() without the outcome.
+
+  GameOutcome Outcome() const;
+    // The outcome, once all of the points have been taken.
+
+  int FirstTrickWinner() const { return mFirstTrickWinner; }
+    // The player who won the first trick completed by this FastRollout (or a copy of it), -1 if none yet.
+    // This is the trick win that MonteCarlo tracks for the play that starts a rollout.
+
+private:
+  friend class DoubleDummySolver;
+  friend class EndgameSolver;
+  friend class MultiRollout;
+
+  uint64_t mHands[4];
+  unsigned mNextPlay;
+  unsigned mLead;
+  uint64_t mTrickSuitMask;
+  Card mHighCard;
+  unsigned mHighPlayer;
+  unsigned mPointsOnTable;
+  unsigned mPointsPlayed;
+  int mFirstTrickWinner;
+  std::array<unsigned, 4> mScore;
+  unsigned mPointTricks[4];
+};
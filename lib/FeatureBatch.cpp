@@ -0,0 +1,27 @@
+// lib/FeatureBatch.cpp
+
+#include "lib/FeatureBatch.h"
+#include "lib/KnowableState.h"
+
+#include <algorithm>
+
+namespace {
+
+// Enough states per task that claiming a task costs little next to encoding them, while a batch of a few
+// thousand states still has tasks for every thread.
+const size_t kStatesPerTask = 64;
+
+}  // namespace
+
+void EncodeFeatureBatch(const PackedKnowableState* states, size_t numStates, float* rows
+                      , bool exactProbabilities, TaskExecutor& executor)
+{
+  const unsigned numTasks = unsigned((numStates + kStatesPerTask - 1) / kStatesPerTask);
+  executor.ParallelFor(numTasks, executor.MaxSlots(), [&](unsigned task, unsigned) {
+    const size_t end = std::min(numStates, (task + 1) * kStatesPerTask);
+    for (size_t i = task * kStatesPerTask; i < end; ++i) {
+      const KnowableState state(states[i]);
+      state.EncodeFeatures(rows + i * KnowableState::kNumFeatures, exactProbabilities);
+    }
+  });
+}
@@ -0,0 +1,13 @@
+// lib/FeatureBatch.h
+
+#pragma once
+
+#include "lib/PackedKnowableState.h"
+#include "lib/TaskExecutor.h"
+
+#include <stddef.h>
+
+void EncodeFeatureBatch(const PackedKnowableState* states, size_t numStates, float* rows
+                      , bool exactProbabilities = false, TaskExecutor& executor = TaskExecutor::Shared());
+  // Writes the KnowableState::kNumFeatures floats of KnowableState::EncodeFeatures() for each of the states, to
+  // consecutive rows, e.g. of a training batch. The states are encoded in parallel, in chunks, on the executor.
@@ -0,0 +1,73 @@
+// lib/GameBatch.cpp
+
+#include "lib/GameBatch.h"
+#include "lib/Deal.h"
+#include "lib/DealSampler.h"
+#include "lib/FastRollout.h"
+#include "lib/GameState.h"
+#include "lib/KnowableState.h"
+#include "lib/random.h"
+
+#include <algorithm>
+
+namespace {
+
+// As in EncodeFeatureBatch(): deals and rollouts are quick, so each task takes a chunk of the batch.
+const size_t kItemsPerTask = 64;
+
+template <typename Function>
+void ForEachInChunks(size_t numItems, TaskExecutor& executor, const Function& function)
+{
+  const unsigned numTasks = unsigned((numItems + kItemsPerTask - 1) / kItemsPerTask);
+  executor.ParallelFor(numTasks, executor.MaxSlots(), [&](unsigned task, unsigned) {
+    const size_t end = std::min(numItems, (task + 1) * kItemsPerTask);
+    for (size_t i = task * kItemsPerTask; i < end; ++i)
+      function(i);
+  });
+}
+
+}  // namespace
+
+void DealBatch(const uint64_t* dealIndexes, size_t numDeals, PackedGameState* states, TaskExecutor& executor)
+{
+  ForEachInChunks(numDeals, executor, [&](size_t i) {
+    const uint128_t index = (uint128_t(dealIndexes[2*i + 1]) << 64) | dealIndexes[2*i];
+    states[i] = PackedGameState(GameState(Deal(index)));
+  });
+}
+
+void RolloutBatch(const PackedGameState* states, size_t numStates, unsigned numRollouts, uint64_t seed
+                , float* points, TaskExecutor& executor)
+{
+  ForEachInChunks(numStates, executor, [&](size_t i) {
+    const RandomGenerator rng(seed + i);
+    const FastRollout start(states[i]);
+    unsigned totals[4] = {0, 0, 0, 0};
+    for (unsigned r = 0; r < numRollouts; ++r) {
+      FastRollout rollout(start);
+      const GameOutcome outcome = rollout.PlayOutRandomly(rng);
+      for (unsigned p = 0; p < 4; ++p)
+        totals[p] += outcome.PointsTaken(p);
+    }
+    for (unsigned p = 0; p < 4; ++p)
+      points[4*i + p] = numRollouts == 0 ? 0.0f : float(totals[p]) / numRollouts;
+  });
+}
+
+void SampleDealBatch(const PackedKnowableState* states, size_t numStates, unsigned samplesPerState, uint64_t seed
+                   , PackedGameState* deals, TaskExecutor& executor)
+{
+  // Each state is a task of its own, since building its analyzer costs as much as many samples.
+  executor.ParallelFor(unsigned(numStates), executor.MaxSlots(), [&](unsigned i, unsigned) {
+    const RandomGenerator rng(seed + i);
+    const KnowableState state(states[i]);
+    const PossibilityAnalyzerPtr analyzer = state.Analyze();
+    const DealSampler sampler(*analyzer);
+    for (unsigned s = 0; s < samplesPerState; ++s) {
+      CardHands hands;
+      state.PrepareHands(hands);
+      sampler.Sample(rng, hands);
+      deals[size_t(i) * samplesPerState + s] = PackedGameState(GameState(hands, state));
+    }
+  });
+}
@@ -0,0 +1,31 @@
+// lib/GameBatch.h
+
+#pragma once
+
+#include "lib/PackedGameState.h"
+#include "lib/PackedKnowableState.h"
+#include "lib/TaskExecutor.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Batch versions of the engine's game operations, for training input pipelines (see PythonModule.cpp). Like
+// EncodeFeatureBatch(), each works on plain arrays and runs in parallel on the executor. The random ones take a
+// seed: item i uses RandomGenerator(seed + i), so the results do not depend on the threads.
+
+void DealBatch(const uint64_t* dealIndexes, size_t numDeals, PackedGameState* states
+             , TaskExecutor& executor = TaskExecutor::Shared());
+  // The start of the game for each Deal index. The indexes are two uint64s each, the low half first, and must be
+  // less than Deal::NumPossibleDeals().
+
+void RolloutBatch(const PackedGameState* states, size_t numStates, unsigned numRollouts, uint64_t seed
+                , float* points, TaskExecutor& executor = TaskExecutor::Shared());
+  // Plays each state out randomly numRollouts times, as FastRollout::PlayOutRandomly() does, and writes the mean
+  // points taken by each of the four players (GameOutcome::PointsTaken()), four floats per state.
+  // The states must be IsValid().
+
+void SampleDealBatch(const PackedKnowableState* states, size_t numStates, unsigned samplesPerState, uint64_t seed
+                   , PackedGameState* deals, TaskExecutor& executor = TaskExecutor::Shared());
+  // Samples samplesPerState deals of the unknown cards for each knowable state, each possible deal equally likely
+  // (as DealSampler does), and writes the game states, samplesPerState consecutive ones per state.
+  // The states must be IsValid().
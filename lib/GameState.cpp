@@ -1,5 +1,7 @@
 #include "lib/GameState.h"
 #include "lib/Annotator.h"
+#include "lib/EndgameSolver.h"
+#include "lib/FastRollout.h"
 #include "lib/KnowableState.h"
 #include "lib/RandomStrategy.h"
 
@@ -75,6 +77,14 @@ GameState::GameState(const CardHands& hands, const KnowableState& knowableState)
   VerifyGameState();
 }
 
+GameState::GameState(const PackedGameState& packed)
+    : HeartsState(packed)
+{
+  for (int i = 0; i < 4; i++)
+    mHands[i] = CardHand(packed.mHands[i], kEmpty);
+  VerifyGameState();
+}
+
 void GameState::VerifyGameState() const
 {
 #ifndef NDEBUG
@@ -106,15 +116,95 @@ GameOutcome GameState::PlayGame(StrategyPtr players[4], const RandomGenerator& r
 // This is how we do one "rollout" to the end of the game.
 // The strategy passed in here should be an "intuition" strategy,
 // either the RandomStrategy or the DnnModelIntuition strategy.
-GameOutcome GameState::PlayOutGameMonteCarlo(const StrategyPtr& opponent, const RandomGenerator& rng)
+GameOutcome GameState::PlayOutGameMonteCarlo(const StrategyPtr& opponent, const RandomGenerator& rng,
+    unsigned endgameTricks)
 {
   while (!Done())
   {
+    if (endgameTricks > 0 && InEndgame(endgameTricks))
+    {
+      PlayOutEndgame();
+      break;
+    }
     NextPlay(opponent, rng);
   }
   return CheckForShootTheMoon();
 }
 
+void GameState::PlayOutEndgame()
+{
+  // The plays are made one at a time, so that the hooks and the trick winner tracking see them.
+  // After the first, the solver finds each play in its table.
+  EndgameSolver& solver = EndgameSolver::Shared();
+  while (!Done())
+  {
+    const CardHand choices = LegalPlays();
+    if (PointsPlayed() != 26 && choices.Size() > 1)
+      PlayCard(solver.BestPlay(FastRollout(*this)));
+    else
+      PlayCard(choices.FirstCard());
+  }
+}
+
+bool GameState::AdvanceToNextDecision()
+{
+  while (!Done())
+  {
+    const CardHand choices = LegalPlays();
+    if (PointsPlayed() != 26 && choices.Size() > 1)
+      return true;
+    PlayCard(choices.FirstCard());
+  }
+  return false;
+}
+
+void GameState::PlayOutGamesInLockStep(std::vector<GameState>& games, const StrategyPtr& intuition,
+    const RandomGenerator& rng, unsigned endgameTricks)
+{
+  std::vector<unsigned> pending;
+  std::vector<KnowableState> states;
+  std::vector<Card> plays;
+  pending.reserve(games.size());
+  states.reserve(games.size());
+  plays.resize(games.size());
+
+  // A game whose next decision is in the endgame is played out by the solver instead of the intuition.
+  auto advance = [endgameTricks](GameState& game) {
+    if (!game.AdvanceToNextDecision())
+      return false;
+    if (endgameTricks == 0 || !game.InEndgame(endgameTricks))
+      return true;
+    game.PlayOutEndgame();
+    return false;
+  };
+
+  for (unsigned i = 0; i < games.size(); ++i)
+  {
+    if (advance(games[i]))
+      pending.push_back(i);
+  }
+
+  while (!pending.empty())
+  {
+    states.clear();
+    for (unsigned i : pending)
+      states.emplace_back(games[i]);
+
+    intuition->choosePlays(states, rng, plays.data());
+
+    unsigned stillPending = 0;
+    for (unsigned j = 0; j < pending.size(); ++j)
+    {
+      GameState& game = games[pending[j]];
+      assert(game.LegalPlays().HasCard(plays[j]));
+      game.PlayCard(plays[j]);
+      if (advance(game))
+        pending[stillPending++] = pending[j];
+    }
+    pending.resize(stillPending);
+  }
+}
+
 void GameState::PrintPlay(int player, Card card) const
 {
   const char* name = NameOf(card);
@@ -21,6 +21,9 @@ public:
 
   GameState(const CardHands& hands, const KnowableState& knowableState);
 
+  GameState(const PackedGameState& packed);
+    // The unpacked state has no hooks, and deal index 0.
+
   void SetPlayCardHook(PlayCardHook hook) { mPlayCardHook = hook; }
   void SetTrickResultHook(TrickResultHook hook) { mTrickResultHook = hook; }
 
@@ -33,10 +36,28 @@ public:
   void PlayCard(Card nextCardPlayed);
   // Advances the game to the next state
 
-  GameOutcome PlayOutGameMonteCarlo(const StrategyPtr& opponent, const RandomGenerator& rng);
+  GameOutcome PlayOutGameMonteCarlo(const StrategyPtr& opponent, const RandomGenerator& rng,
+      unsigned endgameTricks = 0);
   // Plays out the rest of this game using random legal moves at each step.
   // Return in finalScores the final outcome with mean zero scores.
   // Return in pointTricks the count of points-with-tricks won by each player
+  // The last endgameTricks tricks are played by the EndgameSolver instead of the opponent strategy.
+
+  static void PlayOutGamesInLockStep(std::vector<GameState>& games, const StrategyPtr& intuition,
+      const RandomGenerator& rng, unsigned endgameTricks = 0);
+  // Plays out all of the given games to the end, like PlayOutGameMonteCarlo(), but advances the games in lock step
+  // so that all of the pending decisions of one round are made by a single call to intuition->choosePlays().
+  // The caller is responsible for calling CheckForShootTheMoon() on each game to get its outcome.
+
+  bool InEndgame(unsigned endgameTricks) const { return PlayNumber() + 4 * endgameTricks >= kCardsPerDeck; }
+  // True when no more than endgameTricks tricks remain, counting the trick in progress.
+
+  void PlayOutEndgame();
+  // Plays the rest of the game with the plays chosen by the shared EndgameSolver.
+
+  bool AdvanceToNextDecision();
+  // Make any forced plays (only one legal play, or all points already played) until either the game is done
+  // or the current player has a real choice to make. Returns true if a choice is pending.
 
   void PrintState() const;
 
@@ -0,0 +1,20 @@
+// lib/HeartsCApi.cpp
+
+#include "lib/HeartsCApi.h"
+#include "lib/FeatureBatch.h"
+#include "lib/KnowableState.h"
+
+size_t heartsnn_packed_knowable_state_bytes(void)
+{
+  return sizeof(PackedKnowableState);
+}
+
+size_t heartsnn_num_features(void)
+{
+  return KnowableState::kNumFeatures;
+}
+
+void heartsnn_encode_features(const void* states, size_t numStates, float* rows, int exactProbabilities)
+{
+  EncodeFeatureBatch(static_cast<const PackedKnowableState*>(states), numStates, rows, exactProbabilities != 0);
+}
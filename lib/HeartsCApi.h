@@ -0,0 +1,26 @@
+// lib/HeartsCApi.h
+
+#pragma once
+
+#include <stddef.h>
+
+// A C interface to the engine, built as the shared library libheartsnn, so that python can call it with ctypes
+// (see python/featurize.py). The arrays are plain buffers, such as the data of numpy arrays, so a whole batch is
+// handled in one call.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+size_t heartsnn_packed_knowable_state_bytes(void);
+  // sizeof(PackedKnowableState), to check that the caller's layout agrees.
+
+size_t heartsnn_num_features(void);
+  // KnowableState::kNumFeatures, the floats of each row of features.
+
+void heartsnn_encode_features(const void* states, size_t numStates, float* rows, int exactProbabilities);
+  // EncodeFeatureBatch(): states is numStates PackedKnowableStates, and rows has room for numStates rows.
+
+#ifdef __cplusplus
+}
+#endif
@@ -42,6 +42,55 @@ HeartsState::HeartsState(const HeartsState& other)
   VerifyHeartsState();
 }
 
+HeartsState::HeartsState(const PackedGameState& packed)
+    : mDealIndex(0)
+    , mNextPlay(packed.mNextPlay)
+    , mLead(packed.mLead)
+    , mTrickSuit(packed.PlayInTrick() == 0 ? kUnknown : SuitOf(packed.mTrick[0]))
+    , mPointsPlayed(0)
+    , mIsVoidBits(packed.mVoidBits)
+    , mUnplayedCards(packed.mHands[0] | packed.mHands[1] | packed.mHands[2] | packed.mHands[3], kEmpty)
+    , mTrackTrickWinsAtPlay(-1)
+    , mTrackTrickWinsForPlayer(-1)
+    , mTrackTrickWinsCounter(0)
+{
+  // The cards on the table have been played, so the unplayed cards are exactly the cards still in the hands.
+  bzero(mPlays, sizeof(mPlays));
+  for (unsigned i = 0; i < packed.PlayInTrick(); ++i)
+    mPlays[i] = packed.mTrick[i];
+  for (unsigned p = 0; p < 4; ++p)
+  {
+    mScore[p] = packed.mScore[p];
+    mPointTricks[p] = packed.mPointTricks[p];
+    mPointsPlayed += packed.mScore[p];
+  }
+  VerifyHeartsState();
+}
+
+HeartsState::HeartsState(const PackedKnowableState& packed)
+    : mDealIndex(0)
+    , mNextPlay(packed.mNextPlay)
+    , mLead(packed.mLead)
+    , mTrickSuit(packed.PlayInTrick() == 0 ? kUnknown : SuitOf(packed.mTrick[0]))
+    , mPointsPlayed(0)
+    , mIsVoidBits(packed.mVoidBits)
+    , mUnplayedCards(packed.mUnplayed, kEmpty)
+    , mTrackTrickWinsAtPlay(-1)
+    , mTrackTrickWinsForPlayer(-1)
+    , mTrackTrickWinsCounter(0)
+{
+  bzero(mPlays, sizeof(mPlays));
+  for (unsigned i = 0; i < packed.PlayInTrick(); ++i)
+    mPlays[i] = packed.mTrick[i];
+  for (unsigned p = 0; p < 4; ++p)
+  {
+    mScore[p] = packed.mScore[p];
+    mPointTricks[p] = packed.mPointTricks[p];
+    mPointsPlayed += packed.mScore[p];
+  }
+  VerifyHeartsState();
+}
+
 void HeartsState::VerifyHeartsState() const
 {
 #ifndef NDEBUG
@@ -3,6 +3,8 @@
 #include "lib/Card.h"
 #include "lib/CardArray.h"
 #include "lib/GameOutcome.h"
+#include "lib/PackedGameState.h"
+#include "lib/PackedKnowableState.h"
 #include "lib/VoidBits.h"
 
 #include <array>
@@ -25,6 +27,8 @@ public:
 
   HeartsState(uint128_t dealIndex);
   HeartsState(const HeartsState& other);
+  HeartsState(const PackedGameState& packed);
+  HeartsState(const PackedKnowableState& packed);
 
   uint128_t dealIndex() const { return mDealIndex; }
 
@@ -70,6 +74,7 @@ public:
 
   // Player Score tracking
   unsigned GetScoreFor(unsigned player) const;
+  unsigned GetPointTricksFor(unsigned player) const { return mPointTricks[player]; }
   void AddToScoreFor(unsigned player, unsigned score);
   GameOutcome CheckForShootTheMoon();
 
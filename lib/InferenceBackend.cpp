@@ -0,0 +1,33 @@
+// lib/InferenceBackend.cpp
+
+#include "lib/InferenceBackend.h"
+#include "lib/DenseMlpBackend.h"
+
+#ifdef HEARTSNN_WITH_TENSORFLOW
+#include "lib/TensorflowBackend.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static bool HasSuffix(const std::string& s, const std::string& suffix)
+{
+  return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+InferenceBackendPtr LoadInferenceBackend(const std::string& modelPath)
+{
+  if (HasSuffix(modelPath, DenseMlpBackend::kFileSuffix))
+  {
+    return InferenceBackendPtr(new DenseMlpBackend(modelPath));
+  }
+
+#ifdef HEARTSNN_WITH_TENSORFLOW
+  return InferenceBackendPtr(new TensorflowBackend(modelPath));
+#else
+  fprintf(stderr, "Cannot load %s: SavedModel directories require building with HEARTSNN_WITH_TENSORFLOW. "
+                  "Use python/export_mlp.py to export the model as a %s file.\n",
+      modelPath.c_str(), DenseMlpBackend::kFileSuffix);
+  exit(1);
+#endif
+}
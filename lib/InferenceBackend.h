@@ -0,0 +1,37 @@
+// lib/InferenceBackend.h
+
+#pragma once
+
+#include "lib/Card.h"
+
+#include <memory>
+#include <string>
+
+// The model maps one row of KnowableState::kNumFeatures input floats to two outputs per card:
+// the expected score, and the probabilities of the kNumMoonClasses moon outcomes.
+constexpr unsigned kNumMoonClasses = 3;
+constexpr unsigned kScoresPerRow = kCardsPerDeck;
+constexpr unsigned kMoonProbsPerRow = kCardsPerDeck * kNumMoonClasses;
+
+class InferenceBackend
+{
+public:
+  virtual ~InferenceBackend() {}
+
+  virtual void Run(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const = 0;
+    // mainData is numRows rows of KnowableState::kNumFeatures floats.
+    // Returns numRows*kScoresPerRow floats in expectedScore, and numRows*kMoonProbsPerRow floats in moonProbs.
+    // Backends must allow concurrent calls from multiple threads.
+
+  virtual float* InputBuffer(unsigned numRows) const { return 0; }
+    // Returns the calling thread's buffer of at least numRows rows that Run() reads its input from, or null
+    // if the backend reads mainData in place. Callers can encode their input directly into this buffer and
+    // pass it as mainData to avoid a copy. The buffer is valid until the next InputBuffer() call by this thread.
+};
+
+typedef std::shared_ptr<const InferenceBackend> InferenceBackendPtr;
+
+InferenceBackendPtr LoadInferenceBackend(const std::string& modelPath);
+  // A path ending in ".mlp" is loaded by the native DenseMlpBackend.
+  // Any other path is taken to be a TensorFlow SavedModel directory, which requires building with
+  // HEARTSNN_WITH_TENSORFLOW. Exits with an error message if the model can't be loaded.
@@ -0,0 +1,60 @@
+// lib/IoThread.cpp
+
+#include "lib/IoThread.h"
+
+#include <assert.h>
+
+using namespace dlib;
+
+IoThread::~IoThread()
+{
+  // An empty job tells the thread to stop, after the jobs ahead of it.
+  Post(Job());
+  mThread.join();
+}
+
+IoThread::IoThread()
+: mJobsAvailable(0)
+{
+  mThread = std::thread(&IoThread::Run, this);
+}
+
+IoThread& IoThread::Shared()
+{
+  static IoThread thread;
+  return thread;
+}
+
+void IoThread::Post(const Job& job)
+{
+  {
+    auto_mutex locker(mMutex);
+    mJobs.push_back(job);
+  }
+  mJobsAvailable.Release();
+}
+
+void IoThread::Wait()
+{
+  Semaphore done(0);
+  Post([&done]() { done.Release(); });
+  done.Acquire();
+}
+
+void IoThread::Run()
+{
+  while (true)
+  {
+    mJobsAvailable.Acquire();
+    Job job;
+    {
+      auto_mutex locker(mMutex);
+      assert(!mJobs.empty());
+      job = std::move(mJobs.front());
+      mJobs.pop_front();
+    }
+    if (!job)
+      break;
+    job();
+  }
+}
@@ -0,0 +1,44 @@
+// lib/IoThread.h
+
+#pragma once
+
+#include "lib/Semaphore.h"
+
+#include "dlib/threads.h"
+
+#include <deque>
+#include <functional>
+#include <thread>
+
+// IoThread runs file writes on a thread of their own, so that the threads producing the data never wait for the
+// kernel. Jobs run one at a time, in the order they were posted, so the writes to one file stay in order.
+//
+// Posting a job does not wait for it. Writers that need to reuse a buffer once it has been written (such as the
+// double-buffered BlockWriter) have the job release a Semaphore when it is done.
+class IoThread
+{
+public:
+  typedef std::function<void()> Job;
+
+  ~IoThread();
+    // Runs all of the jobs already posted, then stops the thread.
+
+  IoThread();
+
+  static IoThread& Shared();
+    // The process-wide I/O thread, created on first use. All of the data writers of a process share it.
+
+  void Post(const Job& job);
+
+  void Wait();
+    // Returns once all of the jobs posted before the call have run.
+
+private:
+  void Run();
+
+private:
+  dlib::mutex mMutex;
+  std::deque<Job> mJobs;
+  Semaphore mJobsAvailable;
+  std::thread mThread;
+};
@@ -4,12 +4,6 @@
 
 #include "lib/DebugStats.h"
 
-#include <tensorflow/core/public/session.h>
-#include <tensorflow/core/protobuf/meta_graph.pb.h>
-#include <tensorflow/cc/saved_model/loader.h>
-#include <tensorflow/cc/saved_model/tag_constants.h>
-#include <tensorflow/cc/framework/ops.h>
-
 #include <algorithm>
 
 KnowableState::KnowableState(const GameState& gameState)
@@ -19,6 +13,13 @@ KnowableState::KnowableState(const GameState& gameState)
   VerifyKnowableState();
 }
 
+KnowableState::KnowableState(const PackedKnowableState& packed)
+: HeartsState(packed)
+, mHand(packed.mHand, kEmpty)
+{
+  VerifyKnowableState();
+}
+
 void KnowableState::VerifyKnowableState() const
 {
   assert(mHand.Size() == ((52-(PlayNumber() & ~0x3u)) / 4));
@@ -27,7 +28,7 @@ void KnowableState::VerifyKnowableState() const
 
 GameState KnowableState::HypotheticalState() const
 {
-  PossibilityAnalyzer* analyzer = Analyze();
+  PossibilityAnalyzerPtr analyzer = Analyze();
   uint128_t numPossibilities = analyzer->Possibilities();
   uint128_t possibilityIndex = RandomGenerator::Range128(numPossibilities);
 
@@ -72,7 +73,7 @@ void KnowableState::PrepareHands(CardHands& hands) const {
   assert(cardCount == 52 - PlayNumber());
 }
 
-PossibilityAnalyzer* KnowableState::Analyze() const
+PossibilityAnalyzerPtr KnowableState::Analyze() const
 {
   CardDeck remaining = UnplayedCardsNotInHand(mHand);
   unsigned player = CurrentPlayer();
@@ -131,7 +132,6 @@ void KnowableState::AsProbabilities(float prob[52][4]) const
       }
     }
     else {
-      const CardHand unknown = UnknownCardsForCurrentPlayer();
       CardHand::iterator it(unknown);
       while (!it.done()) {
         Card card = it.next();
@@ -146,6 +146,39 @@ void KnowableState::AsProbabilities(float prob[52][4]) const
   }
 }
 
+void KnowableState::ExactProbabilities(float prob[52][4]) const
+{
+  const PossibilityAnalyzerPtr analyzer = Analyze();
+  const unsigned current = CurrentPlayer();
+  const CardHand unknown = UnknownCardsForCurrentPlayer();
+
+  for (unsigned p=0; p<4; ++p) {
+    for (unsigned i=0; i<52; ++i) {
+      prob[i][p] = 0.0;
+    }
+  }
+
+  CardHand::iterator mine(mHand);
+  while (!mine.done()) {
+    prob[mine.next()][current] = 1.0;
+  }
+
+  for (Suit suit=0; suit<4; ++suit) {
+    const CardHand unknownInSuit = unknown.CardsWithSuit(suit);
+    if (unknownInSuit.Size() == 0)
+      continue;
+    for (unsigned p=0; p<4; ++p) {
+      const float cardProb = analyzer->ExpectedCards(suit, p) / unknownInSuit.Size();
+      if (cardProb == 0.0)
+        continue;
+      CardHand::iterator it(unknownInSuit);
+      while (!it.done()) {
+        prob[it.next()][p] = cardProb;
+      }
+    }
+  }
+}
+
 static int CountCardsLowerThan(const CardArray& cards, Card sentinel) {
   const uint64_t mask = (1ul << sentinel) - 1;
   return cards.CountCardsWithMask(mask);
@@ -174,10 +207,16 @@ float oneIfTrue(bool x) {
 //   eOtherNotRuledOutForMoon,
 // };
 
-FloatMatrix KnowableState::AsFloatMatrix() const
+FloatMatrix KnowableState::AsFloatMatrix(bool exactProbabilities) const
 {
   FloatMatrix result(kCardsPerDeck, kNumFeaturesPerCard);
-  result.setZero();
+  EncodeFeatures(result.data(), exactProbabilities);
+  return result;
+}
+
+void KnowableState::EncodeFeatures(float* row, bool exactProbabilities) const
+{
+  std::fill(row, row + kNumFeatures, 0.0f);
 
   // Fill column eLegalPlay
   const CardHand choices = LegalPlays();
@@ -185,37 +224,35 @@ FloatMatrix KnowableState::AsFloatMatrix() const
     CardHand::iterator it(choices);
     while (!it.done()) {
       Card card = it.next();
-      result(card, eLegalPlay) = 1.0;
+      Feature(row, card, eLegalPlay) = 1.0;
     }
   }
 
   // Fill four columns eCardProbPlayer0 .. eCardProbPlayer3
-  float prob[52][4];
-  AsProbabilities(prob);
-  for (int p=0; p<4; p++) {
-    int player = (CurrentPlayer() + p) % 4;
-    for (Card card=0; card<52; card++) {
-      result(card, eCardProbPlayer0+p) = prob[card][player];
-    }
-  }
-
-  // Fill column eCardPoints
-  for (Card card=0; card<52; ++card) {
-  	unsigned pointValue = PointsFor(card);
-  	if (pointValue>0 && (UnplayedCards().HasCard(card) || IsCardOnTable(card))) {
-    	result(card, eCardPoints) = float(pointValue) / 26.0;
-    }
-  }
+  if (exactProbabilities)
+    FillExactProbabilityColumns(row);
+  else
+    FillProbabilityColumns(row);
 
-  // Fill column eCardOnTable
+  // Fill columns eCardOnTable and eCardPoints
+  uint64_t pointCards = UnplayedCards().HasAnyCardInMask(kPointCardsMask);
   for (int i=0; i<PlayInTrick(); ++i) {
     Card card = GetTrickPlay(i);
-    result(card, eCardOnTable) = 1.0;
+    Feature(row, card, eCardOnTable) = 1.0;
+    pointCards |= kPointCardsMask & (1ul << card);
+  }
+  {
+    const CardHand pointsInPlay(pointCards, kEmpty);
+    CardHand::iterator it(pointsInPlay);
+    while (!it.done()) {
+      Card card = it.next();
+      Feature(row, card, eCardPoints) = float(PointsFor(card)) / 26.0;
+    }
   }
 
   // Fill column eCardIsHighCardInTrick
   if (PlayInTrick() > 0)
-    result(HighCardOnTable(), eCardIsHighCardInTrick) = 1.0;
+    Feature(row, HighCardOnTable(), eCardIsHighCardInTrick) = 1.0;
 
   // ePlayerNotRuledOutForMoon and eOtherNotRuledOutForMoon
   // There are several cases to consider, which we handle in separate helper functions
@@ -223,21 +260,62 @@ FloatMatrix KnowableState::AsFloatMatrix() const
   if (PointsSplit()) {
     // Nothing to do, leave the two feature columns all zeros
   } else if (totalPointsTaken == 0) {
-    FillRuledOutForMoonColumnsWhenNoPointsTaken(choices, result);
+    FillRuledOutForMoonColumnsWhenNoPointsTaken(choices, row);
   } else {
     assert(totalPointsTaken>0 && !PointsSplit());
     const bool currentPlayerCanShoot = GetScoreFor(CurrentPlayer()) == totalPointsTaken;
     if (currentPlayerCanShoot) {
-      FillRuledOutForMoonColumnsWhenOtherPlayerRuledOut(choices, result);
+      FillRuledOutForMoonColumnsWhenOtherPlayerRuledOut(choices, row);
     } else {
-      FillRuledOutForMoonColumnsWhenCurrentPlayerRuledOut(choices, result);
+      FillRuledOutForMoonColumnsWhenCurrentPlayerRuledOut(choices, row);
     }
   }
+}
 
-  return result;
+void KnowableState::FillProbabilityColumns(float* row) const
+{
+  // This is AsProbabilities(), but written directly into the feature columns, which are ordered
+  // relative to the current player. Columns of cards no one else can hold are already zero.
+  const unsigned current = CurrentPlayer();
+  const VoidBits voids = IsVoidBits().ForOthers(current);
+  const CardHand unknown = UnknownCardsForCurrentPlayer();
+
+  CardHand::iterator mine(mHand);
+  while (!mine.done()) {
+    Feature(row, mine.next(), eCardProbPlayer0) = 1.0;
+  }
+
+  for (Suit suit=0; suit<4; ++suit) {
+    const CardHand unknownInSuit = unknown.CardsWithSuit(suit);
+    if (unknownInSuit.Size() == 0)
+      continue;
+    const unsigned numVoid = voids.CountVoidInSuit(suit);
+    assert(numVoid < 3);
+    const float suitProb = 1.0 / (3-numVoid);
+
+    for (unsigned p=1; p<4; ++p) {
+      if (voids.isVoid((current + p) % 4, suit))
+        continue;
+      CardHand::iterator it(unknownInSuit);
+      while (!it.done()) {
+        Feature(row, it.next(), eCardProbPlayer0+p) = suitProb;
+      }
+    }
+  }
 }
 
-void KnowableState::FillRuledOutForMoonColumnsWhenNoPointsTaken(const CardHand& choices, FloatMatrix& result) const
+void KnowableState::FillExactProbabilityColumns(float* row) const
+{
+  const unsigned current = CurrentPlayer();
+  float prob[kCardsPerDeck][kNumPlayers];
+  ExactProbabilities(prob);
+  for (Card card=0; card<kCardsPerDeck; ++card) {
+    for (unsigned p=0; p<4; ++p)
+      Feature(row, card, eCardProbPlayer0+p) = prob[card][(current + p) % 4];
+  }
+}
+
+void KnowableState::FillRuledOutForMoonColumnsWhenNoPointsTaken(const CardHand& choices, float* row) const
 {
   if (PlayInTrick() == 0)
   {
@@ -251,8 +329,8 @@ void KnowableState::FillRuledOutForMoonColumnsWhenNoPointsTaken(const CardHand&
       // If we lead with a non-point card, neither player is ruled out out.
       if (PointsFor(card)==0)
       {
-        result(card, ePlayerNotRuledOutForMoon) = 1.0;
-        result(card, eOtherNotRuledOutForMoon) = 1.0;
+        Feature(row, card, ePlayerNotRuledOutForMoon) = 1.0;
+        Feature(row, card, eOtherNotRuledOutForMoon) = 1.0;
       }
       else
       {
@@ -262,8 +340,8 @@ void KnowableState::FillRuledOutForMoonColumnsWhenNoPointsTaken(const CardHand&
         // But note that the feature vector is "not ruled out", so we have to invert the above logic:
         // -- The current player is not ruled out if we lead with a forcing card
         // -- The other player is not ruled out if we lead with a non-forcing card
-        result(card, ePlayerNotRuledOutForMoon) = oneIfTrue(WillCardTakeTrick(card));
-        result(card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
+        Feature(row, card, ePlayerNotRuledOutForMoon) = oneIfTrue(WillCardTakeTrick(card));
+        Feature(row, card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
       }
     }
   }
@@ -273,9 +351,9 @@ void KnowableState::FillRuledOutForMoonColumnsWhenNoPointsTaken(const CardHand&
     while (!it.done()) {
       Card card = it.next();
       // -- we don't rule ourselves out if we play a card that might take the trick.
-      result(card, ePlayerNotRuledOutForMoon) = oneIfTrue(MightCardTakeTrick(card));
+      Feature(row, card, ePlayerNotRuledOutForMoon) = oneIfTrue(MightCardTakeTrick(card));
       // -- we don't rule other players out if we can play a card that doesn't guarantee taking the trick.
-      result(card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
+      Feature(row, card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
     }
   }
   else
@@ -288,14 +366,14 @@ void KnowableState::FillRuledOutForMoonColumnsWhenNoPointsTaken(const CardHand&
       // If there are no points in play
       // -- No one is ruled out if we play a non-point card
       if (PointsFor(card) == 0) {
-        result(card, ePlayerNotRuledOutForMoon) = 1.0;
-        result(card, eOtherNotRuledOutForMoon) = 1.0;
+        Feature(row, card, ePlayerNotRuledOutForMoon) = 1.0;
+        Feature(row, card, eOtherNotRuledOutForMoon) = 1.0;
       }
       else if (SuitOf(card) == kHearts)
       {
         // -- we rule ourselves out by playing sluffing a heart, but do not rule out others
-        result(card, ePlayerNotRuledOutForMoon) = 0.0;
-        result(card, eOtherNotRuledOutForMoon) = 1.0;
+        Feature(row, card, ePlayerNotRuledOutForMoon) = 0.0;
+        Feature(row, card, eOtherNotRuledOutForMoon) = 1.0;
       }
       else
       {
@@ -305,24 +383,24 @@ void KnowableState::FillRuledOutForMoonColumnsWhenNoPointsTaken(const CardHand&
         {
           // ---- if trick suit is spades:
           // current player is not ruled out if the queen might take the trick
-          result(card, ePlayerNotRuledOutForMoon) = oneIfTrue(MightCardTakeTrick(card));
+          Feature(row, card, ePlayerNotRuledOutForMoon) = oneIfTrue(MightCardTakeTrick(card));
           // other player is not ruled out if the queen is not guranteed to take the trick
-          result(card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
+          Feature(row, card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
         }
         else
         {
           // ---- if trick suit is not spades:
           // By sluffing the queen, the current player is ruled out
-          result(card, ePlayerNotRuledOutForMoon) = 0.0;
+          Feature(row, card, ePlayerNotRuledOutForMoon) = 0.0;
           // but other player is not yet ruled out
-          result(card, eOtherNotRuledOutForMoon) = 1.0;
+          Feature(row, card, eOtherNotRuledOutForMoon) = 1.0;
         }
       }
     }
   }
 }
 
-void KnowableState::FillRuledOutForMoonColumnsWhenOtherPlayerRuledOut(const CardHand& choices, FloatMatrix& result) const
+void KnowableState::FillRuledOutForMoonColumnsWhenOtherPlayerRuledOut(const CardHand& choices, float* row) const
 {
   assert(PointsPlayed() > 0);
   assert(GetScoreFor(CurrentPlayer()) == PointsPlayed());
@@ -334,7 +412,7 @@ void KnowableState::FillRuledOutForMoonColumnsWhenOtherPlayerRuledOut(const Card
     {
       Card card = it.next();
       // We don't rule ourself out if we play a non-point card or we play a forcing point card
-      result(card, ePlayerNotRuledOutForMoon) = oneIfTrue(PointsFor(card)==0 || WillCardTakeTrick(card));
+      Feature(row, card, ePlayerNotRuledOutForMoon) = oneIfTrue(PointsFor(card)==0 || WillCardTakeTrick(card));
     }
   }
   else if (PointsOnTable() == 0)
@@ -345,7 +423,7 @@ void KnowableState::FillRuledOutForMoonColumnsWhenOtherPlayerRuledOut(const Card
     {
       Card card = it.next();
       // We don't rule ourselves out if we play a non-point card
-      result(card, ePlayerNotRuledOutForMoon) = oneIfTrue(PointsFor(card)==0);
+      Feature(row, card, ePlayerNotRuledOutForMoon) = oneIfTrue(PointsFor(card)==0);
     }
   }
   else
@@ -356,12 +434,12 @@ void KnowableState::FillRuledOutForMoonColumnsWhenOtherPlayerRuledOut(const Card
     {
       Card card = it.next();
       // We don't rule ourselves out if we play a card that might take the trick
-      result(card, ePlayerNotRuledOutForMoon) = oneIfTrue(MightCardTakeTrick(card));
+      Feature(row, card, ePlayerNotRuledOutForMoon) = oneIfTrue(MightCardTakeTrick(card));
     }
   }
 }
 
-void KnowableState::FillRuledOutForMoonColumnsWhenCurrentPlayerRuledOut(const CardHand& choices, FloatMatrix& result) const
+void KnowableState::FillRuledOutForMoonColumnsWhenCurrentPlayerRuledOut(const CardHand& choices, float* row) const
 {
   assert(PointsPlayed() > 0);
   assert(GetScoreFor(CurrentPlayer()) == 0);
@@ -385,7 +463,7 @@ void KnowableState::FillRuledOutForMoonColumnsWhenCurrentPlayerRuledOut(const Ca
     {
       Card card = it.next();
       // We don't rule out the other player if we don't play a forcing card
-      result(card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
+      Feature(row, card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
     }
   }
   else if (PointsOnTable() == 0)
@@ -397,7 +475,7 @@ void KnowableState::FillRuledOutForMoonColumnsWhenCurrentPlayerRuledOut(const Ca
       Card card = it.next();
       // We rule out the other player if we can play a point card and know the other player cannot win the trick.
       // The other player can't win the trick only if they already have a card on the table that can't win the trick.
-      result(card, eOtherNotRuledOutForMoon) = oneIfTrue(PointsFor(card)==0 || otherPlayersPlay==kNoSuchCard || !MightCardTakeTrick(card));
+      Feature(row, card, eOtherNotRuledOutForMoon) = oneIfTrue(PointsFor(card)==0 || otherPlayersPlay==kNoSuchCard || !MightCardTakeTrick(card));
     }
   }
   else
@@ -411,142 +489,21 @@ void KnowableState::FillRuledOutForMoonColumnsWhenCurrentPlayerRuledOut(const Ca
       // or if we can tell that the other player already lost the trick.
       if (otherPlayersPlay != kNoSuchCard) {
         // The other player already has their card on the table
-        result(card, eOtherNotRuledOutForMoon) = oneIfTrue(otherPlayersPlay==HighCardOnTable() && !MightCardTakeTrick(card));
+        Feature(row, card, eOtherNotRuledOutForMoon) = oneIfTrue(otherPlayersPlay==HighCardOnTable() && !MightCardTakeTrick(card));
       } else {
-        result(card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
+        Feature(row, card, eOtherNotRuledOutForMoon) = oneIfTrue(!WillCardTakeTrick(card));
       }
     }
   }
 }
 
 
-tensorflow::Tensor KnowableState::Transform() const
-{
-  using namespace std;
-  using namespace tensorflow;
-
-  float prob[kCardsPerDeck][kNumPlayers];
-  #if 1
-    AsProbabilities(prob);
-  #else
-    PossibilityAnalyzer* analyzer = state.Analyze();
-    const uint128_t numPossibilities = analyzer->Possibilities();
-
-    Distribution distribution;
-    CardHands hands;
-    state.PrepareHands(hands);
-    analyzer->ExpectedDistribution(distribution, hands);
-    distribution.DistributeRemainingToPlayer(state.CurrentPlayersHand(), state.CurrentPlayer(), numPossibilities);
-
-    delete analyzer;
-    distribution.AsProbabilities(prob);
-  #endif
-
-  Tensor mainData(DT_FLOAT, TensorShape({1, kNumFeatures}));
-  auto matrix = mainData.matrix<float>();
-
-  // Clear the entire feature vector to all zeros.
-  matrix.setZero();
-
-  // Fill the "distribution", the p(hascard | card,player)
-  // This must be filled such that the current player is first, then other players in normal order.
-  // This fills the first four "feature columns" of 52 elements each.
-  int index = 0;
-  for (int p=0; p<kNumPlayers; p++) {
-    int player = (CurrentPlayer() + p) % 4;
-    for (int i=0; i<kCardsPerDeck; i++) {
-      matrix(0, index++) = prob[i][player];
-    }
-  }
-
-  assert(index == kCardsPerDeck*kNumPlayers);
-
-  const CardHand choices = LegalPlays();
-
-  // The 5th column is legal plays
-  // Set to 1 just the elements corresponding to the cards that are legal plays
-
-  {
-    CardHand::iterator it(choices);
-    while (!it.done()) {
-      Card card = it.next();
-      matrix(0, index+card) = 1.0;
-    }
-  }
-  index = kCardsPerDeck*5; // we didn't advance index above, so must set it here.
-
-  // The 6th column is 'high card on table'
-  // It is 1 if the card is is on the table and current the high card in the trick suit.
-  // This column is all zeros when current player is leading the trick.
-
-  if (PlayInTrick() != 0) {
-    matrix(0, index+HighCardOnTable()) = 1.0;
-  }
-  index = kCardsPerDeck*6; // we didn't advance index above, so must set it here.
-
-  // The last 52-elem feature column is the number of points each unplayed card is worth.
-  // Cards already played score 0 here, and of course non-point cards are also 0.
-  // We scale by 1/26.0 so the points here are scaled the same way as elsewhere.
-  // We hope that the DNN will learn that points flow from here, to the points on table,
-  // and then into the points taken so far.
-  for (Card card=0; card<52; ++card) {
-  	unsigned pointValue = PointsFor(card);
-  	if (pointValue>0 && UnplayedCards().HasCard(card)) {
-    	matrix(0, index++) = float(pointValue) / 26.0;
-    } else {
-     	matrix(0, index++) = 0.0;
-   }
-  }
-
-  assert(index == kCardsPerDeck*7);
-
-  const bool pointsSplit = PointsSplit();
-  const unsigned totalPointsTaken = PointsPlayed();
-
-  const bool currentPlayerCanShoot = GetScoreFor(CurrentPlayer()) == totalPointsTaken;
-
-  bool otherPlayerCanShoot = false;
-  for (int p=0; p<4; p++) {
-    int player = (CurrentPlayer() + p) % 4;
-    unsigned pointsForThisPlayer = GetScoreFor(player);
-    if (p>0  && pointsForThisPlayer==totalPointsTaken)
-      otherPlayerCanShoot = true;
-  }
-
-  unsigned pointsOnTheTable = 0;
-  for (int p=0; p<4; p++) {
-  	Card card = GetTrickPlay(p);
-  	pointsOnTheTable += PointsFor(card);
-  }
-
-  assert(index == kNumFeatures);
-
-  return mainData;
-}
-
-Card KnowableState::TransformAndPredict(const tensorflow::SavedModelBundle& model, float playExpectedValue[13]) const
-{
-  tensorflow::Tensor mainData = Transform();
-  return Predict(model, mainData, playExpectedValue);
-}
-
 DebugStats _expectedDeltaPredictionUnclipped("KnowableState::expectedDeltaPredictionUnclipped");
 DebugStats _expectedPointsPrediction("KnowableState::expectedPointsPrediction");
 DebugStats _expectedScorePrediction("KnowableState::expectedScorePrediction");
 
-Card KnowableState::ParsePrediction(const std::vector<tensorflow::Tensor>& outputs, float playExpectedValue[13]) const
+Card KnowableState::ParsePrediction(const float* exectedScoreDelta, const float* moonProbs, float playExpectedValue[13]) const
 {
-  using namespace tensorflow;
-  Tensor expectedScorePrediction = outputs.at(0);
-  assert(expectedScorePrediction.dims() == 2);
-  assert(expectedScorePrediction.NumElements() == kCardsPerDeck);
-  auto exectedScoreDelta = expectedScorePrediction.flat<float>();
-
-  Tensor moonProbsPrediction = outputs.at(1);
-  assert(moonProbsPrediction.dims() == 3);
-  assert(moonProbsPrediction.NumElements() == 3*kCardsPerDeck);
-  auto moonProbs = moonProbsPrediction.flat<float>();
-
   CardHand choices = LegalPlays();
 
   // playExpectedValue from the NN prediction is for the delta of additional points that the player will take.
@@ -572,7 +529,7 @@ Card KnowableState::ParsePrediction(const std::vector<tensorflow::Tensor>& outpu
   for (int i=0; i<choices.Size(); ++i) {
     Card card = it.next();
 
-    float expectedDeltaPrediction = exectedScoreDelta(card);
+    float expectedDeltaPrediction = exectedScoreDelta[card];
     _expectedDeltaPredictionUnclipped.Accum(expectedDeltaPrediction);
     const float kMin = 0.0;
     assert(expectedDeltaPrediction >= kMin);
@@ -584,7 +541,7 @@ Card KnowableState::ParsePrediction(const std::vector<tensorflow::Tensor>& outpu
 
     float check = 0;
     for (int j=0; j<3; j++) {
-      const float moon_p = moonProbs(j + card*3);
+      const float moon_p = moonProbs[j + card*3];
       assert(moon_p >= 0.0);
       assert(moon_p <= 1.0);
       check += moon_p;
@@ -605,17 +562,3 @@ Card KnowableState::ParsePrediction(const std::vector<tensorflow::Tensor>& outpu
   return bestCard;
 }
 
-Card KnowableState::Predict(const tensorflow::SavedModelBundle& model, const tensorflow::Tensor& mainData, float playExpectedValue[13]) const
-{
-  using namespace std;
-  using namespace tensorflow;
-
-  std::vector<Tensor> outputs;
-  auto result = model.session->Run({{"main_data:0", mainData}}, {"expected_score/expected_score:0"}, {}, &outputs);
-  if (!result.ok()) {
-    printf("Tensorflow prediction failed: %s\n", result.error_message().c_str());
-    exit(1);
-  }
-
-  return ParsePrediction(outputs, playExpectedValue);
-}
@@ -2,17 +2,12 @@
 
 #include "lib/HeartsState.h"
 #include "lib/CardArray.h"
+#include "lib/PossibilityAnalyzer.h"
 
 #include <Eigen/Core>
 #include <unsupported/Eigen/CXX11/Tensor>
-#include <tensorflow/core/framework/tensor.h>
 
 class GameState;
-class PossibilityAnalyzer;
-
-namespace tensorflow {
-  struct SavedModelBundle;
-};
 
 // Doc for Eigen::Tensor is https://bitbucket.org/eigen/eigen/src/de7544f256bdeb135f7d016e2ddf344a9e0406eb/unsupported/Eigen/CXX11/src/Tensor/README.md
 typedef Eigen::Tensor<float, 1, Eigen::RowMajor>  FloatVector;
@@ -43,10 +38,11 @@ public:
 
 public:
   KnowableState(const GameState& other);
+  explicit KnowableState(const PackedKnowableState& packed);
 
   GameState HypotheticalState() const;
 
-  PossibilityAnalyzer* Analyze() const;
+  PossibilityAnalyzerPtr Analyze() const;
 
   CardDeck UnknownCardsForCurrentPlayer() const;
 
@@ -60,27 +56,37 @@ public:
     // For the other 3 players, the probabilities are just assigned uniformly across the players who are
     // not void in the card's suit.
 
-  tensorflow::Tensor Transform() const;
-    // Transform this state into the the `mainData` tensor input for predict.
+  void ExactProbabilities(float prob[kCardsPerDeck][kNumPlayers]) const;
+    // As AsProbabilities(), but with the exact probabilities over all of the possible deals of the unknown cards,
+    // which also account for the number of cards each player holds. They come from the memoized analyzer for
+    // the state's constraints, so they cost about half as much as ExpectedDistribution() when it is cached.
 
-  FloatMatrix AsFloatMatrix() const;
+  FloatMatrix AsFloatMatrix(bool exactProbabilities=false) const;
     // Returns an Eigen3 maxtrix with kCardsPerDeck rows and kNumFeaturesPerCard columns
 
-  Card Predict(const tensorflow::SavedModelBundle& model, const tensorflow::Tensor& mainData, float playExpectedValue[13]) const;
-    // Run tensorflow prediction given the model and tensor input.
-
-  Card TransformAndPredict(const tensorflow::SavedModelBundle& model, float playExpectedValue[13]) const;
+  void EncodeFeatures(float* row, bool exactProbabilities=false) const;
+    // Writes the same kNumFeatures floats as AsFloatMatrix() (row major, one card per kNumFeaturesPerCard floats)
+    // to row, e.g. directly into one row of a model input batch. Every float of the row is written.
+    // The probability columns are from AsProbabilities(), or from ExactProbabilities() when exactProbabilities
+    // is true. A model must be used with the probabilities it was trained with.
 
-  Card ParsePrediction(const std::vector<tensorflow::Tensor>& outputs, float playExpectedValue[13]) const;
+  Card ParsePrediction(const float* expectedScore, const float* moonProbs, float playExpectedValue[13]) const;
+    // Given the model outputs for this state (kScoresPerRow expected scores and kMoonProbsPerRow moon probabilities),
+    // fill playExpectedValue for each legal play and return the best play.
 
 private:
   KnowableState();  // unimplemented
 
   void VerifyKnowableState() const;
 
-  void FillRuledOutForMoonColumnsWhenNoPointsTaken(const CardHand& choices, FloatMatrix& result) const;
-  void FillRuledOutForMoonColumnsWhenOtherPlayerRuledOut(const CardHand& choices, FloatMatrix& result) const;
-  void FillRuledOutForMoonColumnsWhenCurrentPlayerRuledOut(const CardHand& choices, FloatMatrix& result) const;
+  static float& Feature(float* row, Card card, unsigned column) { return row[card*kNumFeaturesPerCard + column]; }
+
+  void FillProbabilityColumns(float* row) const;
+
+  void FillExactProbabilityColumns(float* row) const;
+  void FillRuledOutForMoonColumnsWhenNoPointsTaken(const CardHand& choices, float* row) const;
+  void FillRuledOutForMoonColumnsWhenOtherPlayerRuledOut(const CardHand& choices, float* row) const;
+  void FillRuledOutForMoonColumnsWhenCurrentPlayerRuledOut(const CardHand& choices, float* row) const;
 
 private:
   CardHand mHand;
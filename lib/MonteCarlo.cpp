@@ -1,10 +1,15 @@
 #include "lib/MonteCarlo.h"
 #include "lib/Card.h"
+#include "lib/DealSampler.h"
 #include "lib/DebugStats.h"
+#include "lib/EndgameSolver.h"
+#include "lib/FastRollout.h"
 #include "lib/GameState.h"
 #include "lib/KnowableState.h"
+#include "lib/MultiRollout.h"
 #include "lib/PossibilityAnalyzer.h"
 #include "lib/RandomStrategy.h"
+#include "lib/TaskExecutor.h"
 #include "lib/random.h"
 #include "lib/timer.h"
 
@@ -16,43 +21,105 @@ static logger dlog("MonteCarlo");
 
 #include <algorithm>
 #include <math.h>
+#include <optional>
 #include <stdlib.h>
 #include <sys/stat.h>
 
-MonteCarlo::~MonteCarlo() {}
+MonteCarlo::~MonteCarlo()
+{
+}
 
-MonteCarlo::MonteCarlo(
-    const StrategyPtr& intuition, uint32_t numAlternates, bool parallel, const AnnotatorPtr& annotator)
+MonteCarlo::MonteCarlo(const StrategyPtr& intuition, uint32_t numAlternates, bool parallel,
+    const AnnotatorPtr& annotator, unsigned threadBudget)
     : Strategy(annotator)
     , mIntuition(intuition)
     , kNumAlternates(numAlternates)
-    , kNumThreads(parallel ? (3 * std::thread::hardware_concurrency()) / 4 : 0)
+    , kThreadBudget(threadBudget)
     , mParallel(parallel)
-    , mThreadPool(kNumThreads)
+    , mEarlyStopping(false)
+    , mCommonRandomNumbers(false)
+    , mEndgameTricks(0)
+    , mNumDecisions(0)
+    , mNumAlternatesPlayed(0)
+    , mNumRolloutsPlayed(0)
 {
     dlog.set_level(LALL);
 }
 
-void MonteCarlo::PlayOneAlternate(const KnowableState& knowableState, const PossibilityAnalyzer* analyzer,
-    uint128_t possibilityIndex, const CardHand& choices, const RandomGenerator& rng, Stats& stats) const
+void MonteCarlo::EnableEarlyStopping() { mEarlyStopping = true; }
+
+void MonteCarlo::EnableCommonRandomNumbers() { mCommonRandomNumbers = true; }
+
+void MonteCarlo::EnableEndgameSolver(unsigned numTricks)
+{
+    assert(numTricks <= EndgameSolver::kMaxTricks);
+    mEndgameTricks = numTricks;
+}
+
+bool MonteCarlo::UsesMultiRollout() const
+{
+    // MultiRollout has no endgame solver, so with one the random rollouts are played by PlayOneAlternateFast().
+    return mIntuition->playsUniformlyAtRandom() && mEndgameTricks == 0;
+}
+
+MonteCarlo::Counters MonteCarlo::GetCounters() const
+{
+    Counters counters;
+    counters.decisions = mNumDecisions;
+    counters.alternatesPlayed = mNumAlternatesPlayed;
+    counters.rolloutsPlayed = mNumRolloutsPlayed;
+    return counters;
+}
+
+void MonteCarlo::printCounters() const
+{
+    const Counters counters = GetCounters();
+    if (counters.decisions != 0)
+    {
+        const double kDecisions = counters.decisions;
+        printf("MonteCarlo: %lu decisions, %.1f alternates (of up to %u) and %.1f rollouts per decision\n",
+            counters.decisions, counters.alternatesPlayed / kDecisions, kNumAlternates,
+            counters.rolloutsPlayed / kDecisions);
+    }
+    mIntuition->printCounters();
+}
+
+void MonteCarlo::PlayOneAlternate(const KnowableState& knowableState, const DealSampler& sampler,
+    const CardHand& choices, const RandomGenerator& rng, Stats& stats) const
 {
     const unsigned currentPlayer = knowableState.CurrentPlayer();
 
     CardHands hands;
     knowableState.PrepareHands(hands);
-    analyzer->ActualizePossibility(possibilityIndex, hands);
+    sampler.Sample(rng, hands);
 
     knowableState.IsVoidBits().VerifyVoids(hands);
 
+    if (mIntuition->playsUniformlyAtRandom())
+    {
+        PlayOneAlternateFast(knowableState, hands, choices, rng, stats);
+        return;
+    }
+
     // Construct the game state for this alternate
     const GameState alt(hands, knowableState);
 
+    // With common random numbers, the rollout of every play draws the same sequence of random numbers.
+    // Otherwise there is no generator to seed for each play.
+    const uint64_t seed = mCommonRandomNumbers ? rng.random64() : 0;
+    std::optional<RandomGenerator> commonRng;
+    if (mCommonRandomNumbers)
+        commonRng.emplace(seed);
+    const RandomGenerator& rolloutRng = commonRng ? *commonRng : rng;
+
     CardArray::iterator it(choices);
 
     // For each possible play
     for (unsigned i = 0; i < choices.Size(); ++i)
     {
         Card nextCardPlayed = it.next();
+        if (commonRng)
+            commonRng->Seed(seed);
 
         // Construct the next game state
         GameState next(alt);
@@ -60,7 +127,7 @@ void MonteCarlo::PlayOneAlternate(const KnowableState& knowableState, const Poss
         next.PlayCard(nextCardPlayed);
 
         // Do one "roll out", i.e. play out the game to the end, using random plays
-        GameOutcome outcome = next.PlayOutGameMonteCarlo(mIntuition, rng);
+        GameOutcome outcome = next.PlayOutGameMonteCarlo(mIntuition, rolloutRng, mEndgameTricks);
 
         stats.UntrackTrickWinner(next);
         stats.UpdateForGameOutcome(outcome, currentPlayer, i);
@@ -69,45 +136,183 @@ void MonteCarlo::PlayOneAlternate(const KnowableState& knowableState, const Poss
     stats.FinishedOneAlternate();
 }
 
-MonteCarlo::Stats MonteCarlo::RunRolloutsTask(const KnowableState& knowableState, PossibilityAnalyzer* analyzer,
-    const CardHand& choices, const RandomGenerator& rng, unsigned kNumAlts) const
+void MonteCarlo::PlayOneAlternateFast(const KnowableState& knowableState, const CardHands& hands,
+    const CardHand& choices, const RandomGenerator& rng, Stats& stats) const
 {
-    const uint128_t numPossibilities = analyzer->Possibilities();
-    Stats thisTaskStats(choices.Size());
-    for (unsigned alternate = 0; alternate < kNumAlts; ++alternate)
+    const unsigned currentPlayer = knowableState.CurrentPlayer();
+    const FastRollout alt(knowableState, hands);
+
+    const uint64_t seed = mCommonRandomNumbers ? rng.random64() : 0;
+    std::optional<RandomGenerator> commonRng;
+    if (mCommonRandomNumbers)
+        commonRng.emplace(seed);
+    const RandomGenerator& rolloutRng = commonRng ? *commonRng : rng;
+
+    CardArray::iterator it(choices);
+    for (unsigned i = 0; i < choices.Size(); ++i)
     {
-        const uint128_t possibilityIndex = rng.range128(numPossibilities);
-        PlayOneAlternate(knowableState, analyzer, possibilityIndex, choices, rng, thisTaskStats);
+        if (commonRng)
+            commonRng->Seed(seed);
+        FastRollout next(alt);
+        next.PlayCard(it.next());
+        GameOutcome outcome;
+        if (mEndgameTricks == 0)
+        {
+            outcome = next.PlayOutRandomly(rolloutRng);
+        }
+        else
+        {
+            next.PlayRandomly(rolloutRng, kCardsPerDeck - 4 * mEndgameTricks);
+            outcome = EndgameSolver::Shared().Solve(next);
+        }
+
+        if (next.FirstTrickWinner() == int(currentPlayer))
+            stats.CountTrickWin(i);
+        stats.UpdateForGameOutcome(outcome, currentPlayer, i);
     }
 
-    return thisTaskStats;
+    stats.FinishedOneAlternate();
 }
 
-MonteCarlo::Stats MonteCarlo::RunParallelTasks(const KnowableState& knowableState, const RandomGenerator& rng,
-    PossibilityAnalyzer* analyzer, const CardHand& choices) const
+void MonteCarlo::PlayAlternatesInLockStep(const KnowableState& knowableState, const DealSampler& sampler,
+    unsigned numAlternates, const CardHand& choices, const RandomGenerator& rng, Stats& stats) const
 {
-    Stats totalStats(choices.Size());
+    const unsigned currentPlayer = knowableState.CurrentPlayer();
+    const unsigned kNumChoices = choices.Size();
 
-    // double n = now();
+    std::vector<GameState> games;
+    games.reserve(numAlternates * kNumChoices);
 
-    assert(kNumThreads >= 1);
-    const unsigned kNumAlts = (kNumAlternates + kNumThreads - 1) / kNumThreads;
+    for (unsigned alternate = 0; alternate < numAlternates; ++alternate)
+    {
+        CardHands hands;
+        knowableState.PrepareHands(hands);
+        sampler.Sample(rng, hands);
 
-    std::vector<std::future<Stats>> taskStats(kNumThreads);
+        knowableState.IsVoidBits().VerifyVoids(hands);
 
-    for (int i = 0; i < kNumThreads; ++i)
+        const GameState alt(hands, knowableState);
+
+        CardArray::iterator it(choices);
+        for (unsigned i = 0; i < kNumChoices; ++i)
+        {
+            games.emplace_back(alt);
+            stats.TrackTrickWinner(games.back(), i);
+            games.back().PlayCard(it.next());
+        }
+    }
+
+    GameState::PlayOutGamesInLockStep(games, mIntuition, rng, mEndgameTricks);
+
+    for (unsigned g = 0; g < games.size(); ++g)
     {
-        taskStats[i] = dlib::async(mThreadPool, [this, i, knowableState, analyzer, choices, kNumAlts]() {
-            const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
-            return this->RunRolloutsTask(knowableState, analyzer, choices, rng, kNumAlts);
-        });
+        GameOutcome outcome = games[g].CheckForShootTheMoon();
+        stats.UntrackTrickWinner(games[g]);
+        stats.UpdateForGameOutcome(outcome, currentPlayer, g % kNumChoices);
+        if (g % kNumChoices == kNumChoices - 1)
+            stats.FinishedOneAlternate();
     }
+}
+
+void MonteCarlo::PlayAlternatesRandomly(const KnowableState& knowableState, const DealSampler& sampler,
+    unsigned numAlternates, const CardHand& choices, const RandomGenerator& rng, Stats& stats) const
+{
+    const unsigned currentPlayer = knowableState.CurrentPlayer();
+    const unsigned kNumChoices = choices.Size();
 
-    for (int i = 0; i < kNumThreads; ++i)
-        totalStats += taskStats[i].get();
+    MultiRollout games;
 
-    // dlog << LINFO << "Computed " << totalStats.TotalAlternates() << " in secs: " << delta(n);
-    return totalStats;
+    for (unsigned alternate = 0; alternate < numAlternates; ++alternate)
+    {
+        CardHands hands;
+        knowableState.PrepareHands(hands);
+        sampler.Sample(rng, hands);
+
+        knowableState.IsVoidBits().VerifyVoids(hands);
+
+        const FastRollout alt(knowableState, hands);
+        const uint64_t seed = rng.random64();
+
+        CardArray::iterator it(choices);
+        for (unsigned i = 0; i < kNumChoices; ++i)
+        {
+            FastRollout next(alt);
+            next.PlayCard(it.next());
+            games.Add(next, mCommonRandomNumbers ? seed : rng.random64());
+        }
+    }
+
+    games.PlayOutRandomly();
+
+    for (unsigned g = 0; g < games.Size(); ++g)
+    {
+        const unsigned i = g % kNumChoices;
+        if (games.FirstTrickWinner(g) == int(currentPlayer))
+            stats.CountTrickWin(i);
+        stats.UpdateForGameOutcome(games.Outcome(g), currentPlayer, i);
+        if (i == kNumChoices - 1)
+            stats.FinishedOneAlternate();
+    }
+}
+
+void MonteCarlo::RunRolloutsTask(const KnowableState& knowableState, const DealSampler& sampler,
+    const CardHand& choices, const RandomGenerator& rng, unsigned kNumAlts, Stats& stats) const
+{
+    const bool random = UsesMultiRollout();
+    if (random || mIntuition->prefersBatches())
+    {
+        for (unsigned alternate = 0; alternate < kNumAlts; alternate += kLockStepAlternates)
+        {
+            const unsigned kNumInBatch = std::min(kLockStepAlternates, kNumAlts - alternate);
+            if (random)
+                PlayAlternatesRandomly(knowableState, sampler, kNumInBatch, choices, rng, stats);
+            else
+                PlayAlternatesInLockStep(knowableState, sampler, kNumInBatch, choices, rng, stats);
+        }
+        return;
+    }
+
+    for (unsigned alternate = 0; alternate < kNumAlts; ++alternate)
+        PlayOneAlternate(knowableState, sampler, choices, rng, stats);
+}
+
+void MonteCarlo::RunParallelTasks(const KnowableState& knowableState, const DealSampler& sampler,
+    const CardHand& choices, unsigned numAlternates, Stats& stats) const
+{
+    TaskExecutor& executor = TaskExecutor::Shared();
+
+    // Small tasks let threads that finish early take work from the others. Batching intuitions need whole
+    // batches of alternates to be efficient, so their tasks are one batch each.
+    const bool batches = UsesMultiRollout() || mIntuition->prefersBatches();
+    const unsigned kAlternatesPerTask = batches ? kLockStepAlternates : kAlternatesPerSmallTask;
+    const unsigned kNumTasks = (numAlternates + kAlternatesPerTask - 1) / kAlternatesPerTask;
+    const unsigned kNumSlots = kThreadBudget == 0 ? executor.MaxSlots() : std::min(kThreadBudget, executor.MaxSlots());
+
+    // One Stats per thread working on the rollouts, combined at the end.
+    std::vector<Stats> slotStats(kNumSlots, Stats(choices.Size()));
+
+    executor.ParallelFor(kNumTasks, kNumSlots, [&](unsigned task, unsigned slot) {
+        const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+        const unsigned kFirst = task * kAlternatesPerTask;
+        const unsigned kNumAlts = std::min(kAlternatesPerTask, numAlternates - kFirst);
+        this->RunRolloutsTask(knowableState, sampler, choices, rng, kNumAlts, slotStats[slot]);
+    });
+
+    for (const Stats& slot : slotStats)
+        stats += slot;
+}
+
+void MonteCarlo::RunAlternates(const KnowableState& knowableState, const DealSampler& sampler,
+    const CardHand& choices, const RandomGenerator& rng, unsigned numAlternates, Stats& stats) const
+{
+    if (!mParallel)
+    {
+        this->RunRolloutsTask(knowableState, sampler, choices, rng, numAlternates, stats);
+    }
+    else
+    {
+        RunParallelTasks(knowableState, sampler, choices, numAlternates, stats);
+    }
 }
 
 Card MonteCarlo::predictOutcomes(
@@ -130,18 +335,31 @@ Card MonteCarlo::choosePlay(const KnowableState& knowableState, const RandomGene
 
     assert(knowableState.PointsPlayed() < 26);
 
-    PossibilityAnalyzer* analyzer = knowableState.Analyze();
+    const PossibilityAnalyzerPtr analyzer = knowableState.Analyze();
+    const DealSampler sampler(*analyzer);
 
-    Stats totalStats;
-    if (!mParallel)
+    Stats totalStats(choices.Size());
+    if (!mEarlyStopping)
     {
-        totalStats = this->RunRolloutsTask(knowableState, analyzer, choices, rng, kNumAlternates);
+        RunAlternates(knowableState, sampler, choices, rng, kNumAlternates, totalStats);
     }
     else
     {
-        totalStats = RunParallelTasks(knowableState, rng, analyzer, choices);
+        unsigned numAlternates = std::min(kMinEarlyStoppingAlternates, kNumAlternates);
+        while (true)
+        {
+            RunAlternates(knowableState, sampler, choices, rng, numAlternates - totalStats.TotalAlternates(),
+                totalStats);
+            if (numAlternates == kNumAlternates || totalStats.IsBestPlayDecided())
+                break;
+            numAlternates = std::min(2 * numAlternates, kNumAlternates);
+        }
     }
 
+    ++mNumDecisions;
+    mNumAlternatesPlayed += totalStats.TotalAlternates();
+    mNumRolloutsPlayed += totalStats.TotalAlternates() * choices.Size();
+
     const AnnotatorPtr annotator = getAnnotator();
     if (annotator)
     {
@@ -150,11 +368,9 @@ Card MonteCarlo::choosePlay(const KnowableState& knowableState, const RandomGene
         float expectedDelta[13];
         const unsigned currentPoints = knowableState.GetScoreFor(knowableState.CurrentPlayer());
         totalStats.ComputeTargetValues(choices, moonProb, winsTrickProb, expectedDelta, currentPoints);
-        annotator->OnWriteData(knowableState, analyzer, expectedDelta, moonProb, winsTrickProb);
+        annotator->OnWriteData(knowableState, analyzer.get(), expectedDelta, moonProb, winsTrickProb);
     }
 
-    delete analyzer;
-
     Card bestPlay = totalStats.BestPlay(choices);
     return bestPlay;
 }
@@ -181,6 +397,8 @@ MonteCarlo::Stats::Stats(unsigned numLegalPlays)
     bzero(mTotalPoints, sizeof(mTotalPoints));
     bzero(mTotalTrickWins, sizeof(mTotalTrickWins));
     bzero(mTotalMoonCounts, sizeof(mTotalMoonCounts));
+    bzero(mTotalScores, sizeof(mTotalScores));
+    bzero(mTotalSquaredDifferences, sizeof(mTotalSquaredDifferences));
 }
 
 void MonteCarlo::Stats::UpdateForGameOutcome(const GameOutcome& outcome, int currentPlayer, int iPlay)
@@ -189,6 +407,22 @@ void MonteCarlo::Stats::UpdateForGameOutcome(const GameOutcome& outcome, int cur
     unsigned pointsTaken = outcome.PointsTaken(currentPlayer);
     _UpdateForGameOutcome.Accum(float(pointsTaken));
     mTotalPoints[iPlay] += pointsTaken;
+    const double score = outcome.ZeroMeanStandardScore(currentPlayer);
+    mTotalScores[iPlay] += score;
+    mAlternateScores[iPlay] = score;
+}
+
+void MonteCarlo::Stats::FinishedOneAlternate()
+{
+    ++mTotalAlternates;
+    for (unsigned i = 0; i < mNumLegalPlays; ++i)
+    {
+        for (unsigned j = i + 1; j < mNumLegalPlays; ++j)
+        {
+            const double difference = mAlternateScores[i] - mAlternateScores[j];
+            mTotalSquaredDifferences[i][j] += difference * difference;
+        }
+    }
 }
 
 void MonteCarlo::Stats::TrackTrickWinner(GameState& next, int iPlay) { next.TrackTrickWinner(mTotalTrickWins + iPlay); }
@@ -276,6 +510,11 @@ void MonteCarlo::Stats::operator+=(const MonteCarlo::Stats& other)
     {
         mTotalPoints[i] += other.mTotalPoints[i];
         mTotalTrickWins[i] += other.mTotalTrickWins[i];
+        mTotalScores[i] += other.mTotalScores[i];
+        for (unsigned j = i + 1; j < mNumLegalPlays; ++j)
+        {
+            mTotalSquaredDifferences[i][j] += other.mTotalSquaredDifferences[i][j];
+        }
 
         for (unsigned j = 0; j < kNumMoonCountKeys; ++j)
         {
@@ -283,3 +522,34 @@ void MonteCarlo::Stats::operator+=(const MonteCarlo::Stats& other)
         }
     }
 }
+
+bool MonteCarlo::Stats::IsBestPlayDecided() const
+{
+    const double n = mTotalAlternates;
+    if (n < 2)
+        return false;
+
+    double mean[13];
+    unsigned best = 0;
+    for (unsigned i = 0; i < mNumLegalPlays; ++i)
+    {
+        mean[i] = mTotalScores[i] / n;
+        if (mean[i] < mean[best])
+            best = i;
+    }
+
+    // Every other play must be either confidently worse, or confidently no better than kIndifferentScore worse.
+    // The plays are compared on the same alternates, so the standard error is that of the paired differences.
+    for (unsigned i = 0; i < mNumLegalPlays; ++i)
+    {
+        if (i == best)
+            continue;
+        const double kDelta = mean[i] - mean[best];
+        const double kSquaredDifferences = mTotalSquaredDifferences[std::min(i, best)][std::max(i, best)];
+        const double kVariance = std::max(0.0, (kSquaredDifferences - n * kDelta * kDelta) / (n - 1));
+        const double kMargin = kConfidenceZ * sqrt(kVariance / n);
+        if (kDelta <= kMargin && kDelta + kMargin >= kIndifferentScore)
+            return false;
+    }
+    return true;
+}
@@ -5,6 +5,9 @@
 #include "lib/GameOutcome.h"
 #include "lib/Strategy.h"
 
+#include <atomic>
+
+class DealSampler;
 class KnowableState;
 
 enum ScoreType
@@ -29,15 +32,47 @@ class MonteCarlo : public Strategy
 public:
     virtual ~MonteCarlo();
 
-    MonteCarlo(const StrategyPtr& intuition, uint32_t numAlternates, bool parallel, const AnnotatorPtr& annotator);
+    MonteCarlo(const StrategyPtr& intuition, uint32_t numAlternates, bool parallel, const AnnotatorPtr& annotator,
+        unsigned threadBudget = 0);
+    // When parallel, the rollouts run on the process-wide TaskExecutor, using at most threadBudget threads
+    // (including the thread calling choosePlay()). A threadBudget of 0 means as many threads as the executor has.
+
+    void EnableEarlyStopping();
+    // Instead of always playing numAlternates alternates, play them in rounds of doubling size, and stop after
+    // any round in which the best play is decided: every other play either has a worse mean score with high
+    // confidence, or is confidently within kIndifferentScore of the best. numAlternates becomes the maximum.
+
+    void EnableCommonRandomNumbers();
+    // Roll out all of the plays of an alternate with the same sequence of random numbers, as well as the same
+    // hidden hands, so that the comparisons between plays are less noisy. This only matters for an intuition
+    // that makes random choices.
+
+    void EnableEndgameSolver(unsigned numTricks);
+    // Play the last numTricks tricks of each rollout with the EndgameSolver, which knows all of the hands of the
+    // alternate, instead of the intuition. This removes the noise of random plays at the end of the rollouts, and
+    // the intuition calls for them. numTricks is at most EndgameSolver::kMaxTricks.
 
     virtual Card choosePlay(const KnowableState& state, const RandomGenerator& rng) const;
 
+    struct Counters
+    {
+        uint64_t decisions;
+        uint64_t alternatesPlayed;
+        uint64_t rolloutsPlayed;
+        // The alternates and rollouts actually played for all of the decisions, which early stopping reduces.
+    };
+
+    Counters GetCounters() const;
+
+    virtual void printCounters() const;
+    // Prints the counters, if any decisions have been made, and then those of the intuition.
+
     virtual Card predictOutcomes(
         const KnowableState& state, const RandomGenerator& rng, float playExpectedValue[13]) const;
 
 private:
-    class Stats
+    // Aligned to a cache line, so that the Stats of threads working in parallel do not share cache lines.
+    class alignas(64) Stats
     {
     public:
         Stats(unsigned numLegalPlays = 0);
@@ -49,6 +84,8 @@ private:
             memcpy(mTotalPoints, other.mTotalPoints, sizeof(mTotalPoints));
             memcpy(mTotalTrickWins, other.mTotalTrickWins, sizeof(mTotalTrickWins));
             memcpy(mTotalMoonCounts, other.mTotalMoonCounts, sizeof(mTotalMoonCounts));
+            memcpy(mTotalScores, other.mTotalScores, sizeof(mTotalScores));
+            memcpy(mTotalSquaredDifferences, other.mTotalSquaredDifferences, sizeof(mTotalSquaredDifferences));
         }
 
         void operator=(const Stats& other)
@@ -58,6 +95,8 @@ private:
             memcpy(mTotalPoints, other.mTotalPoints, sizeof(mTotalPoints));
             memcpy(mTotalTrickWins, other.mTotalTrickWins, sizeof(mTotalTrickWins));
             memcpy(mTotalMoonCounts, other.mTotalMoonCounts, sizeof(mTotalMoonCounts));
+            memcpy(mTotalScores, other.mTotalScores, sizeof(mTotalScores));
+            memcpy(mTotalSquaredDifferences, other.mTotalSquaredDifferences, sizeof(mTotalSquaredDifferences));
         }
 
         void operator+=(const Stats& other);
@@ -67,16 +106,21 @@ private:
 
         void TrackTrickWinner(GameState& next, int iPlay);
         void UntrackTrickWinner(GameState& next);
+        void CountTrickWin(int iPlay) { ++mTotalTrickWins[iPlay]; }
 
         void UpdateForGameOutcome(const GameOutcome& outcome, int currentPlayer, int iPlay);
 
-        void FinishedOneAlternate() { ++mTotalAlternates; }
+        void FinishedOneAlternate();
+        // Call after UpdateForGameOutcome() for each of the plays of one alternate.
 
         void ComputeTargetValues(const CardHand& choices, float moonProb[13][kNumMoonCountKeys + 1],
             float winsTrickProb[13], float expectedDelta[13], unsigned pointsAlreadyTaken) const;
 
         Card BestPlay(const CardHand& choices) const;
 
+        bool IsBestPlayDecided() const;
+        // True when BestPlay() is unlikely to change with more alternates. See EnableEarlyStopping().
+
     private:
         unsigned mNumLegalPlays;
 
@@ -94,22 +138,79 @@ private:
         // Counts across all of the rollouts of when one of two significant events related to shooting the moon occured
         // There is a third event, which is the common case where points are split without anyone coming close to
         // shooting moon mc[i][0] is I shot the moon, mc[i][1] is other shot the moon
+
+        double mTotalScores[13];
+        // The sum of the standard score (as minimized by BestPlay()) for each play.
+
+        double mTotalSquaredDifferences[13][13];
+        // For i < j, the sum of the squared difference between the scores of plays i and j in the same alternate.
+        // Together with mTotalScores, this gives the variance of the paired differences, which is much smaller
+        // than the variance of the scores themselves, since both plays are rolled out from the same hands.
+
+        double mAlternateScores[13];
+        // The scores of the alternate in progress.
     };
 
-    void PlayOneAlternate(const KnowableState& knowableState, const PossibilityAnalyzer* analyzer,
-        uint128_t possibilityIndex, const CardHand& choices, const RandomGenerator& rng, Stats& stats) const;
+    void PlayOneAlternate(const KnowableState& knowableState, const DealSampler& sampler, const CardHand& choices,
+        const RandomGenerator& rng, Stats& stats) const;
+    // Samples one possible deal of the unknown cards, and rolls out the game from it once for each legal play.
+
+    void PlayOneAlternateFast(const KnowableState& knowableState, const CardHands& hands, const CardHand& choices,
+        const RandomGenerator& rng, Stats& stats) const;
+    // PlayOneAlternate() for an intuition that playsUniformlyAtRandom(), using FastRollout.
+
+    void PlayAlternatesInLockStep(const KnowableState& knowableState, const DealSampler& sampler,
+        unsigned numAlternates, const CardHand& choices, const RandomGenerator& rng, Stats& stats) const;
+    // Same as calling PlayOneAlternate() numAlternates times, but plays all of the rollouts in lock step so
+    // that the intuition can evaluate each round of decisions as one batch.
+
+    bool UsesMultiRollout() const;
+    // True when the alternates are played by PlayAlternatesRandomly().
+
+    void PlayAlternatesRandomly(const KnowableState& knowableState, const DealSampler& sampler,
+        unsigned numAlternates, const CardHand& choices, const RandomGenerator& rng, Stats& stats) const;
+    // Same as calling PlayOneAlternate() numAlternates times with an intuition that playsUniformlyAtRandom(),
+    // but plays all of the rollouts with one MultiRollout, so that several games advance together in the lanes
+    // of each SIMD instruction.
+
+    void RunRolloutsTask(const KnowableState& knowableState, const DealSampler& sampler, const CardHand& choices,
+        const RandomGenerator& rng, unsigned kNumAlts, Stats& stats) const;
+    // Plays kNumAlts alternates, adding their outcomes to stats.
 
-    Stats RunRolloutsTask(const KnowableState& knowableState, PossibilityAnalyzer* analyzer, const CardHand& choices,
-        const RandomGenerator& rng, unsigned kNumAlts) const;
+    void RunParallelTasks(const KnowableState& knowableState, const DealSampler& sampler, const CardHand& choices,
+        unsigned numAlternates, Stats& stats) const;
+    // Like RunRolloutsTask(), but on the TaskExecutor.
 
-    Stats RunParallelTasks(const KnowableState& knowableState, const RandomGenerator& rng,
-        PossibilityAnalyzer* analyzer, const CardHand& choices) const;
+    void RunAlternates(const KnowableState& knowableState, const DealSampler& sampler, const CardHand& choices,
+        const RandomGenerator& rng, unsigned numAlternates, Stats& stats) const;
+    // Calls RunParallelTasks() or RunRolloutsTask() as configured.
 
 private:
+    static constexpr unsigned kLockStepAlternates = 32;
+    // The number of alternates played together by PlayAlternatesInLockStep() and PlayAlternatesRandomly().
+    // Each alternate contributes one game per legal play, so batches have up to 13 times this many states.
+
+    static constexpr unsigned kAlternatesPerSmallTask = 4;
+    // The number of alternates in one parallel task, when the intuition does not play alternates in batches.
+
+    static constexpr unsigned kMinEarlyStoppingAlternates = 64;
+    // The size of the first round of alternates when early stopping.
+
+    static constexpr double kConfidenceZ = 2.58;
+    // Early stopping requires differences to be significant at this many standard errors, about 99% confidence.
+
+    static constexpr double kIndifferentScore = 0.25;
+    // Plays whose expected scores differ by less than this are considered equally good.
+
     StrategyPtr mIntuition;
     const uint32_t kNumAlternates;
-    const int kNumThreads;
+    const unsigned kThreadBudget;
     const bool mParallel;
-    mutable dlib::thread_pool mThreadPool;
-    dlib::mutex mStatsAccumMutex;
+    bool mEarlyStopping;
+    bool mCommonRandomNumbers;
+    unsigned mEndgameTricks;
+
+    mutable std::atomic<uint64_t> mNumDecisions;
+    mutable std::atomic<uint64_t> mNumAlternatesPlayed;
+    mutable std::atomic<uint64_t> mNumRolloutsPlayed;
 };
@@ -0,0 +1,250 @@
+// lib/MultiRollout.cpp
+
+#include "lib/MultiRollout.h"
+#include "lib/SplitMix64.h"
+
+#include <assert.h>
+#include <string.h>
+
+namespace {
+
+// GCC vector extensions let us write the kernel once. With -march=native they compile to AVX-512 or AVX2
+// (or pairs of SSE registers on older CPUs).
+// Comparisons return lanes of all ones (true) or zeros (false), which can be used as masks or in ?:.
+typedef uint64_t Lanes __attribute__((vector_size(MultiRollout::kLanes * sizeof(uint64_t))));
+
+const uint64_t kQueenOfSpadesMask = 1ul << CardFor(kQueen, kSpades);
+
+inline Lanes Load(const std::vector<uint64_t>& v, unsigned first)
+{
+  Lanes x;
+  memcpy(&x, &v[first], sizeof(x));
+  return x;
+}
+
+inline void Store(std::vector<uint64_t>& v, unsigned first, Lanes x)
+{
+  memcpy(&v[first], &x, sizeof(x));
+}
+
+inline Lanes Select(Lanes condition, Lanes a, Lanes b)
+{
+  return (Lanes) ((condition & a) | (~condition & b));
+}
+
+inline Lanes IsTrue(Lanes condition)
+{
+  return (Lanes) condition & 1;
+}
+
+inline Lanes PopCount(Lanes x)
+{
+  // There is no 64-bit lane popcount before AVX-512 VPOPCNTDQ, so count the bits SWAR style.
+  x = x - ((x >> 1) & 0x5555555555555555ul);
+  x = (x & 0x3333333333333333ul) + ((x >> 2) & 0x3333333333333333ul);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0ful;
+  x = x + (x >> 8);
+  x = x + (x >> 16);
+  x = x + (x >> 32);
+  return x & 0x7f;
+}
+
+}  // namespace
+
+MultiRollout::MultiRollout()
+: mNumGames(0)
+, mNextPlay(0)
+{}
+
+void MultiRollout::Clear()
+{
+  mNumGames = 0;
+}
+
+void MultiRollout::Add(const FastRollout& game, uint64_t seed)
+{
+  assert(mNumGames == 0 || game.mNextPlay == mNextPlay);
+  mNextPlay = game.mNextPlay;
+
+  // Grow by whole blocks. Unused lanes of the last block are filled with copies of this game below.
+  if (mNumGames % kLanes == 0)
+  {
+    const size_t size = mNumGames + kLanes;
+    for (unsigned p = 0; p < 4; ++p)
+    {
+      mHands[p].resize(size);
+      mScore[p].resize(size);
+      mPointTricks[p].resize(size);
+    }
+    for (std::vector<uint64_t>* v : {&mLead, &mTrickSuitMask, &mHighCard, &mHighPlayer, &mPointsOnTable,
+                                     &mPointsPlayed, &mFirstTrickWinner, &mSeed})
+      v->resize(size);
+  }
+
+  const unsigned end = (mNumGames / kLanes + 1) * kLanes;
+  for (unsigned i = mNumGames; i < end; ++i)
+  {
+    for (unsigned p = 0; p < 4; ++p)
+    {
+      mHands[p][i] = game.mHands[p];
+      mScore[p][i] = game.mScore[p];
+      mPointTricks[p][i] = game.mPointTricks[p];
+    }
+    mLead[i] = game.mLead;
+    mTrickSuitMask[i] = game.mTrickSuitMask;
+    mHighCard[i] = 1ul << game.mHighCard;
+    mHighPlayer[i] = game.mHighPlayer;
+    mPointsOnTable[i] = game.mPointsOnTable;
+    mPointsPlayed[i] = game.mPointsPlayed;
+    mFirstTrickWinner[i] = uint64_t(int64_t(game.mFirstTrickWinner));
+    mSeed[i] = seed;
+  }
+  ++mNumGames;
+}
+
+GameOutcome MultiRollout::Outcome(unsigned i) const
+{
+  assert(i < mNumGames);
+  unsigned pointTricks[4];
+  std::array<unsigned, 4> score;
+  for (unsigned p = 0; p < 4; ++p)
+  {
+    pointTricks[p] = mPointTricks[p][i];
+    score[p] = mScore[p][i];
+  }
+  GameOutcome outcome;
+  outcome.Set(pointTricks, score);
+  return outcome;
+}
+
+void MultiRollout::PlayOutRandomly()
+{
+  const Lanes kNoWinner = (Lanes) {} - 1;
+
+  for (unsigned first = 0; first < mNumGames; first += kLanes)
+  {
+    // The whole state of one block fits in vector registers for the duration of the rollout.
+    Lanes hands[4], score[4], pointTricks[4];
+    for (unsigned p = 0; p < 4; ++p)
+    {
+      hands[p] = Load(mHands[p], first);
+      score[p] = Load(mScore[p], first);
+      pointTricks[p] = Load(mPointTricks[p], first);
+    }
+    Lanes lead = Load(mLead, first);
+    Lanes trickSuitMask = Load(mTrickSuitMask, first);
+    Lanes highCard = Load(mHighCard, first);
+    Lanes highPlayer = Load(mHighPlayer, first);
+    Lanes pointsOnTable = Load(mPointsOnTable, first);
+    Lanes pointsPlayed = Load(mPointsPlayed, first);
+    Lanes firstTrickWinner = Load(mFirstTrickWinner, first);
+
+    // xorshift128+, one generator per lane.
+    Lanes s0, s1;
+    for (unsigned l = 0; l < kLanes; ++l)
+    {
+      uint64_t seed = mSeed[first + l];
+      s0[l] = SplitMix64(seed) | 1;
+      s1[l] = SplitMix64(seed);
+    }
+
+    // Games that have all points taken keep playing while others in the block finish, but FastRollout would
+    // have stopped them, so they must not record a first trick winner.
+    Lanes active = (Lanes) {} - 1;
+
+    for (unsigned play = mNextPlay; play < kCardsPerDeck; ++play)
+    {
+      const unsigned playInTrick = play % 4;
+      if (playInTrick == 0)
+      {
+        // Stop once every game has all points taken. The remaining plays can't change any outcome.
+        active = pointsPlayed != kMaxPointsPerHand;
+        bool allDone = true;
+        for (unsigned l = 0; l < kLanes; ++l)
+          allDone &= active[l] == 0;
+        if (allDone)
+          break;
+      }
+
+      const Lanes player = (lead + playInTrick) & 3;
+      Lanes hand = hands[0];
+      for (unsigned p = 1; p < 4; ++p)
+        hand = Select(player == p, hands[p], hand);
+
+      // The same rules as FastRollout::LegalPlays()
+      Lanes legal;
+      if (play == 0)
+        legal = hand & (1ul << CardFor(kTwo, kClubs));
+      else if (playInTrick == 0)
+        legal = Select(pointsPlayed == 0, hand & kNonPointCardsMask, hand);
+      else
+        legal = hand & trickSuitMask;
+      if (play < 4)
+        legal = Select(legal == 0, hand & kNonPointCardsMask, legal);
+      legal = Select(legal == 0, hand, legal);
+
+      // Choose a random index into the legal plays with a multiply and shift. The bias is under count/2^32.
+      Lanes x = s0;
+      const Lanes y = s1;
+      s0 = y;
+      x ^= x << 23;
+      s1 = x ^ y ^ (x >> 17) ^ (y >> 26);
+      const Lanes random = s1 + y;
+      const Lanes choice = ((random >> 32) * PopCount(legal)) >> 32;
+
+      // Clear the lowest set bit choice times, then isolate the lowest remaining bit. A hand holds at most
+      // 13 - play/4 cards, which bounds the number of steps.
+      Lanes remaining = legal;
+      const unsigned kMaxChoices = kCardsPerHand - play / 4;
+      for (unsigned k = 1; k < kMaxChoices; ++k)
+        remaining = Select(choice >= k, remaining & (remaining - 1), remaining);
+      const Lanes card = remaining & -remaining;
+
+      // Exactly one hand holds the card.
+      for (unsigned p = 0; p < 4; ++p)
+        hands[p] &= ~card;
+
+      const Lanes points = IsTrue((card & kAllHeartsMask) != 0) + (IsTrue((card & kQueenOfSpadesMask) != 0) * 13);
+
+      if (playInTrick == 0)
+      {
+        trickSuitMask = (Lanes) {};
+        for (Suit suit = 0; suit < kSuitsPerDeck; ++suit)
+          trickSuitMask |= ((card & CardArray::SuitMask(suit)) != 0) & CardArray::SuitMask(suit);
+        highCard = card;
+        highPlayer = player;
+        pointsOnTable = points;
+      }
+      else
+      {
+        // Cards of one suit are ordered like their masks.
+        const Lanes beats = ((card & trickSuitMask) != 0) & (card > highCard);
+        highCard = Select(beats, card, highCard);
+        highPlayer = Select(beats, player, highPlayer);
+        pointsOnTable += points;
+      }
+
+      if (playInTrick == 3)
+      {
+        firstTrickWinner = Select(active & (firstTrickWinner == kNoWinner), highPlayer, firstTrickWinner);
+        const Lanes tookPoints = pointsOnTable != 0;
+        for (unsigned p = 0; p < 4; ++p)
+        {
+          const Lanes won = highPlayer == p;
+          score[p] += won & pointsOnTable;
+          pointTricks[p] += IsTrue(won & tookPoints);
+        }
+        pointsPlayed += pointsOnTable;
+        lead = highPlayer;
+      }
+    }
+
+    // Only the results are stored. The games are not left in a state that could be continued.
+    for (unsigned p = 0; p < 4; ++p)
+    {
+      Store(mScore[p], first, score[p]);
+      Store(mPointTricks[p], first, pointTricks[p]);
+    }
+    Store(mFirstTrickWinner, first, firstTrickWinner);
+  }
+}
@@ -0,0 +1,63 @@
+// lib/MultiRollout.h
+
+#pragma once
+
+#include "lib/FastRollout.h"
+
+#include <vector>
+
+// MultiRollout plays out many FastRollout games at once with SIMD instructions. The games are stored in
+// structure of arrays form, and are advanced one play at a time in blocks of kLanes games, each game in its
+// own vector lane. Legal play masking, random card selection, trick winner evaluation and scoring are all
+// computed on the card masks of a whole block without branches.
+//
+// All of the games must be at the same play number, which is always the case for the rollouts of one
+// MonteCarlo decision: the games differ in the hidden hands and in the card chosen for the current play.
+//
+// The outcomes have the same distribution as FastRollout::PlayOutRandomly(), but each lane uses its own
+// xorshift128+ generator, seeded from the seed its game was added with. Games added with the same seed draw the
+// same sequence of random numbers, so they choose the same play whenever they have the same number of choices.
+class MultiRollout
+{
+public:
+#ifdef __AVX512F__
+  static constexpr unsigned kLanes = 8;
+#else
+  static constexpr unsigned kLanes = 4;
+#endif
+    // The number of 64-bit lanes in one vector register: 8 for AVX-512, 4 for AVX2.
+
+  MultiRollout();
+
+  void Clear();
+
+  void Add(const FastRollout& game, uint64_t seed);
+
+  unsigned Size() const { return mNumGames; }
+
+  void PlayOutRandomly();
+    // Plays all of the games until all points have been taken. Call it once, after adding the games.
+
+  GameOutcome Outcome(unsigned i) const;
+
+  int FirstTrickWinner(unsigned i) const { return int(mFirstTrickWinner[i]); }
+    // As FastRollout::FirstTrickWinner()
+
+private:
+  unsigned mNumGames;
+  unsigned mNextPlay;
+
+  // One entry per game, padded to a multiple of kLanes.
+  std::vector<uint64_t> mHands[4];
+  std::vector<uint64_t> mLead;
+  std::vector<uint64_t> mTrickSuitMask;
+  std::vector<uint64_t> mHighCard;
+    // The bit mask of the high card in the trick, since comparing masks orders cards like comparing cards.
+  std::vector<uint64_t> mHighPlayer;
+  std::vector<uint64_t> mPointsOnTable;
+  std::vector<uint64_t> mPointsPlayed;
+  std::vector<uint64_t> mFirstTrickWinner;
+  std::vector<uint64_t> mScore[4];
+  std::vector<uint64_t> mPointTricks[4];
+  std::vector<uint64_t> mSeed;
+};
@@ -1,4 +1,5 @@
 #include "lib/NoVoidsAnalyzer.h"
+#include "lib/DealSampler.h"
 #include "lib/Deal.h"
 
 NoVoidsAnalyzer::NoVoidsAnalyzer(const CardDeck& remaining, const CardHands& hands, const VoidBits& voidBits)
@@ -7,6 +8,15 @@ NoVoidsAnalyzer::NoVoidsAnalyzer(const CardDeck& remaining, const CardHands& han
 , mVoidBits(voidBits)
 {
   mVoidBits.VerifyVoids(mHands);
+  mPossibilities = PossibleDealUnknownsToHands(mRemaining, mHands);
+
+  // Each card is equally likely to go to any of the available places in the hands.
+  const double numRemaining = mRemaining.Size();
+  for (Suit suit=0; suit<4; ++suit) {
+    const unsigned inSuit = mRemaining.CountCardsWithSuit(suit);
+    for (unsigned p=0; p<4; ++p)
+      mExpectedCards[suit][p] = inSuit * mHands[p].AvailableCapacity() / numRemaining;
+  }
 
   // for (int suit=0; suit<4; ++suit) {
   //   if (remaining.CountCardsWithSuit(suit) > 0) {
@@ -19,11 +29,6 @@ NoVoidsAnalyzer::~NoVoidsAnalyzer()
 {
 }
 
-uint128_t NoVoidsAnalyzer::Possibilities() const
-{
-  return PossibleDealUnknownsToHands(mRemaining, mHands);
-}
-
 void NoVoidsAnalyzer::ActualizePossibility(uint128_t possibility_index, CardHands& hands) const
 {
   DealUnknownsToHands(mRemaining, hands, possibility_index);
@@ -34,12 +39,17 @@ void NoVoidsAnalyzer::AddStage(const CardDeck& other_remaining, PriorityList& li
   assert(false);
 }
 
+unsigned NoVoidsAnalyzer::AddToSampler(DealSampler& sampler) const
+{
+  return sampler.AddDealRest(mRemaining, mHands);
+}
+
 void NoVoidsAnalyzer::RenderDot(std::ostream& stream) const
 {
   stream << "id_" << uint64_t(this) << " [label=\"NoVoids count(" << int(mRemaining.Size())  <<  ")\"];" << std::endl;
 }
 
-void NoVoidsAnalyzer::ExpectedDistribution(Distribution& distribution, CardHands& hands)
+void NoVoidsAnalyzer::ExpectedDistribution(Distribution& distribution, CardHands& hands) const
 {
   assert(hands.TotalCapacity() == mRemaining.Size());
 
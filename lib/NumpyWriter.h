@@ -2,14 +2,14 @@
 
 #pragma once
 
+#include "lib/BlockWriter.h"
+
 #include <unsupported/Eigen/CXX11/Tensor>
 #include <vector>
 #include <stdexcept>
-#include <fcntl.h>
-#include <system_error>
-#include <unistd.h>
 
 // For now, we only support writing arrays of single precision float
+// The file is written by a BlockWriter, so the tensors are written in large blocks by the IoThread.
 
 template <int rank>
 class NumpyWriter
@@ -20,13 +20,16 @@ public:
     // Only tensors with the given shape may be written.
 
   ~NumpyWriter();
-    // Updates the header for the total number of tensors written, then closes the file
+    // Writes the last block and updates the header for the total number of tensors written, then closes the file.
+    // Those writes are left to the IoThread: the file is complete once IoThread::Shared().Wait() returns.
 
   void Append(const Eigen::Tensor<float, rank, Eigen::RowMajor>& tensor);
     // Appends the tensor to the file
     // tensor must have the shape specified in ctor
     // Tensors must use RowMajor layout to be compatible with numpy files
 
+  unsigned NumTensors() const { return mNumTensors; }
+
 private:
 
   enum Constants {
@@ -42,20 +45,18 @@ private:
     kSpace = 0x20,
   };
 
-  void Write(const void* buffer, int numBytes) const;
-
   void PaddedHeader(char header[HEADER_LEN]) const;
     // Fills the entire header with spaces except for last character which will be newline
 
-  void WriteHeader() const;
+  void WriteHeader();
 
   std::string ShapeFor() const;
 
-  void UpdateFileSize() const;
+  std::string HeaderDict() const;
+    // The header, for the total number of tensors written
 
 private:
-  const int mFile;
-    // The unix file descriptor
+  BlockWriter mFile;
 
   const std::vector<int> mShape;
     // The shape of all tensors written to this file
@@ -65,19 +66,15 @@ private:
 
   unsigned mNumTensors;
     // The number of tensors that have been written to the file
-
 };
 
 template <int rank>
 NumpyWriter<rank>::NumpyWriter(const std::string& path, const std::vector<int>& shape)
-: mFile(::open(path.c_str(), O_CREAT|O_WRONLY|O_TRUNC, 0644))
+: mFile(path)
 , mShape(shape)
 , mLenOffset(0)
 , mNumTensors(0)
 {
-  if (mFile == -1) {
-    throw std::system_error(std::error_code(), "Error opening numpy file for read/write access" );
-  }
   if (mShape.size() != rank) {
     throw std::invalid_argument("Shape not consistent with rank");
   }
@@ -87,17 +84,7 @@ NumpyWriter<rank>::NumpyWriter(const std::string& path, const std::vector<int>&
 template <int rank>
 NumpyWriter<rank>::~NumpyWriter()
 {
-  UpdateFileSize();
-  ::close(mFile);
-}
-
-template <int rank>
-void NumpyWriter<rank>::Write(const void* buffer, int numBytes) const
-{
-  ssize_t actual = ::write(mFile, buffer, numBytes);
-  if (actual != numBytes) {
-    throw std::system_error(std::error_code(), "Failed to write expected number of bytes");
-  }
+  mFile.WriteAt(kDictOffset, HeaderDict());
 }
 
 template <int rank>
@@ -112,17 +99,17 @@ void NumpyWriter<rank>::PaddedHeader(char fill[HEADER_LEN]) const
 
 
 template <int rank>
-void NumpyWriter<rank>::WriteHeader() const {
-  Write("\x93NUMPY\x01\x00", kMagicStrLen);
+void NumpyWriter<rank>::WriteHeader() {
+  mFile.Append("\x93NUMPY\x01\x00", kMagicStrLen);
 
   // Note: we're assuming this code will only run on little-endian machines.
   // Should be a safe assumption because it is highly unlikely it will ever run on anything other than x86.
   const unsigned short kHeaderLen = HEADER_LEN;
-  Write(&kHeaderLen, kSizeofShort);
+  mFile.Append(&kHeaderLen, kSizeofShort);
 
   char header[HEADER_LEN];
   PaddedHeader(header);
-  Write(header, HEADER_LEN);
+  mFile.Append(header, HEADER_LEN);
 }
 
 template <int rank>
@@ -139,7 +126,7 @@ std::string NumpyWriter<rank>::ShapeFor() const
 }
 
 template <int rank>
-void NumpyWriter<rank>::UpdateFileSize() const
+std::string NumpyWriter<rank>::HeaderDict() const
 {
   // The <f4 is the data type for single precision float. We hard code it here.
   // To support other types, we'd need to derive the correct numpy dtype string from the C++ type.
@@ -152,9 +139,7 @@ void NumpyWriter<rank>::UpdateFileSize() const
   dict[actual] = kSpace;
   assert(dict[HEADER_LEN-2] == kSpace);
   assert(dict[HEADER_LEN-1] == '\n');
-
-  lseek(mFile, kDictOffset, SEEK_SET);
-  Write(dict, HEADER_LEN);
+  return std::string(dict, HEADER_LEN);
 }
 
 template <int rank>
@@ -168,6 +153,6 @@ void NumpyWriter<rank>::Append(const Eigen::Tensor<float, rank, Eigen::RowMajor>
   const float* raw = tensor.data();
   ssize_t kBytes = sizeof(float)*tensor.size();
   assert(kBytes > 4);
-  Write(raw, kBytes);
+  mFile.Append(raw, kBytes);
   ++mNumTensors;
 }
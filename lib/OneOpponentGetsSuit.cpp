@@ -1,4 +1,5 @@
 #include "lib/OneOpponentGetsSuit.h"
+#include "lib/DealSampler.h"
 
 unsigned OpponentToGetCards(unsigned player, const VoidBits& voidBits, Suit suit)
 {
@@ -25,19 +26,13 @@ OneOpponentGetsSuit::OneOpponentGetsSuit(unsigned player, const VoidBits& voidBi
 , mRemainingOfSuit(remainingOfSuit)
 , mOtherRemaining(otherRemaining)
 , mOpponent(OpponentToGetCards(player, voidBits, suit))
-, mNextStage(0)
+, mNextStage()
 , mHands(hands)
 {
 }
 
 OneOpponentGetsSuit::~OneOpponentGetsSuit()
 {
-  delete mNextStage;
-}
-
-uint128_t OneOpponentGetsSuit::Possibilities() const
-{
-  return mNextStage->Possibilities();
 }
 
 void OneOpponentGetsSuit::ActualizePossibility(uint128_t possibility_index, CardHands& hands) const
@@ -53,16 +48,24 @@ void OneOpponentGetsSuit::AddStage(const CardDeck& other_remaining, PriorityList
   CardHands hands(mHands);
   hands[mOpponent].Merge(mRemainingOfSuit);
   mNextStage = BuildAnalyzer(mPlayer, mVoidBits, prioList, other_remaining, hands);
+  mPossibilities = mNextStage->Possibilities();
+  SetExpectedCards(*mNextStage);
+  mExpectedCards[mSuit][mOpponent] += mRemainingOfSuit.Size();
+}
+
+unsigned OneOpponentGetsSuit::AddToSampler(DealSampler& sampler) const
+{
+  return sampler.AddGiveSuit(mOpponent, mRemainingOfSuit, *mNextStage);
 }
 
 void OneOpponentGetsSuit::RenderDot(std::ostream& stream) const
 {
   stream << "id_" << uint64_t(this) << " [label=\"One suit(" << NameOfSuit(mSuit) << ") count(" << int(mRemainingOfSuit.Size())  <<  ")\"];" << std::endl;
-  stream << "id_" << uint64_t(this) << " -> id_" << uint64_t(mNextStage) << std::endl;
+  stream << "id_" << uint64_t(this) << " -> id_" << uint64_t(mNextStage.get()) << std::endl;
   mNextStage->RenderDot(stream);
 }
 
-void OneOpponentGetsSuit::ExpectedDistribution(Distribution& distribution, CardHands& hands)
+void OneOpponentGetsSuit::ExpectedDistribution(Distribution& distribution, CardHands& hands) const
 {
   assert(hands.TotalCapacity() == mRemainingOfSuit.Size() + mOtherRemaining.Size());
 
@@ -8,15 +8,15 @@ public:
           , const CardDeck& otherRemaining, const CardHands& hands);
   virtual ~OneOpponentGetsSuit();
 
-  virtual uint128_t Possibilities() const;
-
   virtual void ActualizePossibility(uint128_t possibility_index, CardHands& hands) const;
 
   virtual void AddStage(const CardDeck& other_remaining, PriorityList& list);
 
+  virtual unsigned AddToSampler(DealSampler& sampler) const;
+
   virtual void RenderDot(std::ostream& stream) const;
 
-  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands);
+  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands) const;
 
 private:
   const unsigned mPlayer;
@@ -25,6 +25,6 @@ private:
   const CardDeck mRemainingOfSuit;
   const CardDeck mOtherRemaining;
   const unsigned mOpponent;
-  PossibilityAnalyzer* mNextStage;
+  PossibilityAnalyzerPtr mNextStage;
   CardHands mHands;
 };
@@ -0,0 +1,64 @@
+// lib/PackedGameState.cpp
+
+#include "lib/PackedGameState.h"
+#include "lib/Bits.h"
+#include "lib/GameState.h"
+#include "lib/VoidBits.h"
+
+#include <string.h>
+
+PackedGameState::PackedGameState(const GameState& state)
+{
+  // Zero the padding and the unused trick cards, so that equal states compare equal with memcmp.
+  memset(this, 0, sizeof(*this));
+  for (unsigned p=0; p<4; ++p) {
+    mHands[p] = state.HandForPlayer(p).Bits();
+    mScore[p] = uint8_t(state.GetScoreFor(p));
+    mPointTricks[p] = uint8_t(state.GetPointTricksFor(p));
+  }
+  for (unsigned i=0; i<state.PlayInTrick(); ++i)
+    mTrick[i] = state.GetTrickPlay(i);
+  mNextPlay = uint8_t(state.PlayNumber());
+  mLead = uint8_t(state.PlayerLeadingTrick());
+  mVoidBits = state.IsVoidBits().Bits();
+}
+
+bool PackedGameState::operator==(const PackedGameState& other) const
+{
+  return memcmp(this, &other, sizeof(*this)) == 0;
+}
+
+bool PackedGameState::IsValid() const
+{
+  if (mNextPlay >= kCardsPerDeck || mLead >= 4)
+    return false;
+
+  uint64_t cards = 0;
+  for (unsigned i=0; i<PlayInTrick(); ++i) {
+    if (mTrick[i] >= kCardsPerDeck || (cards & (1ul << mTrick[i])) != 0)
+      return false;
+    cards |= 1ul << mTrick[i];
+  }
+
+  const unsigned trick = mNextPlay / 4;
+  const VoidBits voids(mVoidBits);
+  unsigned points = 0;
+  for (unsigned p=0; p<4; ++p) {
+    // The players who have played to this trick hold one card fewer.
+    const unsigned played = (p + 4 - mLead) % 4 < PlayInTrick() ? 1 : 0;
+    if ((mHands[p] & ~kAllCardsMask) != 0 || (mHands[p] & cards) != 0
+     || unsigned(CountBits(mHands[p])) != kCardsPerHand - trick - played)
+      return false;
+    cards |= mHands[p];
+    for (Suit suit=0; suit<kSuitsPerDeck; ++suit) {
+      if (voids.isVoid(p, suit) && (mHands[p] & CardArray::SuitMask(suit)) != 0)
+        return false;
+    }
+    if (mPointTricks[p] > trick)
+      return false;
+    points += mScore[p];
+  }
+
+  const uint64_t taken = ~cards & kAllCardsMask;
+  return points == unsigned(CountBits(taken & kAllHeartsMask)) + ((taken & (1ul << TheQueen())) != 0 ? 13 : 0);
+}
@@ -0,0 +1,51 @@
+// lib/PackedGameState.h
+
+#pragma once
+
+#include "lib/Card.h"
+
+#include <stdint.h>
+#include <type_traits>
+
+class GameState;
+
+// PackedGameState is the full state of a game in 48 bytes: the four hands as 52-bit masks, the cards on the table,
+// the lead, the play number, the scores and the known voids. It has no virtual functions, hooks or pointers, so it
+// can be copied with memcpy, kept in arrays, and copied for each legal play of a rollout within one cache line.
+//
+// Everything else that GameState tracks is derived from it: the trick suit is the suit of the first card on the
+// table, the unplayed cards are the cards still in the hands, and the points played are the sum of the scores.
+// The deal index is not kept, so a GameState unpacked from a PackedGameState has deal index 0.
+struct PackedGameState
+{
+  PackedGameState() = default;
+  explicit PackedGameState(const GameState& state);
+
+  unsigned PlayNumber() const { return mNextPlay; }
+  unsigned PlayInTrick() const { return mNextPlay % 4; }
+  unsigned CurrentPlayer() const { return (mLead + PlayInTrick()) % 4; }
+  bool Done() const { return mNextPlay == kCardsPerDeck; }
+
+  bool operator==(const PackedGameState& other) const;
+
+  bool IsValid() const;
+    // Whether the state holds the invariants that GameState asserts: the play number is less than 52, the lead is a
+    // player, the hands and the cards on the table are disjoint and of the right sizes, no player holds a suit
+    // they are known to be void in, and the scores are the points of the finished tricks.
+    // For states from outside the engine, such as from python.
+
+  uint64_t mHands[4];
+  Card mTrick[3];
+    // The cards on the table, in the order they were played. Only the first PlayInTrick() are valid.
+  uint8_t mNextPlay;
+  uint8_t mLead;
+  uint8_t mScore[4];
+  uint8_t mPointTricks[4];
+    // As in HeartsState, the number of tricks with points that each player has won.
+  uint16_t mVoidBits;
+    // VoidBits::Bits()
+};
+
+static_assert(sizeof(PackedGameState) == 48, "PackedGameState should be 48 bytes");
+static_assert(std::is_trivial<PackedGameState>::value && std::is_standard_layout<PackedGameState>::value
+            , "PackedGameState should be a POD type");
@@ -0,0 +1,93 @@
+// lib/PackedKnowableState.cpp
+
+#include "lib/PackedKnowableState.h"
+#include "lib/Bits.h"
+#include "lib/KnowableState.h"
+#include "lib/VoidBits.h"
+
+#include <string.h>
+
+PackedKnowableState::PackedKnowableState(const KnowableState& state)
+{
+  // Zero the padding and the unused trick cards, so that equal states compare equal with memcmp.
+  memset(this, 0, sizeof(*this));
+  mHand = state.CurrentPlayersHand().Bits();
+  mUnplayed = state.UnplayedCards().Bits();
+  for (unsigned p=0; p<4; ++p) {
+    mScore[p] = uint8_t(state.GetScoreFor(p));
+    mPointTricks[p] = uint8_t(state.GetPointTricksFor(p));
+  }
+  for (unsigned i=0; i<state.PlayInTrick(); ++i)
+    mTrick[i] = state.GetTrickPlay(i);
+  mNextPlay = uint8_t(state.PlayNumber());
+  mLead = uint8_t(state.PlayerLeadingTrick());
+  mVoidBits = state.IsVoidBits().Bits();
+}
+
+bool PackedKnowableState::operator==(const PackedKnowableState& other) const
+{
+  return memcmp(this, &other, sizeof(*this)) == 0;
+}
+
+bool PackedKnowableState::IsValid() const
+{
+  if (mNextPlay >= kCardsPerDeck || mLead >= 4)
+    return false;
+
+  uint64_t onTable = 0;
+  for (unsigned i=0; i<PlayInTrick(); ++i) {
+    if (mTrick[i] >= kCardsPerDeck || (onTable & (1ul << mTrick[i])) != 0)
+      return false;
+    onTable |= 1ul << mTrick[i];
+  }
+
+  // The current player has not played to this trick yet.
+  const unsigned trick = mNextPlay / 4;
+  if ((mUnplayed & ~kAllCardsMask) != 0 || (mUnplayed & onTable) != 0 || (mHand & ~mUnplayed) != 0
+   || unsigned(CountBits(mUnplayed)) != unsigned(kCardsPerDeck - mNextPlay)
+   || unsigned(CountBits(mHand)) != kCardsPerHand - trick)
+    return false;
+
+  const VoidBits voids(mVoidBits);
+  for (Suit suit=0; suit<kSuitsPerDeck; ++suit) {
+    if (voids.isVoid(CurrentPlayer(), suit) && (mHand & CardArray::SuitMask(suit)) != 0)
+      return false;
+  }
+
+  unsigned points = 0;
+  for (unsigned p=0; p<4; ++p) {
+    if (mPointTricks[p] > trick)
+      return false;
+    points += mScore[p];
+  }
+  const uint64_t taken = ~(mUnplayed | onTable) & kAllCardsMask;
+  if (points != unsigned(CountBits(taken & kAllHeartsMask)) + ((taken & (1ul << TheQueen())) != 0 ? 13 : 0))
+    return false;
+
+  // The other players must be able to hold the unknown cards, given their voids. Since the unknown cards fill
+  // the other hands exactly, it is enough that the cards of each set of suits fit in the hands of the players who
+  // are not void in all of them (Hall's theorem).
+  unsigned capacity[4];
+  for (unsigned p=0; p<4; ++p)
+    capacity[p] = p == CurrentPlayer() ? 0 : kCardsPerHand - trick - ((p + 4 - mLead) % 4 < PlayInTrick() ? 1 : 0);
+  const uint64_t unknown = mUnplayed & ~mHand;
+  for (unsigned suits=1; suits<16; ++suits) {
+    unsigned cards = 0;
+    for (Suit suit=0; suit<kSuitsPerDeck; ++suit) {
+      if (suits & (1u << suit))
+        cards += CountBits(unknown & CardArray::SuitMask(suit));
+    }
+    unsigned room = 0;
+    for (unsigned p=0; p<4; ++p) {
+      for (Suit suit=0; suit<kSuitsPerDeck; ++suit) {
+        if ((suits & (1u << suit)) && !voids.isVoid(p, suit)) {
+          room += capacity[p];
+          break;
+        }
+      }
+    }
+    if (cards > room)
+      return false;
+  }
+  return true;
+}
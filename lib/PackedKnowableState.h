@@ -0,0 +1,49 @@
+// lib/PackedKnowableState.h
+
+#pragma once
+
+#include "lib/Card.h"
+
+#include <stdint.h>
+#include <type_traits>
+
+class KnowableState;
+
+// PackedKnowableState is what the current player knows about a game in 32 bytes: their hand, the unplayed cards,
+// the cards on the table, the lead, the play number, the scores and the known voids. It is stored in training data
+// in place of (or beside) the features, so that the features can be computed again when their definition changes,
+// without generating the data again. Like PackedGameState, it is a POD type that can be copied with memcpy.
+//
+// The unplayed cards include the hand and exclude the cards on the table.
+struct PackedKnowableState
+{
+  PackedKnowableState() = default;
+  explicit PackedKnowableState(const KnowableState& state);
+
+  unsigned PlayNumber() const { return mNextPlay; }
+  unsigned PlayInTrick() const { return mNextPlay % 4; }
+  unsigned CurrentPlayer() const { return (mLead + PlayInTrick()) % 4; }
+
+  bool operator==(const PackedKnowableState& other) const;
+
+  bool IsValid() const;
+    // As PackedGameState::IsValid(), for what the current player knows: the hand is unplayed and of the right
+    // size, the unplayed cards and the cards on the table are disjoint, and the other players can hold the unknown
+    // cards without breaking their known voids, so that PossibilityAnalyzer has a possible deal.
+
+  uint64_t mHand;
+  uint64_t mUnplayed;
+  Card mTrick[3];
+    // The cards on the table, in the order they were played. Only the first PlayInTrick() are valid.
+  uint8_t mNextPlay;
+  uint8_t mLead;
+  uint8_t mScore[4];
+  uint8_t mPointTricks[4];
+    // As in HeartsState, the number of tricks with points that each player has won.
+  uint16_t mVoidBits;
+    // VoidBits::Bits()
+};
+
+static_assert(sizeof(PackedKnowableState) == 32, "PackedKnowableState should be 32 bytes");
+static_assert(std::is_trivial<PackedKnowableState>::value && std::is_standard_layout<PackedKnowableState>::value
+            , "PackedKnowableState should be a POD type");
@@ -1,13 +1,20 @@
 #include "lib/PossibilityAnalyzer.h"
+#include "lib/DealSampler.h"
 #include "lib/NoVoidsAnalyzer.h"
 #include "lib/OneOpponentGetsSuit.h"
 #include "lib/TwoOpponentsGetSuit.h"
 
+#include "dlib/threads.h"
+
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <unordered_map>
 
 PossibilityAnalyzer::PossibilityAnalyzer()
+: mPossibilities(0)
+, mExpectedCards()
 {
 }
 
@@ -15,11 +22,57 @@ PossibilityAnalyzer::~PossibilityAnalyzer()
 {
 }
 
-PossibilityAnalyzer* BuildAnalyzer(unsigned player, const VoidBits& voidBits, PriorityList& priorityList, const CardDeck& remaining, const CardHands& hands)
+void PossibilityAnalyzer::SetExpectedCards(const PossibilityAnalyzer& next)
 {
-  voidBits.VerifyVoids(hands);
+  std::copy(&next.mExpectedCards[0][0], &next.mExpectedCards[0][0] + 16, &mExpectedCards[0][0]);
+}
 
-  const VoidBits otherVoids = voidBits.ForOthers(player);
+namespace {
+
+struct AnalyzerKey
+{
+  uint64_t remaining;
+  uint64_t constraints;
+    // The other players' voids, the available capacity of each hand, the player, and the priority list.
+
+  bool operator==(const AnalyzerKey& other) const
+  {
+    return remaining == other.remaining && constraints == other.constraints;
+  }
+};
+
+struct AnalyzerKeyHash
+{
+  size_t operator()(const AnalyzerKey& key) const
+  {
+    return size_t(key.remaining * 0x9E3779B97F4A7C15ull ^ key.constraints);
+  }
+};
+
+AnalyzerKey MakeAnalyzerKey(unsigned player, const VoidBits& otherVoids, const PriorityList& priorityList
+                          , const CardDeck& remaining, const CardHands& hands)
+{
+  assert(priorityList.size() <= 4);
+  uint64_t constraints = otherVoids.Bits();
+  for (unsigned i=0; i<4; ++i)
+    constraints |= uint64_t(hands[i].AvailableCapacity()) << (16 + 4*i);
+  constraints |= uint64_t(player) << 32;
+  constraints |= uint64_t(priorityList.size()) << 34;
+  for (unsigned i=0; i<priorityList.size(); ++i)
+    constraints |= uint64_t(priorityList[i].suit | priorityList[i].numVoids << 2) << (40 + 4*i);
+  return AnalyzerKey{remaining.Bits(), constraints};
+}
+
+const size_t kMaxCachedAnalyzers = 1 << 16;
+  // When the cache grows past this many trees it is cleared, rather than tracking which trees are least used.
+  // Trees still in use by a caller are kept alive by their references.
+
+dlib::mutex gAnalyzerCacheMutex;
+std::unordered_map<AnalyzerKey, PossibilityAnalyzerPtr, AnalyzerKeyHash> gAnalyzerCache;
+
+PossibilityAnalyzerPtr BuildUncachedAnalyzer(unsigned player, const VoidBits& otherVoids, PriorityList& priorityList
+                                           , const CardDeck& remaining, const CardHands& hands)
+{
   bool done = false;
   SuitVoids suitVoids;
   while (true) {
@@ -35,9 +88,9 @@ PossibilityAnalyzer* BuildAnalyzer(unsigned player, const VoidBits& voidBits, Pr
 
   if (done || suitVoids.numVoids == 0) {
     if (remaining.Size()) {
-      return new NoVoidsAnalyzer(remaining, hands, otherVoids);
+      return MakeAnalyzer<NoVoidsAnalyzer>(remaining, hands, otherVoids);
     } else {
-      return new NoneRemaining();
+      return MakeAnalyzer<NoneRemaining>();
     }
   }
 
@@ -45,17 +98,17 @@ PossibilityAnalyzer* BuildAnalyzer(unsigned player, const VoidBits& voidBits, Pr
   CardDeck remainingOfSuit, otherRemaining;
   remaining.PartitionRemaining(suit, remainingOfSuit, otherRemaining);
 
-  PossibilityAnalyzer* parent = 0;
+  std::shared_ptr<PossibilityAnalyzer> parent;
   switch(suitVoids.numVoids)
   {
     case 2:
     {
-      parent = new OneOpponentGetsSuit(player, otherVoids, suit, remainingOfSuit, otherRemaining, hands);
+      parent = MakeAnalyzer<OneOpponentGetsSuit>(player, otherVoids, suit, remainingOfSuit, otherRemaining, hands);
       break;
     }
     case 1:
     {
-      parent = new TwoOpponentsGetSuit(player, otherVoids, suit, remainingOfSuit, otherRemaining, hands);
+      parent = MakeAnalyzer<TwoOpponentsGetSuit>(player, otherVoids, suit, remainingOfSuit, otherRemaining, hands);
       break;
     }
     default:
@@ -66,6 +119,44 @@ PossibilityAnalyzer* BuildAnalyzer(unsigned player, const VoidBits& voidBits, Pr
   return parent;
 }
 
+} // namespace
+
+PossibilityAnalyzerPtr BuildAnalyzer(unsigned player, const VoidBits& voidBits, PriorityList& priorityList
+                                    , const CardDeck& remaining, const CardHands& hands)
+{
+  voidBits.VerifyVoids(hands);
+
+  const VoidBits otherVoids = voidBits.ForOthers(player);
+  const AnalyzerKey key = MakeAnalyzerKey(player, otherVoids, priorityList, remaining, hands);
+  {
+    dlib::auto_mutex locker(gAnalyzerCacheMutex);
+    auto it = gAnalyzerCache.find(key);
+    if (it != gAnalyzerCache.end())
+      return it->second;
+  }
+
+  // Build without holding the lock, since building recurses into BuildAnalyzer() for the later stages.
+  // If another thread builds the same tree meanwhile, the first one cached is kept.
+  PossibilityAnalyzerPtr analyzer = BuildUncachedAnalyzer(player, otherVoids, priorityList, remaining, hands);
+
+  dlib::auto_mutex locker(gAnalyzerCacheMutex);
+  if (gAnalyzerCache.size() >= kMaxCachedAnalyzers)
+    gAnalyzerCache.clear();
+  return gAnalyzerCache.emplace(key, analyzer).first->second;
+}
+
+void ClearAnalyzerCache()
+{
+  dlib::auto_mutex locker(gAnalyzerCacheMutex);
+  gAnalyzerCache.clear();
+}
+
+size_t AnalyzerCacheSize()
+{
+  dlib::auto_mutex locker(gAnalyzerCacheMutex);
+  return gAnalyzerCache.size();
+}
+
 void PossibilityAnalyzer::RenderDotToFile(const std::string& path, const CardDeck& unknownCardsRemaining) const
 {
   std::ofstream file;
@@ -90,17 +181,13 @@ std::string PossibilityAnalyzer::RenderDotToString() const
 
 Impossible::Impossible()
 {
+  mPossibilities = 0;
 }
 
 Impossible::~Impossible()
 {
 }
 
-uint128_t Impossible::Possibilities() const
-{
-  return 0;
-}
-
 void Impossible::ActualizePossibility(uint128_t possibility_index, CardHands& hands) const
 {
   assert(false);
@@ -110,29 +197,32 @@ void Impossible::AddStage(const CardDeck& other_remaining, PriorityList& list)
 {
 }
 
+unsigned Impossible::AddToSampler(DealSampler& sampler) const
+{
+  // Ways that are impossible have no possibilities to sample, so they are never lowered.
+  assert(false);
+  return 0;
+}
+
 void Impossible::RenderDot(std::ostream& stream) const
 {
   stream << "id_" << uint64_t(this) << " [label=\"Impossible\"];" << std::endl;
 }
 
-void Impossible::ExpectedDistribution(Distribution& distribution, CardHands& hands)
+void Impossible::ExpectedDistribution(Distribution& distribution, CardHands& hands) const
 {
   assert(false);
 }
 
 NoneRemaining::NoneRemaining()
 {
+  mPossibilities = 1;
 }
 
 NoneRemaining::~NoneRemaining()
 {
 }
 
-uint128_t NoneRemaining::Possibilities() const
-{
-  return 1;
-}
-
 void NoneRemaining::ActualizePossibility(uint128_t possibility_index, CardHands& hands) const
 {
   assert(possibility_index == 0);
@@ -146,6 +236,11 @@ void NoneRemaining::AddStage(const CardDeck& other_remaining, PriorityList& list
   assert(list.size() == 0);
 }
 
+unsigned NoneRemaining::AddToSampler(DealSampler& sampler) const
+{
+  return sampler.AddNoneRemaining();
+}
+
 void NoneRemaining::RenderDot(std::ostream& stream) const
 {
   stream << "id_" << uint64_t(this) << " [label=\"NoneRemaining\"];" << std::endl;
@@ -1,53 +1,94 @@
 #pragma once
 
+#include "lib/Arena.h"
 #include "lib/Card.h"
 #include "lib/CardArray.h"
 #include "lib/math.h"
 #include "lib/VoidBits.h"
 #include "lib/Distribution.h"
 
+#include <memory>
 #include <ostream>
 #include <vector>
 
+class DealSampler;
+class PossibilityAnalyzer;
+
+typedef std::shared_ptr<const PossibilityAnalyzer> PossibilityAnalyzerPtr;
+
 class PossibilityAnalyzer {
 public:
   PossibilityAnalyzer();
   virtual ~PossibilityAnalyzer();
 
-  virtual uint128_t Possibilities() const = 0;
+  uint128_t Possibilities() const { return mPossibilities; }
+    // Computed once, when the analyzer is fully built.
+
+  double ExpectedCards(Suit suit, unsigned player) const { return mExpectedCards[suit][player]; }
+    // The expected number of the unknown cards of the suit dealt to the player, over all of the possibilities.
+    // The unknown cards of one suit are interchangeable, so dividing by the number of unknown cards in the suit
+    // gives the exact probability that the player holds any one of them. Computed when the analyzer is built,
+    // so it is memoized with the analyzer.
 
   virtual void ActualizePossibility(uint128_t possibility_index, CardHands& hands) const = 0;
 
-  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands) = 0;
+  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands) const = 0;
     // Compute for each unplayed card the expected number times the player will see the card.
     // This is the probability distribution P(player|card) multipled by Possibilities().
 
   virtual void AddStage(const CardDeck& other_remaining, PriorityList& list) = 0;
 
+  virtual unsigned AddToSampler(DealSampler& sampler) const = 0;
+    // Adds the stage for this analyzer to the sampler's table, after the stages it leads to.
+
   virtual void RenderDot(std::ostream& stream) const = 0;
 
   void RenderDotToFile(const std::string& path, const CardDeck& unknownCardsRemaining) const;
 
   std::string RenderDotToString() const;
+
+protected:
+  void SetExpectedCards(const PossibilityAnalyzer& next);
+    // Copies the expected cards of the next stage, for the stages that deal one suit and then defer to it.
+
+protected:
+  uint128_t mPossibilities;
+  double mExpectedCards[4][4];
 };
 
-PossibilityAnalyzer* BuildAnalyzer(unsigned player, const VoidBits& voidBits, PriorityList& priorityList
-                                  , const CardDeck& remaining, const CardHands& hands);
+template <typename T, typename... Args>
+std::shared_ptr<T> MakeAnalyzer(Args&&... args)
+{
+  // Analyzer nodes are allocated in the building thread's arena, so the nodes of a tree are close together in
+  // memory, and threads building trees at the same time don't contend in malloc.
+  return std::allocate_shared<T>(ArenaAllocator<T>(Arena::ThreadSpecific()), std::forward<Args>(args)...);
+}
+
+PossibilityAnalyzerPtr BuildAnalyzer(unsigned player, const VoidBits& voidBits, PriorityList& priorityList
+                                    , const CardDeck& remaining, const CardHands& hands);
+  // Analyzers depend only on the unknown cards, the available capacity of each hand, the voids and the priority
+  // list, and are immutable once built. BuildAnalyzer() memoizes them on those constraints in a process-wide
+  // cache, so a constraint set that comes up again, whether in another decision, another game, or as a stage
+  // of a larger tree, reuses the tree built the first time along with its counts.
+
+void ClearAnalyzerCache();
+
+size_t AnalyzerCacheSize();
 
 class Impossible : public PossibilityAnalyzer {
 public:
   Impossible();
   virtual ~Impossible();
 
-  virtual uint128_t Possibilities() const;
-
   virtual void ActualizePossibility(uint128_t possibility_index, CardHands& hands) const;
 
   virtual void AddStage(const CardDeck& other_remaining, PriorityList& list);
 
+  virtual unsigned AddToSampler(DealSampler& sampler) const;
+
   virtual void RenderDot(std::ostream& stream) const;
 
-  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands);
+  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands) const;
 };
 
 class NoneRemaining : public PossibilityAnalyzer {
@@ -55,13 +96,13 @@ public:
   NoneRemaining();
   virtual ~NoneRemaining();
 
-  virtual uint128_t Possibilities() const;
-
   virtual void ActualizePossibility(uint128_t possibility_index, CardHands& hands) const;
 
   virtual void AddStage(const CardDeck& other_remaining, PriorityList& list);
 
+  virtual unsigned AddToSampler(DealSampler& sampler) const;
+
   virtual void RenderDot(std::ostream& stream) const;
 
-  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands) {}
+  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands) const {}
 };
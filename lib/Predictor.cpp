@@ -2,23 +2,16 @@
 
 #include "lib/Predictor.h"
 #include "lib/KnowableState.h"
+#include "lib/timer.h"
 #include <dlib/logger.h>
-#include <unistd.h>
 
 using namespace std;
 using namespace dlib;
-using namespace tensorflow;
 
 static logger dlog("predictor");
 
 namespace {
-  vector<string> out_tensor_names(const vector<string>& output_tensor_names) {
-    if (output_tensor_names.size() == 0) {
-      return vector<string>({"expected_score/expected_score:0", "moon_prob/moon_prob:0"});
-    } else {
-      return output_tensor_names;
-    }
-  }
+  constexpr unsigned kNumFeatures = KnowableState::kNumFeatures;
 }
 
 // --- Predictor ---
@@ -31,179 +24,222 @@ Predictor::~Predictor()
 SynchronousPredictor::~SynchronousPredictor()
 {}
 
-SynchronousPredictor::SynchronousPredictor(const SavedModelBundle& model, const vector<string> output_tensor_names)
+SynchronousPredictor::SynchronousPredictor(const InferenceBackendPtr& backend)
 : Predictor()
-, mModel(model)
-, mOutTensorNames(out_tensor_names(output_tensor_names))
+, mBackend(backend)
 {
 }
 
-void SynchronousPredictor::Predict(const Tensor& mainData, vector<Tensor>& outputs) const
+void SynchronousPredictor::Predict(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const
 {
-  auto result = mModel.session->Run({{"main_data:0", mainData}}, mOutTensorNames, {}, &outputs);
-  if (!result.ok()) {
-    printf("Tensorflow prediction failed: %s\n", result.error_message().c_str());
-    exit(1);
-  }
+  mBackend->Run(mainData, numRows, expectedScore, moonProbs);
 }
 
 // --- PooledPredictor ---
 
-static void CopyToDestRow(Eigen::TensorMap<Eigen::Tensor<const float, 2, 1, long>, 16, Eigen::MakePointer> src
-                  ,Eigen::TensorMap<Eigen::Tensor<float, 2, 1, long>, 16, Eigen::MakePointer> dst
-                  ,int row)
-{
-  for (int i=0; i<KnowableState::kNumFeatures; ++i) {
-    dst(row, i) = src(0, i);
-  }
-}
-
-static void CopySrcRowToDest(const vector<Tensor>& src, vector<Tensor>& dst, int row) {
-  {
-    const unsigned kStride = 52;
-    const unsigned kOffset = kStride * row;
-    auto s = src[0].flat<float>();
-    auto d = dst[0].flat<float>();
-    for (unsigned i=0; i<kStride; ++i) {
-      d(i) = s(kOffset+i);
-    }
-  }
-  {
-    const unsigned kStride = 52 * 5;
-    const unsigned kOffset = kStride * row;
-    auto s = src[1].flat<float>();
-    auto d = dst[1].flat<float>();
-    for (unsigned i=0; i<kStride; ++i) {
-      d(i) = s(kOffset+i);
-    }
-  }
-}
-
 PooledPredictor::~PooledPredictor()
 {
-  printf("Deleting PooledPredictor\n");
   mRunning = false;
-  default_thread_pool().wait_for_task(mTaskId);
+  WakeBatchingThread();
+  mBatchingThread.join();
 }
 
-PooledPredictor::PooledPredictor(const SavedModelBundle& model, const vector<string> output_tensor_names)
-: mImplPredictor(new SynchronousPredictor(model, output_tensor_names))
-, mQueueMutex()
-, mQueue()
-, mRequestsPending()
+PooledPredictor::PooledPredictor(const InferenceBackendPtr& backend, unsigned maxBatchRows, unsigned maxWaitMicros)
+: mBackend(backend)
+, kMaxBatchRows(maxBatchRows)
+, kMaxWait(maxWaitMicros / 1000000.0)
+, mBatchInput(maxBatchRows * kNumFeatures)
+, mBatchExpectedScore(maxBatchRows * kScoresPerRow)
+, mBatchMoonProbs(maxBatchRows * kMoonProbsPerRow)
+, mSubmitted(nullptr)
+, mBatcherIdle(false)
+, mWakeupMutex()
+, mWakeup()
+, mWakeupPending(false)
+, mPending()
+, mPendingRows(0)
+, mNumRequests(0)
+, mNumBatches(0)
+, mNumRows(0)
+, mTotalQueueWaitMicros(0)
+, mMaxQueueWaitMicros(0)
 , mRunning(true)
-, mTaskId(default_thread_pool().add_task(*this, &PooledPredictor::ProcessRequests))
 {
-  assert(false);
+  assert(maxBatchRows > 0);
   dlog.set_level(LALL);
+  mSegments.reserve(maxBatchRows);
+  for (unsigned i = 0; i < kNumHistogramBuckets; ++i)
+    mBatchRowsHistogram[i] = 0;
+  mBatchingThread = std::thread(&PooledPredictor::BatchingLoop, this);
 }
 
-void PooledPredictor::ProcessOneBatch()
+void PooledPredictor::Predict(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const
 {
-  unsigned numRequests = mRequestsPending.WaitFor(4, 1);
-  if (numRequests == 0) {
-    return;
-  }
-
-  // dlog << LINFO << "Batch: " << numRequests;
-
-  auto_mutex locker(mQueueMutex);
-
-  assert(numRequests > 0);
-  assert(!mQueue.empty());
-
-  // There is a race here. Between the call to Drain() and acquiring the lock
-  // another request might have been enqueued.
-  // But we have acuqired the mutex now, so no more requests can be added
-  // until after we exit this function. So, it should be entirely safe to
-  // acquire the additional requests.
+  static thread_specific_data<Semaphore> doneSemaphore;
 
-  std::forward_list<PredictElement> queue; // an empty new queue
-  assert(queue.empty());
-  mQueue.swap(queue);
-  assert(mQueue.empty());
+  // An empty request would be an empty batch if it were the only one pending.
+  if (numRows == 0)
+    return;
 
-  // We now have all of the pending requests in our local forward_list `queue`.
-  unsigned pending = 0;
-  for (auto it = queue.begin(); it != queue.end(); ++it)
-    ++pending;
+  Request request;
+  request.mMainData = mainData;
+  request.mNumRows = numRows;
+  request.mExpectedScore = expectedScore;
+  request.mMoonProbs = moonProbs;
+  request.mSubmitTime = now();
+  request.mDone = &doneSemaphore.data();
+  request.mRowsStarted = 0;
+
+  Submit(&request);
+  request.mDone->Acquire();
+}
 
-  assert(pending >= numRequests);
+void PooledPredictor::Submit(Request* request) const
+{
+  request->mNext = mSubmitted.load(std::memory_order_relaxed);
+  while (!mSubmitted.compare_exchange_weak(request->mNext, request, std::memory_order_release, std::memory_order_relaxed))
+  {}
+  ++mNumRequests;
+
+  // Only pay for waking the batching thread when it is (about to be) blocked.
+  if (mBatcherIdle.exchange(false))
+    WakeBatchingThread();
+}
 
-  if (pending > numRequests) {
-    unsigned actual = mRequestsPending.TryDrain();
-    assert(pending-numRequests == actual);
-    numRequests += actual;
+void PooledPredictor::WakeBatchingThread() const
+{
+  {
+    std::lock_guard<std::mutex> lock(mWakeupMutex);
+    mWakeupPending = true;
   }
+  mWakeup.notify_one();
+}
 
-  // dlog << LINFO << "Queue requests: " << numRequests;
-
-  Tensor mainData(DT_FLOAT, TensorShape({numRequests, KnowableState::kNumFeatures}));
-  auto matrix = mainData.matrix<float>();
+void PooledPredictor::CollectSubmittedRequests()
+{
+  Request* stack = mSubmitted.exchange(nullptr, std::memory_order_acquire);
+  if (stack == nullptr)
+    return;
 
-  int row = 0;
-  for (auto it = queue.begin(); it != queue.end(); ++it, ++row) {
-    PredictElement elem = *it;
-    auto src = elem.mMainData.matrix<float>();
-    CopyToDestRow(src, matrix, row);
+  // The stack holds the most recent submission first.
+  const size_t end = mPending.size();
+  for (; stack != nullptr; stack = stack->mNext) {
+    mPending.insert(mPending.begin() + end, stack);
+    mPendingRows += stack->mNumRows;
   }
+}
 
-  std::vector<Tensor> outputs;
-  mImplPredictor->Predict(mainData, outputs);
-
-  // We have 2 heads for nows: expected_score and moon_prob
-  assert(outputs.size() == 2);
-  assert(outputs[0].dim_size(0) == numRequests);
-  assert(outputs[1].dim_size(0) == numRequests);
+void PooledPredictor::BatchingLoop()
+{
+  while (mRunning || !mPending.empty() || mSubmitted.load() != nullptr) {
+    CollectSubmittedRequests();
 
-  assert(outputs[0].dim_size(1) == kCardsPerDeck);
-  assert(outputs[1].dim_size(1) == kCardsPerDeck);
-  assert(outputs[1].dim_size(2) == 5);  // moon probs has 5 classes
+    if (mPending.empty()) {
+      WaitForRequests(0.1);
+      continue;
+    }
 
-  row = 0;
-  for (auto it = queue.begin(); it != queue.end(); ++it, ++row) {
-    PredictElement elem = *it;
+    // A partial batch waits, without spinning, until more requests arrive or its oldest request has waited kMaxWait.
+    const double waited = now() - mPending.front()->mSubmitTime;
+    if (mRunning && mPendingRows < kMaxBatchRows && waited < kMaxWait) {
+      WaitForRequests(kMaxWait - waited);
+      continue;
+    }
 
-    // We start with an empty vector
-    assert(elem.mOutput.size() == 0);
-    Tensor expected_score(DT_FLOAT, TensorShape({1, 52}));
-    Tensor moon_prob(DT_FLOAT, TensorShape({1, 52, 5}));
-    elem.mOutput.push_back(expected_score);
-    elem.mOutput.push_back(moon_prob);
+    RunOneBatch();
+  }
+}
 
-    CopySrcRowToDest(outputs, elem.mOutput, row);
-    elem.mSemaphore.Release();
+void PooledPredictor::WaitForRequests(double seconds)
+{
+  mBatcherIdle = true;
+  // Recheck after announcing that we are idle, so that a submission racing with us can't be missed.
+  if (mSubmitted.load() == nullptr && mRunning) {
+    std::unique_lock<std::mutex> lock(mWakeupMutex);
+    mWakeup.wait_for(lock, std::chrono::duration<double>(seconds), [this]() { return mWakeupPending; });
+    mWakeupPending = false;
   }
+  mBatcherIdle = false;
 }
 
-void PooledPredictor::ProcessRequests()
+void PooledPredictor::RunOneBatch()
 {
-  while (mRunning) {
-    ProcessOneBatch();
+  const double startTime = now();
+  float* input = mBatchInput.data();
+
+  mSegments.clear();
+  unsigned rows = 0;
+  for (auto it = mPending.begin(); it != mPending.end() && rows < kMaxBatchRows; ++it) {
+    Request* request = *it;
+    if (request->mRowsStarted == 0) {
+      const uint64_t waitMicros = uint64_t((startTime - request->mSubmitTime) * 1000000.0);
+      mTotalQueueWaitMicros += waitMicros;
+      if (waitMicros > mMaxQueueWaitMicros)
+        mMaxQueueWaitMicros = waitMicros;
+    }
+
+    const unsigned n = std::min(request->mNumRows - request->mRowsStarted, kMaxBatchRows - rows);
+    memcpy(input + rows * kNumFeatures, request->mMainData + request->mRowsStarted * kNumFeatures,
+           n * kNumFeatures * sizeof(float));
+    mSegments.push_back({request, request->mRowsStarted, n});
+    request->mRowsStarted += n;
+    rows += n;
+  }
+
+  assert(rows > 0);  // Predict() never submits an empty request.
+  mBackend->Run(input, rows, mBatchExpectedScore.data(), mBatchMoonProbs.data());
+
+  unsigned row = 0;
+  for (const Segment& segment : mSegments) {
+    Request* request = segment.mRequest;
+    memcpy(request->mExpectedScore + segment.mFirstRow * kScoresPerRow, &mBatchExpectedScore[row * kScoresPerRow],
+           segment.mNumRows * kScoresPerRow * sizeof(float));
+    memcpy(request->mMoonProbs + segment.mFirstRow * kMoonProbsPerRow, &mBatchMoonProbs[row * kMoonProbsPerRow],
+           segment.mNumRows * kMoonProbsPerRow * sizeof(float));
+    row += segment.mNumRows;
+
+    // Completed requests are always a prefix of mPending.
+    if (request->mRowsStarted == request->mNumRows) {
+      assert(mPending.front() == request);
+      mPending.pop_front();
+      request->mDone->Release();
+    }
   }
+  mPendingRows -= rows;
+
+  ++mNumBatches;
+  mNumRows += rows;
+  const unsigned bucket = std::min(unsigned(31 - __builtin_clz(rows)), kNumHistogramBuckets - 1);
+  ++mBatchRowsHistogram[bucket];
 }
 
-void PooledPredictor::Predict(const Tensor& mainData, vector<Tensor>& output) const
+PooledPredictor::Counters PooledPredictor::GetCounters() const
 {
-  static thread_specific_data<Semaphore> doneSemaphore;
-  assert(output.size() == 0);
-  EnqueueOneRequest(mainData, output, doneSemaphore.data());
-  doneSemaphore.data().Acquire();
-  assert(output.size() == 2);
-  assert(output[0].dim_size(0) == 1);
-  assert(output[1].dim_size(0) == 1);
-
-  assert(output[0].dim_size(1) == kCardsPerDeck);
-  assert(output[1].dim_size(1) == kCardsPerDeck);
-  assert(output[1].dim_size(2) == 5);  // moon probs has 5 classes
+  Counters counters;
+  counters.requests = mNumRequests;
+  counters.batches = mNumBatches;
+  counters.rows = mNumRows;
+  for (unsigned i = 0; i < kNumHistogramBuckets; ++i)
+    counters.batchRowsHistogram[i] = mBatchRowsHistogram[i];
+  counters.totalQueueWait = mTotalQueueWaitMicros / 1000000.0;
+  counters.maxQueueWait = mMaxQueueWaitMicros / 1000000.0;
+  return counters;
 }
 
-void PooledPredictor::EnqueueOneRequest(const tensorflow::Tensor& mainData
-                                      , std::vector<tensorflow::Tensor>& output
-                                      , Semaphore& sem) const
+void PooledPredictor::PrintCounters() const
 {
-  PredictElement elem(mainData, output, sem);
-  auto_mutex locker(mQueueMutex);
-  mQueue.push_front(elem);
-  mRequestsPending.Release();
+  const Counters counters = GetCounters();
+  if (counters.batches == 0)
+    return;
+
+  printf("PooledPredictor: %lu requests, %lu rows in %lu batches (%.1f rows/batch)\n", counters.requests,
+         counters.rows, counters.batches, double(counters.rows) / counters.batches);
+  printf("  queue wait avg %.1f us, max %.1f us\n", 1e6 * counters.totalQueueWait / counters.requests,
+         1e6 * counters.maxQueueWait);
+  printf("  batch rows:");
+  for (unsigned i = 0; i < kNumHistogramBuckets; ++i) {
+    if (counters.batchRowsHistogram[i] != 0)
+      printf(" [%u..%u]:%lu", 1u << i, (2u << i) - 1, counters.batchRowsHistogram[i]);
+  }
+  printf("\n");
 }
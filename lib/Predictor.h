@@ -2,22 +2,30 @@
 
 #pragma once
 
+#include "lib/InferenceBackend.h"
 #include "lib/Semaphore.h"
 
-#include <tensorflow/cc/saved_model/loader.h>
 #include "dlib/threads.h"
-#include <forward_list>
 
-namespace tensorflow {
-  struct SavedModelBundle;
-};
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 class Predictor
 {
 public:
   virtual ~Predictor();
   Predictor() {}
-  virtual void Predict(const tensorflow::Tensor& mainData, std::vector<tensorflow::Tensor>& outputs) const = 0;
+
+  virtual void Predict(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const = 0;
+    // mainData is numRows rows of KnowableState::kNumFeatures floats, as written by KnowableState::EncodeFeatures().
+    // Returns numRows*kScoresPerRow floats in expectedScore, and numRows*kMoonProbsPerRow floats in moonProbs.
+
+  virtual float* InputBuffer(unsigned numRows) const { return 0; }
+    // See InferenceBackend::InputBuffer(). Returns null when there is no buffer to encode into.
 };
 
 class SynchronousPredictor : public Predictor
@@ -25,13 +33,15 @@ class SynchronousPredictor : public Predictor
 public:
   virtual ~SynchronousPredictor();
 
-  SynchronousPredictor(const tensorflow::SavedModelBundle& model, const std::vector<std::string> output_tensor_names = {});
+  SynchronousPredictor(const InferenceBackendPtr& backend);
 
-  virtual void Predict(const tensorflow::Tensor& mainData, std::vector<tensorflow::Tensor>& outputs) const;
+  virtual void Predict(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const;
+    // Runs the backend directly on the calling thread.
+
+  virtual float* InputBuffer(unsigned numRows) const { return mBackend->InputBuffer(numRows); }
 
 protected:
-  const tensorflow::SavedModelBundle& mModel;
-  const std::vector<std::string> mOutTensorNames;
+  const InferenceBackendPtr mBackend;
 };
 
 class PooledPredictor : public Predictor
@@ -39,33 +49,96 @@ class PooledPredictor : public Predictor
 public:
   virtual ~PooledPredictor();
 
-  PooledPredictor(const tensorflow::SavedModelBundle& model, const std::vector<std::string> output_tensor_names = {});
+  PooledPredictor(const InferenceBackendPtr& backend, unsigned maxBatchRows = 1024, unsigned maxWaitMicros = 250);
+    // Requests from all threads are combined into batches of up to maxBatchRows rows.
+    // A partial batch is run once its oldest request has waited maxWaitMicros.
+
+  virtual void Predict(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const;
+    // Blocks until the batching thread has run the model for all numRows rows. Returns at once if numRows is zero.
+
+  static constexpr unsigned kNumHistogramBuckets = 12;
+
+  struct Counters
+  {
+    uint64_t requests;
+    uint64_t batches;
+    uint64_t rows;
+    uint64_t batchRowsHistogram[kNumHistogramBuckets];
+      // Bucket i counts batches with 2^i to 2^(i+1)-1 rows. The last bucket also counts all larger batches.
+    double totalQueueWait;
+    double maxQueueWait;
+      // Seconds from a request being submitted until the batch containing its first rows is started.
+  };
+
+  Counters GetCounters() const;
 
-  virtual void Predict(const tensorflow::Tensor& mainData, std::vector<tensorflow::Tensor>& outputs) const;
+  void PrintCounters() const;
+    // Prints the counters to stdout, if any batches have been run.
 
 private:
-  void EnqueueOneRequest(const tensorflow::Tensor& mainData, std::vector<tensorflow::Tensor>& output, Semaphore& sem) const;
+  struct Request
+  {
+    const float* mMainData;
+    unsigned mNumRows;
+    float* mExpectedScore;
+    float* mMoonProbs;
+    double mSubmitTime;
+    Semaphore* mDone;
+    Request* mNext;
+    unsigned mRowsStarted;
+      // Only accessed by the batching thread. A request larger than the max batch is split across batches.
+  };
 
-  void ProcessRequests();
-  void ProcessOneBatch();
+  void Submit(Request* request) const;
 
-  struct PredictElement {
-    PredictElement(const tensorflow::Tensor& mainData
-                 , std::vector<tensorflow::Tensor>& output
-                 , Semaphore& sem)
-    : mMainData(mainData), mOutput(output), mSemaphore(sem)
-    {}
+  void BatchingLoop();
+  void CollectSubmittedRequests();
+  void RunOneBatch();
 
-    const tensorflow::Tensor& mMainData;
-    std::vector<tensorflow::Tensor>& mOutput;
-    Semaphore& mSemaphore;
-  };
+  void WaitForRequests(double seconds);
+    // Blocks the batching thread for up to the given time, or until a request is submitted or the predictor is
+    // shutting down.
+
+  void WakeBatchingThread() const;
 
 private:
-  SynchronousPredictor* mImplPredictor;
-  mutable dlib::mutex mQueueMutex;
-  mutable std::forward_list<PredictElement> mQueue;
-  mutable Semaphore mRequestsPending;
-  volatile bool mRunning;
-  uint64_t mTaskId;
+  const InferenceBackendPtr mBackend;
+  const unsigned kMaxBatchRows;
+  const double kMaxWait;
+
+  // Preallocated buffers for the largest possible batch.
+  std::vector<float> mBatchInput;
+  std::vector<float> mBatchExpectedScore;
+  std::vector<float> mBatchMoonProbs;
+
+  // Requests are pushed onto a lock-free stack by the predicting threads. The batching thread
+  // takes the whole stack at once and appends it (in submission order) to mPending.
+  mutable std::atomic<Request*> mSubmitted;
+  mutable std::atomic<bool> mBatcherIdle;
+
+  // Wakes the batching thread from WaitForRequests(). A condition variable, unlike Semaphore, can time out in
+  // less than a millisecond.
+  mutable std::mutex mWakeupMutex;
+  mutable std::condition_variable mWakeup;
+  mutable bool mWakeupPending;
+  std::deque<Request*> mPending;
+  unsigned mPendingRows;
+
+  struct Segment
+  {
+    Request* mRequest;
+    unsigned mFirstRow;
+    unsigned mNumRows;
+  };
+  std::vector<Segment> mSegments;
+
+  mutable std::atomic<uint64_t> mNumRequests;
+  std::atomic<uint64_t> mNumBatches;
+  std::atomic<uint64_t> mNumRows;
+  std::atomic<uint64_t> mBatchRowsHistogram[kNumHistogramBuckets];
+  std::atomic<uint64_t> mTotalQueueWaitMicros;
+  std::atomic<uint64_t> mMaxQueueWaitMicros;
+
+  std::atomic<bool> mRunning;
+  std::thread mBatchingThread;
 };
@@ -0,0 +1,234 @@
+// lib/PythonModule.cpp
+
+// The python extension module heartsnn, which exposes the engine's batch operations (FeatureBatch.h and
+// GameBatch.h) to training input pipelines. Each function takes its inputs and outputs as buffers, such as
+// contiguous numpy arrays, so that a whole batch costs one call, and releases the GIL while the engine works, so
+// that other python threads keep running. python/engine.py wraps the module with numpy types.
+//
+// The buffers and the states in them are checked before the GIL is released, and anything malformed raises
+// ValueError: the engine only asserts its invariants, which would abort the interpreter (or give garbage with
+// NDEBUG).
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "lib/Deal.h"
+#include "lib/FeatureBatch.h"
+#include "lib/GameBatch.h"
+#include "lib/KnowableState.h"
+
+#include <stdint.h>
+
+namespace {
+
+// A Py_buffer that is released when it goes out of scope.
+class Buffer
+{
+public:
+  ~Buffer() { if (mView.obj) PyBuffer_Release(&mView); }
+  Buffer() { mView.obj = 0; }
+
+  Py_buffer* operator&() { return &mView; }
+
+  template <typename T>
+  bool CheckItems(const char* name, size_t& numItems);
+    // Sets numItems to the number of Ts in the buffer. Raises ValueError and returns false if the size of the
+    // buffer is not a multiple of sizeof(T), or the buffer is not aligned for T (as an offset view of bytes may
+    // not be).
+
+  template <typename T>
+  bool CheckSize(const char* name, size_t numItems);
+    // Raises ValueError and returns false if the buffer is not numItems Ts, or is not aligned for T.
+
+  void* Data() const { return mView.buf; }
+
+private:
+  Py_buffer mView;
+};
+
+bool CheckAligned(const char* name, const void* data, size_t alignment)
+{
+  if (uintptr_t(data) % alignment != 0) {
+    PyErr_Format(PyExc_ValueError, "%s must be aligned to %zu bytes", name, alignment);
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+bool Buffer::CheckItems(const char* name, size_t& numItems)
+{
+  if (size_t(mView.len) % sizeof(T) != 0) {
+    PyErr_Format(PyExc_ValueError, "%s must hold a whole number of %zu-byte items", name, sizeof(T));
+    return false;
+  }
+  numItems = size_t(mView.len) / sizeof(T);
+  return CheckAligned(name, mView.buf, alignof(T));
+}
+
+template <typename T>
+bool Buffer::CheckSize(const char* name, size_t numItems)
+{
+  if (size_t(mView.len) != numItems * sizeof(T)) {
+    PyErr_Format(PyExc_ValueError, "%s must be %zu bytes, not %zd", name, numItems * sizeof(T), mView.len);
+    return false;
+  }
+  return CheckAligned(name, mView.buf, alignof(T));
+}
+
+// Raises ValueError and returns false unless each of the states IsValid(), since the engine asserts the invariants
+// of its states rather than checking them.
+template <typename State>
+bool CheckStates(const char* name, const State* states, size_t numStates)
+{
+  for (size_t i = 0; i < numStates; ++i) {
+    if (!states[i].IsValid()) {
+      PyErr_Format(PyExc_ValueError, "%s[%zu] is not a valid state", name, i);
+      return false;
+    }
+  }
+  return true;
+}
+
+PyObject* EncodeFeatures(PyObject*, PyObject* args, PyObject* kwargs)
+{
+  static const char* kKeywords[] = {"states", "out", "exact_probabilities", 0};
+  Buffer states, out;
+  int exactProbabilities = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*w*|p", const_cast<char**>(kKeywords)
+                                 , &states, &out, &exactProbabilities))
+    return 0;
+  size_t numStates;
+  if (!states.CheckItems<PackedKnowableState>("states", numStates)
+   || !out.CheckSize<float>("out", numStates * KnowableState::kNumFeatures))
+    return 0;
+  const PackedKnowableState* packed = static_cast<const PackedKnowableState*>(states.Data());
+  if (!CheckStates("states", packed, numStates))
+    return 0;
+
+  Py_BEGIN_ALLOW_THREADS
+  EncodeFeatureBatch(packed, numStates, static_cast<float*>(out.Data()), exactProbabilities != 0);
+  Py_END_ALLOW_THREADS
+  Py_RETURN_NONE;
+}
+
+PyObject* DealFromIndexes(PyObject*, PyObject* args, PyObject* kwargs)
+{
+  static const char* kKeywords[] = {"deal_indexes", "out", 0};
+  Buffer indexes, out;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*w*", const_cast<char**>(kKeywords), &indexes, &out))
+    return 0;
+  size_t numIndexes;
+  if (!indexes.CheckItems<uint64_t>("deal_indexes", numIndexes))
+    return 0;
+  if (numIndexes % 2 != 0) {
+    PyErr_SetString(PyExc_ValueError, "deal_indexes must hold two uint64s per deal");
+    return 0;
+  }
+  const size_t numDeals = numIndexes / 2;
+  if (!out.CheckSize<PackedGameState>("out", numDeals))
+    return 0;
+  const uint64_t* halves = static_cast<const uint64_t*>(indexes.Data());
+  for (size_t i = 0; i < numDeals; ++i) {
+    if (((uint128_t(halves[2*i + 1]) << 64) | halves[2*i]) >= Deal::NumPossibleDeals()) {
+      PyErr_Format(PyExc_ValueError, "deal_indexes[%zu] is not less than the number of possible deals", i);
+      return 0;
+    }
+  }
+
+  Py_BEGIN_ALLOW_THREADS
+  DealBatch(halves, numDeals, static_cast<PackedGameState*>(out.Data()));
+  Py_END_ALLOW_THREADS
+  Py_RETURN_NONE;
+}
+
+PyObject* Rollouts(PyObject*, PyObject* args, PyObject* kwargs)
+{
+  static const char* kKeywords[] = {"states", "num_rollouts", "seed", "out", 0};
+  Buffer states, out;
+  unsigned numRollouts;
+  unsigned long long seed;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*IKw*", const_cast<char**>(kKeywords)
+                                 , &states, &numRollouts, &seed, &out))
+    return 0;
+  size_t numStates;
+  if (!states.CheckItems<PackedGameState>("states", numStates) || !out.CheckSize<float>("out", numStates * 4))
+    return 0;
+  const PackedGameState* packed = static_cast<const PackedGameState*>(states.Data());
+  if (!CheckStates("states", packed, numStates))
+    return 0;
+
+  Py_BEGIN_ALLOW_THREADS
+  RolloutBatch(packed, numStates, numRollouts, seed, static_cast<float*>(out.Data()));
+  Py_END_ALLOW_THREADS
+  Py_RETURN_NONE;
+}
+
+PyObject* SampleDeals(PyObject*, PyObject* args, PyObject* kwargs)
+{
+  static const char* kKeywords[] = {"states", "samples_per_state", "seed", "out", 0};
+  Buffer states, out;
+  unsigned samplesPerState;
+  unsigned long long seed;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*IKw*", const_cast<char**>(kKeywords)
+                                 , &states, &samplesPerState, &seed, &out))
+    return 0;
+  size_t numStates;
+  if (!states.CheckItems<PackedKnowableState>("states", numStates)
+   || !out.CheckSize<PackedGameState>("out", numStates * samplesPerState))
+    return 0;
+  const PackedKnowableState* packed = static_cast<const PackedKnowableState*>(states.Data());
+  if (!CheckStates("states", packed, numStates))
+    return 0;
+
+  Py_BEGIN_ALLOW_THREADS
+  SampleDealBatch(packed, numStates, samplesPerState, seed, static_cast<PackedGameState*>(out.Data()));
+  Py_END_ALLOW_THREADS
+  Py_RETURN_NONE;
+}
+
+PyMethodDef kMethods[] = {
+  {"encode_features", (PyCFunction) (void(*)(void)) EncodeFeatures, METH_VARARGS | METH_KEYWORDS,
+   "encode_features(states, out, exact_probabilities=False)\n"
+   "Writes the NUM_FEATURES float32 features of each packed knowable state to out."},
+  {"deal", (PyCFunction) (void(*)(void)) DealFromIndexes, METH_VARARGS | METH_KEYWORDS,
+   "deal(deal_indexes, out)\n"
+   "Writes the packed game state at the start of each deal to out. Each deal index is two uint64s, low half first."},
+  {"rollouts", (PyCFunction) (void(*)(void)) Rollouts, METH_VARARGS | METH_KEYWORDS,
+   "rollouts(states, num_rollouts, seed, out)\n"
+   "Plays each packed game state out randomly num_rollouts times, and writes the mean points taken by each\n"
+   "player to out, four float32s per state."},
+  {"sample_deals", (PyCFunction) (void(*)(void)) SampleDeals, METH_VARARGS | METH_KEYWORDS,
+   "sample_deals(states, samples_per_state, seed, out)\n"
+   "Writes samples_per_state packed game states for each packed knowable state to out, dealing the unknown cards\n"
+   "so that each possible deal is equally likely."},
+  {0, 0, 0, 0},
+};
+
+PyModuleDef kModule = {
+  PyModuleDef_HEAD_INIT,
+  "heartsnn",
+  "Batch operations of the HeartsNN engine, on buffers such as numpy arrays.",
+  -1,
+  kMethods,
+  0,
+  0,
+  0,
+  0,
+};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit_heartsnn(void)
+{
+  PyObject* module = PyModule_Create(&kModule);
+  if (!module)
+    return 0;
+  if (PyModule_AddIntConstant(module, "PACKED_GAME_STATE_BYTES", sizeof(PackedGameState)) != 0
+   || PyModule_AddIntConstant(module, "PACKED_KNOWABLE_STATE_BYTES", sizeof(PackedKnowableState)) != 0
+   || PyModule_AddIntConstant(module, "NUM_FEATURES", KnowableState::kNumFeatures) != 0) {
+    Py_DECREF(module);
+    return 0;
+  }
+  return module;
+}
@@ -14,4 +14,6 @@ public:
 
     virtual Card predictOutcomes(
         const KnowableState& state, const RandomGenerator& rng, float playExpectedValue[13]) const;
+
+    virtual bool playsUniformlyAtRandom() const { return true; }
 };
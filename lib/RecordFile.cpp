@@ -0,0 +1,225 @@
+// lib/RecordFile.cpp
+
+#include "lib/RecordFile.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <sstream>
+#include <stdexcept>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = {'\x93', 'H', 'R', 'E', 'C', '\x01', '\x00', '\x00'};
+
+struct FixedHeader
+{
+  char mMagic[8];
+  uint32_t mHeaderBytes;
+  uint32_t mStride;
+  uint64_t mNumRecords;
+  uint64_t mIndexOffset;
+};
+static_assert(sizeof(FixedHeader) == 32, "FixedHeader must match the file layout");
+
+const char* kTypeNames[] = {"<f4", "|u1"};
+const unsigned kTypeBytes[] = {4, 1};
+
+std::vector<unsigned> FieldOffsets(const RecordSchema& schema, unsigned& stride)
+{
+  std::vector<unsigned> offsets;
+  stride = 0;
+  for (const RecordField& field : schema) {
+    offsets.push_back(stride);
+    stride += field.NumBytes();
+  }
+  return offsets;
+}
+
+}  // namespace
+
+unsigned RecordField::NumBytes() const
+{
+  unsigned numBytes = kTypeBytes[mType];
+  for (int dim : mShape)
+    numBytes *= dim;
+  return numBytes;
+}
+
+std::string RecordFile::Descr(const RecordSchema& schema)
+{
+  std::ostringstream descr;
+  descr << "[";
+  for (unsigned i = 0; i < schema.size(); ++i) {
+    const RecordField& field = schema[i];
+    descr << (i ? ", " : "") << "('" << field.mName << "', '" << kTypeNames[field.mType] << "', (";
+    for (unsigned j = 0; j < field.mShape.size(); ++j)
+      descr << (j ? ", " : "") << field.mShape[j];
+    descr << (field.mShape.size() == 1 ? ",))" : "))");
+  }
+  descr << "]";
+  return descr.str();
+}
+
+RecordSchema RecordFile::ParseDescr(const std::string& descr)
+{
+  RecordSchema schema;
+  const char* p = descr.c_str();
+  auto expect = [&p](const char* text) {
+    const size_t len = strlen(text);
+    if (strncmp(p, text, len) != 0)
+      return false;
+    p += len;
+    return true;
+  };
+
+  if (!expect("["))
+    return RecordSchema();
+  while (!expect("]")) {
+    if (!schema.empty() && !expect(", "))
+      return RecordSchema();
+    if (!expect("('"))
+      return RecordSchema();
+    RecordField field;
+    while (*p && *p != '\'')
+      field.mName += *p++;
+    if (field.mName.empty() || !expect("', '"))
+      return RecordSchema();
+    if (expect(kTypeNames[kFloat32]))
+      field.mType = kFloat32;
+    else if (expect(kTypeNames[kUint8]))
+      field.mType = kUint8;
+    else
+      return RecordSchema();
+    if (!expect("', ("))
+      return RecordSchema();
+    while (!expect(")")) {
+      if (!field.mShape.empty() && !expect(", ") && !expect(","))
+        return RecordSchema();
+      if (*p == ')')
+        continue;
+      char* end;
+      const long dim = strtol(p, &end, 10);
+      if (end == p || dim <= 0)
+        return RecordSchema();
+      field.mShape.push_back(int(dim));
+      p = end;
+    }
+    if (field.mShape.empty() || !expect(")"))
+      return RecordSchema();
+    schema.push_back(field);
+  }
+  return *p == '\0' ? schema : RecordSchema();
+}
+
+RecordWriter::~RecordWriter()
+{
+  uint64_t indexOffset = 0;
+  if (mWithIndex) {
+    indexOffset = mFile.Size();
+    mFile.Append(mKeys.data(), mKeys.size() * sizeof(uint32_t));
+  }
+  mFile.WriteAt(0, Header(indexOffset));
+}
+
+RecordWriter::RecordWriter(const std::string& path, const RecordSchema& schema, bool withIndex)
+: mFile(path)
+, mSchema(schema)
+, mNumRecords(0)
+, mWithIndex(withIndex)
+{
+  mFieldOffsets = FieldOffsets(mSchema, mStride);
+  assert(!withIndex || mStride % sizeof(uint32_t) == 0);
+  // The header is rewritten with the number of records when the file is finished.
+  mFile.Append(Header(0).data(), RecordFile::kHeaderBytes);
+}
+
+std::string RecordWriter::Header(uint64_t indexOffset) const
+{
+  std::string header(RecordFile::kHeaderBytes, '\0');
+  FixedHeader fixed;
+  memcpy(fixed.mMagic, kMagic, sizeof(kMagic));
+  fixed.mHeaderBytes = RecordFile::kHeaderBytes;
+  fixed.mStride = mStride;
+  fixed.mNumRecords = mNumRecords;
+  fixed.mIndexOffset = indexOffset;
+  memcpy(&header[0], &fixed, sizeof(fixed));
+
+  const std::string descr = RecordFile::Descr(mSchema);
+  assert(sizeof(fixed) + descr.size() < RecordFile::kHeaderBytes);
+  memcpy(&header[sizeof(fixed)], descr.data(), descr.size());
+  return header;
+}
+
+char* RecordWriter::Append(uint32_t key)
+{
+  ++mNumRecords;
+  if (mWithIndex)
+    mKeys.push_back(key);
+  return mFile.Reserve(mStride);
+}
+
+RecordReader::~RecordReader()
+{
+  ::munmap(const_cast<char*>(mData), mSize);
+}
+
+RecordReader::RecordReader(const std::string& path)
+: mData(0)
+, mSize(0)
+, mIndex(0)
+{
+  const int file = ::open(path.c_str(), O_RDONLY);
+  if (file == -1)
+    throw std::runtime_error("Error opening record file " + path);
+  struct stat info;
+  if (::fstat(file, &info) != 0 || size_t(info.st_size) < RecordFile::kHeaderBytes) {
+    ::close(file);
+    throw std::runtime_error("Not a record file: " + path);
+  }
+  mSize = info.st_size;
+  void* data = ::mmap(0, mSize, PROT_READ, MAP_SHARED, file, 0);
+  ::close(file);
+  if (data == MAP_FAILED)
+    throw std::runtime_error("Error mapping record file " + path);
+  mData = static_cast<const char*>(data);
+
+  FixedHeader fixed;
+  memcpy(&fixed, mData, sizeof(fixed));
+  mHeaderBytes = fixed.mHeaderBytes;
+  mStride = fixed.mStride;
+  mNumRecords = fixed.mNumRecords;
+
+  const std::string descr(mData + sizeof(fixed), strnlen(mData + sizeof(fixed), RecordFile::kHeaderBytes - sizeof(fixed)));
+  mSchema = RecordFile::ParseDescr(descr);
+  unsigned stride;
+  mFieldOffsets = FieldOffsets(mSchema, stride);
+
+  const uint64_t dataEnd = mHeaderBytes + mNumRecords * mStride;
+  const bool valid = memcmp(fixed.mMagic, kMagic, sizeof(kMagic)) == 0
+                  && mHeaderBytes >= RecordFile::kHeaderBytes
+                  && !mSchema.empty() && stride == mStride
+                  && dataEnd <= mSize
+                  && (fixed.mIndexOffset == 0
+                      || (fixed.mIndexOffset >= dataEnd && fixed.mIndexOffset % sizeof(uint32_t) == 0
+                          && fixed.mIndexOffset + mNumRecords*sizeof(uint32_t) <= mSize));
+  if (!valid) {
+    ::munmap(data, mSize);
+    throw std::runtime_error("Not a record file: " + path);
+  }
+  if (fixed.mIndexOffset != 0)
+    mIndex = reinterpret_cast<const uint32_t*>(mData + fixed.mIndexOffset);
+}
+
+int RecordReader::FieldIndex(const std::string& name) const
+{
+  for (unsigned i = 0; i < mSchema.size(); ++i) {
+    if (mSchema[i].mName == name)
+      return i;
+  }
+  return -1;
+}
@@ -0,0 +1,130 @@
+// lib/RecordFile.h
+
+#pragma once
+
+#include "lib/BlockWriter.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// A record file (.hrec) stores fixed-stride records, each of which holds all of the fields of one sample
+// contiguously, so that a sample is written with one append and read with one contiguous fetch.
+//
+// The file is a kHeaderBytes header, then the records, then an optional index of one uint32 key per record:
+//   bytes 0-7    magic "\x93HREC\x01\x00\x00"
+//   bytes 8-11   uint32 header bytes (kHeaderBytes), the offset of the first record
+//   bytes 12-15  uint32 stride, the bytes of one record
+//   bytes 16-23  uint64 number of records
+//   bytes 24-31  uint64 offset of the index, or 0 if there is none
+//   bytes 32-    the schema as a numpy structured dtype descr, padded with NULs, such as
+//                [('main', '<f4', (52, 10)), ('score', '<f4', (52,))]
+// The fields are single precision floats or bytes, and the integers are little-endian. The header is a multiple of
+// eight bytes, so when the stride is also a multiple of eight, every record starts at a multiple of eight bytes. A
+// field that Field<T>() accesses must then be at an offset that is a multiple of alignof(T) (four bytes for floats,
+// eight for structs of uint64s), which Field<T>() asserts. The index follows the last record, so it is only aligned
+// for its uint32s when the stride is a multiple of four, which RecordWriter asserts for a file with an index.
+// In python, numpy.memmap(path, dtype=numpy.dtype(descr), offset=headerBytes, shape=(numRecords,)) is a view
+// of the records (see python/hrec.py).
+
+enum RecordType { kFloat32, kUint8 };
+
+struct RecordField
+{
+  std::string mName;
+  std::vector<int> mShape;
+  RecordType mType = kFloat32;
+
+  unsigned NumBytes() const;
+};
+
+typedef std::vector<RecordField> RecordSchema;
+
+namespace RecordFile {
+  const unsigned kHeaderBytes = 512;
+
+  std::string Descr(const RecordSchema& schema);
+  RecordSchema ParseDescr(const std::string& descr);
+    // Returns an empty schema if descr is not one written by Descr().
+}
+
+class RecordWriter
+{
+public:
+  ~RecordWriter();
+    // Appends the index, if any, and updates the header for the number of records, then closes the file.
+    // As with BlockWriter, the file is complete once IoThread::Shared().Wait() returns.
+
+  RecordWriter(const std::string& path, const RecordSchema& schema, bool withIndex = false);
+    // Throws std::system_error if the file can't be created. With an index, the stride must be a multiple of four.
+
+  char* Append(uint32_t key = 0);
+    // Appends a record of zeros and returns it, to be filled in place until the next call.
+    // The key is stored in the index, if the file has one.
+
+  template <typename T>
+  T* Field(char* record, unsigned field) const
+  {
+    char* p = record + mFieldOffsets[field];
+    assert(uintptr_t(p) % alignof(T) == 0);
+    return reinterpret_cast<T*>(p);
+  }
+
+  unsigned Stride() const { return mStride; }
+  uint64_t NumRecords() const { return mNumRecords; }
+
+private:
+  std::string Header(uint64_t indexOffset) const;
+
+private:
+  BlockWriter mFile;
+  const RecordSchema mSchema;
+  std::vector<unsigned> mFieldOffsets;
+  unsigned mStride;
+  uint64_t mNumRecords;
+  const bool mWithIndex;
+  std::vector<uint32_t> mKeys;
+};
+
+class RecordReader
+{
+public:
+  ~RecordReader();
+
+  RecordReader(const std::string& path);
+    // Maps the file. Throws std::runtime_error if it can't, or if the file is not a complete record file.
+
+  uint64_t NumRecords() const { return mNumRecords; }
+  unsigned Stride() const { return mStride; }
+  const RecordSchema& Schema() const { return mSchema; }
+
+  int FieldIndex(const std::string& name) const;
+    // The index in Schema() of the field, or -1.
+
+  const char* Record(uint64_t i) const { return mData + mHeaderBytes + i*mStride; }
+
+  template <typename T>
+  const T* Field(uint64_t i, unsigned field) const
+  {
+    const char* p = Record(i) + mFieldOffsets[field];
+    assert(uintptr_t(p) % alignof(T) == 0);
+    return reinterpret_cast<const T*>(p);
+  }
+
+  bool HasIndex() const { return mIndex != 0; }
+  uint32_t Key(uint64_t i) const { return mIndex[i]; }
+
+  RecordReader(const RecordReader&) = delete;
+  RecordReader& operator=(const RecordReader&) = delete;
+
+private:
+  const char* mData;
+  size_t mSize;
+  unsigned mHeaderBytes;
+  unsigned mStride;
+  uint64_t mNumRecords;
+  const uint32_t* mIndex;
+  RecordSchema mSchema;
+  std::vector<unsigned> mFieldOffsets;
+};
@@ -0,0 +1,34 @@
+// lib/SplitMix64.h
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// splitmix64 (see https://prng.di.unimi.it/splitmix64.c), which turns any seed, even zero, into a well mixed
+// sequence. It seeds the faster generators, such as RandomGenerator and the lanes of MultiRollout, and makes the
+// Zobrist hash keys of the solvers.
+
+inline uint64_t SplitMix64(uint64_t& state)
+  // Advances state and returns the next number of its sequence.
+{
+  uint64_t z = (state += 0x9e3779b97f4a7c15ul);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ul;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebul;
+  return z ^ (z >> 31);
+}
+
+template <size_t N>
+void FillRandomKeys(uint64_t (&keys)[N], uint64_t& state)
+  // Fills a table of Zobrist keys (one random key for each value of one part of a position) from state.
+{
+  for (uint64_t& key : keys)
+    key = SplitMix64(state);
+}
+
+template <size_t M, size_t N>
+void FillRandomKeys(uint64_t (&keys)[M][N], uint64_t& state)
+{
+  for (auto& row : keys)
+    FillRandomKeys(row, state);
+}
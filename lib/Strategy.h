@@ -5,6 +5,7 @@
 #include "lib/CardArray.h"
 
 #include <memory>
+#include <vector>
 
 class KnowableState;
 class Strategy;
@@ -22,11 +23,40 @@ public:
     virtual Card predictOutcomes(
         const KnowableState& state, const RandomGenerator& rng, float playExpectedValue[13]) const = 0;
 
+    virtual void choosePlays(const std::vector<KnowableState>& states, const RandomGenerator& rng, Card* plays) const;
+    // Choose one play for each of a batch of states, returning the choices in plays[0..states.size()).
+    // The default implementation simply calls choosePlay() once per state.
+
+    virtual bool prefersBatches() const { return false; }
+    // True if this strategy has a large fixed cost per call (e.g. running a DNN model), so that callers
+    // should gather many states and use choosePlays() instead of choosePlay().
+
+    virtual bool playsUniformlyAtRandom() const { return false; }
+    // True if choosePlay() just picks one of the legal plays uniformly at random. MonteCarlo then plays its
+    // rollouts with FastRollout, without calling this strategy at all.
+
+    virtual void printCounters() const {}
+    // Prints whatever this strategy counts about its work to stdout, for apps to report when they are done.
+    // The default prints nothing.
+
     AnnotatorPtr getAnnotator() const { return mAnnotator; }
 
 private:
     const AnnotatorPtr mAnnotator;
 };
 
-StrategyPtr makePlayer(const std::string& intuitionName, int rollouts);
+StrategyPtr loadIntuition(const std::string& intuitionNameOrPath, bool pooled = false);
+// Returns the "random" intuition, or loads the DNN model at the given path.
+// Use pooled for a model that will be called from many threads concurrently.
+
+StrategyPtr makePlayer(const std::string& intuitionName, int rollouts, unsigned threadBudget = 0,
+    bool earlyStopping = false, bool commonRandomNumbers = false, unsigned endgameTricks = 0);
 StrategyPtr makePlayer(const std::string& arg);
+// arg is an intuition, optionally followed by #rollouts for a MonteCarlo player, and then by options.
+// The options are threads=N, the most threads a MonteCarlo player may use, adaptive, to make the rollouts
+// the most a MonteCarlo player may play (see MonteCarlo::EnableEarlyStopping()), and crn, to use common random
+// numbers (see MonteCarlo::EnableCommonRandomNumbers()), and endgame=N, to solve the last N tricks of each rollout
+// exactly (see MonteCarlo::EnableEndgameSolver()). E.g. "random#1000:threads=8:adaptive:endgame=3".
+// The intuition endgame-dds is the EndgameDoubleDummy player, with #rollouts the number of deals it samples, e.g.
+// "endgame-dds#20:threads=4". It takes only the threads option, and exits with an error for the others. It plays
+// randomly until EndgameDoubleDummy::kMaxSolvedTricks tricks remain, so it is only meant for the endgame.
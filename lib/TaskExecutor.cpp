@@ -0,0 +1,135 @@
+// lib/TaskExecutor.cpp
+
+#include "lib/TaskExecutor.h"
+
+#include <algorithm>
+#include <assert.h>
+
+using namespace dlib;
+
+struct TaskExecutor::Loop
+{
+  Loop(const TaskFunction& task, unsigned numTasks)
+  : mTask(task)
+  , mNumTasks(numTasks)
+  , mNextTask(0)
+  , mNumFinished(0)
+  {}
+
+  const TaskFunction& mTask;
+    // Only called while tasks remain, so the caller of ParallelFor() still owns it. Stale shares can outlive
+    // the loop's ParallelFor() call, which is why the Loop itself is reference counted.
+  const unsigned mNumTasks;
+  std::atomic<unsigned> mNextTask;
+  std::atomic<unsigned> mNumFinished;
+  Semaphore mDone;
+};
+
+TaskExecutor::~TaskExecutor()
+{
+  mRunning = false;
+  mSharesAvailable.Release(NumThreads());
+  for (auto& worker : mWorkers)
+    worker->mThread.join();
+}
+
+TaskExecutor::TaskExecutor(unsigned numThreads)
+: mWorkers()
+, mSharesAvailable(0)
+, mNextWorker(0)
+, mRunning(true)
+{
+  assert(numThreads > 0);
+  for (unsigned i = 0; i < numThreads; ++i)
+    mWorkers.emplace_back(new Worker);
+  for (unsigned i = 0; i < numThreads; ++i)
+    mWorkers[i]->mThread = std::thread(&TaskExecutor::WorkerLoop, this, i);
+}
+
+TaskExecutor& TaskExecutor::Shared()
+{
+  static TaskExecutor executor(std::max(1u, (3 * std::thread::hardware_concurrency()) / 4));
+  return executor;
+}
+
+void TaskExecutor::ParallelFor(unsigned numTasks, unsigned numSlots, const TaskFunction& task)
+{
+  if (numTasks == 0)
+    return;
+
+  // The calling thread takes slot 0. Each share admits one more thread, but never more than there are tasks.
+  numSlots = std::min(std::max(numSlots, 1u), MaxSlots());
+  const unsigned numShares = std::min(numSlots, numTasks) - 1;
+  if (numShares == 0)
+  {
+    for (unsigned i = 0; i < numTasks; ++i)
+      task(i, 0);
+    return;
+  }
+
+  LoopPtr loop(new Loop(task, numTasks));
+  for (unsigned slot = 1; slot <= numShares; ++slot)
+  {
+    Worker& worker = *mWorkers[mNextWorker++ % NumThreads()];
+    auto_mutex locker(worker.mMutex);
+    worker.mShares.push_back(Share{loop, slot});
+  }
+  mSharesAvailable.Release(numShares);
+
+  RunTasks(*loop, 0);
+  loop->mDone.Acquire();
+}
+
+void TaskExecutor::RunTasks(Loop& loop, unsigned slot)
+{
+  unsigned numFinished = 0;
+  for (unsigned i = loop.mNextTask++; i < loop.mNumTasks; i = loop.mNextTask++)
+  {
+    loop.mTask(i, slot);
+    ++numFinished;
+  }
+
+  // Whichever thread finishes the last task wakes the caller.
+  if (numFinished > 0 && loop.mNumFinished.fetch_add(numFinished) + numFinished == loop.mNumTasks)
+    loop.mDone.Release();
+}
+
+void TaskExecutor::WorkerLoop(unsigned index)
+{
+  while (true)
+  {
+    mSharesAvailable.Acquire();
+    if (!mRunning)
+      return;
+    Share share = TakeShare(index);
+    RunTasks(*share.mLoop, share.mSlot);
+  }
+}
+
+TaskExecutor::Share TaskExecutor::TakeShare(unsigned index)
+{
+  // Having acquired mSharesAvailable, there is a share for this worker in one of the queues, though another
+  // worker may take the one we look at first.
+  while (true)
+  {
+    for (unsigned i = 0; i < NumThreads(); ++i)
+    {
+      Worker& worker = *mWorkers[(index + i) % NumThreads()];
+      auto_mutex locker(worker.mMutex);
+      if (worker.mShares.empty())
+        continue;
+      Share share;
+      if (i == 0)
+      {
+        share = worker.mShares.back();
+        worker.mShares.pop_back();
+      }
+      else
+      {
+        share = worker.mShares.front();
+        worker.mShares.pop_front();
+      }
+      return share;
+    }
+  }
+}
@@ -0,0 +1,80 @@
+// lib/TaskExecutor.h
+
+#pragma once
+
+#include "lib/Semaphore.h"
+
+#include "dlib/threads.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// TaskExecutor runs the tasks of parallel loops on a fixed set of worker threads.
+//
+// A loop is offered to the workers as a number of shares, each share admitting one more thread to the loop.
+// The shares are spread across the per-worker queues. A worker takes shares from the back of its own queue,
+// and when that is empty steals from the front of the other queues, so a share queued behind a busy worker
+// is picked up by whichever worker is idle first. A thread that joins a loop claims its tasks one at a time
+// until none are left, so many small tasks keep all of the threads busy until the end of the loop.
+class TaskExecutor
+{
+public:
+  typedef std::function<void(unsigned task, unsigned slot)> TaskFunction;
+
+  ~TaskExecutor();
+
+  TaskExecutor(unsigned numThreads);
+
+  static TaskExecutor& Shared();
+    // The process-wide executor, with threads for 3/4 of the hardware threads, created on first use.
+    // All of the MonteCarlo players in a process share it, so that they do not oversubscribe the machine.
+
+  unsigned NumThreads() const { return unsigned(mWorkers.size()); }
+
+  unsigned MaxSlots() const { return NumThreads() + 1; }
+    // The most threads that can work on one loop: all of the workers and the calling thread.
+
+  void ParallelFor(unsigned numTasks, unsigned numSlots, const TaskFunction& task);
+    // Calls task(i, slot) once for each i in [0, numTasks), and returns when all of the calls have finished.
+    // At most numSlots threads work on the loop, including the calling thread, which runs tasks rather than
+    // just waiting. Each of the threads has its own slot in [0, numSlots), so the tasks can accumulate
+    // results per slot without locking, and combine them after ParallelFor() returns.
+    // ParallelFor() may be called from within a task.
+
+private:
+  struct Loop;
+  typedef std::shared_ptr<Loop> LoopPtr;
+
+  struct Share
+  {
+    LoopPtr mLoop;
+    unsigned mSlot;
+  };
+
+  struct Worker
+  {
+    dlib::mutex mMutex;
+    std::deque<Share> mShares;
+    std::thread mThread;
+  };
+
+  static void RunTasks(Loop& loop, unsigned slot);
+
+  void WorkerLoop(unsigned index);
+
+  Share TakeShare(unsigned index);
+    // Pops a share from the worker's own queue, or steals one from another worker.
+
+private:
+  std::vector<std::unique_ptr<Worker>> mWorkers;
+
+  Semaphore mSharesAvailable;
+    // The number of shares in the queues not yet claimed by a worker.
+
+  std::atomic<unsigned> mNextWorker;
+  std::atomic<bool> mRunning;
+};
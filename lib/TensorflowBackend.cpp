@@ -0,0 +1,75 @@
+// lib/TensorflowBackend.cpp
+
+#include "lib/TensorflowBackend.h"
+#include "lib/KnowableState.h"
+
+#include <tensorflow/cc/saved_model/tag_constants.h>
+
+using namespace std;
+using namespace tensorflow;
+
+namespace {
+  vector<string> out_tensor_names(const vector<string>& output_tensor_names) {
+    if (output_tensor_names.size() == 0) {
+      return vector<string>({"expected_score/expected_score:0", "moon_prob/moon_prob:0"});
+    } else {
+      return output_tensor_names;
+    }
+  }
+}
+
+TensorflowBackend::~TensorflowBackend()
+{}
+
+TensorflowBackend::TensorflowBackend(const string& savedModelPath, const vector<string>& outputTensorNames)
+: mOutTensorNames(out_tensor_names(outputTensorNames))
+{
+  SessionOptions session_options;
+  RunOptions run_options;
+  auto status = LoadSavedModel(session_options, run_options, savedModelPath, {kSavedModelTagServe}, &mModel);
+  if (!status.ok())
+  {
+    std::cerr << "Failed: " << status;
+    exit(1);
+  }
+}
+
+float* TensorflowBackend::InputBuffer(unsigned numRows) const
+{
+  InputTensor& buffer = mInputTensors.data();
+  if (buffer.mCapacity < numRows) {
+    buffer.mCapacity = std::max(numRows, 2 * buffer.mCapacity);
+    buffer.mTensor = Tensor(DT_FLOAT, TensorShape({buffer.mCapacity, kCardsPerDeck, KnowableState::kNumFeaturesPerCard}));
+  }
+  return buffer.mTensor.flat<float>().data();
+}
+
+void TensorflowBackend::Run(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const
+{
+  assert(numRows > 0);
+
+  // The caller may have encoded its input directly into our buffer.
+  float* data = InputBuffer(numRows);
+  if (mainData != data)
+    memcpy(data, mainData, numRows * KnowableState::kNumFeatures * sizeof(float));
+
+  InputTensor& buffer = mInputTensors.data();
+
+  // Slicing along the first dimension shares the buffer, so this does not copy the input.
+  const Tensor input = numRows == buffer.mCapacity ? buffer.mTensor : buffer.mTensor.Slice(0, numRows);
+
+  std::vector<Tensor> outputs;
+  auto result = mModel.session->Run({{"main_data:0", input}}, mOutTensorNames, {}, &outputs);
+  if (!result.ok()) {
+    printf("Tensorflow prediction failed: %s\n", result.error_message().c_str());
+    exit(1);
+  }
+
+  // We have 2 heads for now: expected_score and moon_prob
+  assert(outputs.size() == 2);
+  assert(outputs[0].NumElements() == numRows * kScoresPerRow);
+  assert(outputs[1].NumElements() == numRows * kMoonProbsPerRow);
+
+  memcpy(expectedScore, outputs[0].flat<float>().data(), numRows * kScoresPerRow * sizeof(float));
+  memcpy(moonProbs, outputs[1].flat<float>().data(), numRows * kMoonProbsPerRow * sizeof(float));
+}
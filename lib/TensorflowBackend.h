@@ -0,0 +1,36 @@
+// lib/TensorflowBackend.h
+
+#pragma once
+
+#include "lib/InferenceBackend.h"
+
+#include "dlib/threads.h"
+
+#include <tensorflow/cc/saved_model/loader.h>
+
+#include <vector>
+
+class TensorflowBackend : public InferenceBackend
+{
+public:
+  virtual ~TensorflowBackend();
+
+  TensorflowBackend(const std::string& savedModelPath, const std::vector<std::string>& outputTensorNames = {});
+
+  virtual void Run(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const;
+
+  virtual float* InputBuffer(unsigned numRows) const;
+    // The thread's input tensor, so that Run() can skip copying mainData.
+
+private:
+  struct InputTensor
+  {
+    tensorflow::Tensor mTensor;
+    unsigned mCapacity = 0;
+  };
+
+  tensorflow::SavedModelBundle mModel;
+  const std::vector<std::string> mOutTensorNames;
+  mutable dlib::thread_specific_data<InputTensor> mInputTensors;
+    // Each calling thread reuses its own input tensor, which only grows.
+};
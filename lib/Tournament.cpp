@@ -2,24 +2,44 @@
 
 #include "lib/Tournament.h"
 #include "lib/GameState.h"
+#include "lib/TaskExecutor.h"
+
+#include <assert.h>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 typedef StrategyPtr Player;
 typedef StrategyPtr Table[4];
 
-Tournament::Tournament(StrategyPtr champion, StrategyPtr opponent, bool quiet, bool saveMoonDeals)
+Tournament::Tournament(StrategyPtr champion, StrategyPtr opponent, bool quiet, bool saveMoonDeals, unsigned numThreads)
     : mChampion(champion)
     , mOpponent(opponent)
     , mQuiet(quiet)
     , mSaveMoonDeals(saveMoonDeals)
-{}
+    , mNumThreads(numThreads)
+{
+    const Table seatings[kGamesPerMatch] = {
+        {mChampion, mChampion, mOpponent, mOpponent},
+        {mChampion, mOpponent, mChampion, mOpponent},
+        {mChampion, mOpponent, mOpponent, mChampion},
+        {mOpponent, mOpponent, mChampion, mChampion},
+        {mOpponent, mChampion, mOpponent, mChampion},
+        {mOpponent, mChampion, mChampion, mOpponent},
+    };
+    for (unsigned i = 0; i < kGamesPerMatch; ++i)
+        std::copy(seatings[i], seatings[i] + 4, mSeatings[i]);
+}
 
-void Tournament::runOneGame(uint128_t dealIndex, StrategyPtr players[4], Scores& scores, bool& moon)
+GameOutcome Tournament::playOneGame(uint128_t dealIndex, StrategyPtr players[4], const RandomGenerator& rng)
 {
     Deal deck(dealIndex);
     GameState state(deck);
-    GameOutcome outcome = state.PlayGame(players, mRng);
-    moon = outcome.shotTheMoon();
+    return state.PlayGame(players, rng);
+}
 
+void Tournament::reportGame(StrategyPtr players[4], const GameOutcome& outcome, Scores& scores)
+{
     const char* name[2] = {"c", "o"};
 
     scores.Accumulate(players, outcome);
@@ -32,29 +52,23 @@ void Tournament::runOneGame(uint128_t dealIndex, StrategyPtr players[4], Scores&
             int playerIndex = player == mChampion ? 0 : 1;
             printf("%s=%5.1f ", name[playerIndex], outcome.ZeroMeanStandardScore(i));
         }
-        if (moon)
+        if (outcome.shotTheMoon())
             printf("  Shot the moon!\n");
         else
             printf("\n");
     }
 }
 
-void Tournament::runOneMatch(const uint128_t dealIndex, float playerScores[2])
+void Tournament::runOneGame(uint128_t dealIndex, StrategyPtr players[4], Scores& scores, bool& moon)
 {
+    GameOutcome outcome = playOneGame(dealIndex, players, RandomGenerator::ThreadSpecific());
+    moon = outcome.shotTheMoon();
+    reportGame(players, outcome, scores);
+}
 
-    // A match is six games with the same deal of cards to the four positions (N, E, S, W)
-    // The two player strategies each occupy two of the table positions.
-    // There are six unique arrangements of the two player strategies.
+void Tournament::reportMatch(uint128_t dealIndex, const GameOutcome outcomes[kGamesPerMatch], float playerScores[2])
+{
     // We'll rollup all of the game scores into one score for each strategy.
-    Table match[6] = {
-        {mChampion, mChampion, mOpponent, mOpponent},
-        {mChampion, mOpponent, mChampion, mOpponent},
-        {mChampion, mOpponent, mOpponent, mChampion},
-        {mOpponent, mOpponent, mChampion, mChampion},
-        {mOpponent, mChampion, mOpponent, mChampion},
-        {mOpponent, mChampion, mChampion, mOpponent},
-    };
-
     Scores matchScores(mChampion);
 
     int shotMoon = 0;
@@ -67,11 +81,10 @@ void Tournament::runOneMatch(const uint128_t dealIndex, float playerScores[2])
         deck.printDeal();
     }
 
-    for (int i = 0; i < 6; ++i)
+    for (unsigned i = 0; i < kGamesPerMatch; ++i)
     {
-        bool moon;
-        runOneGame(dealIndex, match[i], matchScores, moon);
-        if (moon)
+        reportGame(mSeatings[i], outcomes[i], matchScores);
+        if (outcomes[i].shotTheMoon())
             ++shotMoon;
     }
 
@@ -92,14 +105,45 @@ void Tournament::runOneMatch(const uint128_t dealIndex, float playerScores[2])
     }
 }
 
+void Tournament::runOneMatch(const uint128_t dealIndex, float playerScores[2])
+{
+    GameOutcome outcomes[kGamesPerMatch];
+    for (unsigned i = 0; i < kGamesPerMatch; ++i)
+        outcomes[i] = playOneGame(dealIndex, mSeatings[i], RandomGenerator::ThreadSpecific());
+    reportMatch(dealIndex, outcomes, playerScores);
+}
+
 float Tournament::runOneTournament(int numMatches, uint128_t* deals)
 {
     float playerScores[2] = {0};
 
-    for (int i = 0; i < numMatches; ++i)
-    {
-        runOneMatch(deals[i], playerScores);
-    }
+    const unsigned kNumGames = numMatches * kGamesPerMatch;
+    std::unique_ptr<GameOutcome[]> outcomes(new GameOutcome[kNumGames]);
+    std::vector<std::atomic<unsigned>> gamesDone(numMatches);
+    for (auto& done : gamesDone)
+        done = 0;
+
+    dlib::mutex reportMutex;
+    int nextToReport = 0;
+
+    // The executor claims tasks in order, so the games of the early matches are played first.
+    // With one thread, this plays and reports the matches one after another on the calling thread.
+    TaskExecutor::Shared().ParallelFor(kNumGames, mNumThreads, [&](unsigned game, unsigned) {
+        const unsigned match = game / kGamesPerMatch;
+        const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+        outcomes[game] = playOneGame(deals[match], mSeatings[game % kGamesPerMatch], rng);
+        if (++gamesDone[match] < kGamesPerMatch)
+            return;
+
+        // Whichever thread completes the next match to report reports it, and any completed matches after it.
+        dlib::auto_mutex locker(reportMutex);
+        while (nextToReport < numMatches && gamesDone[nextToReport] == kGamesPerMatch)
+        {
+            reportMatch(deals[nextToReport], &outcomes[nextToReport * kGamesPerMatch], playerScores);
+            ++nextToReport;
+        }
+    });
+    assert(nextToReport == numMatches);
 
     if (!mQuiet)
     {
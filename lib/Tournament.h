@@ -11,20 +11,39 @@ struct Scores;
 class Tournament
 {
 public:
-    Tournament(StrategyPtr champion, StrategyPtr opponent, bool quiet = false, bool saveMoonDeals = false);
+    Tournament(StrategyPtr champion, StrategyPtr opponent, bool quiet = false, bool saveMoonDeals = false,
+        unsigned numThreads = 1);
+    // Up to numThreads games of a tournament are played at once, on the shared TaskExecutor.
+    // The strategies must allow choosePlay() to be called from several threads when numThreads > 1.
 
     float runOneTournament(int numMatches = 1, uint128_t* gDeals = nullptr);
+    // Every game of every match is an independent task. The results are still printed, summed and saved to
+    // moonhands.txt one match at a time in the order of the deals, so the output does not depend on numThreads.
 
     void runOneMatch(const uint128_t dealIndex, float playerScores[2]);
 
     void runOneGame(uint128_t dealIndex, StrategyPtr players[4], Scores& scores, bool& moon);
 
+    static constexpr unsigned kGamesPerMatch = 6;
+
+private:
+    GameOutcome playOneGame(uint128_t dealIndex, StrategyPtr players[4], const RandomGenerator& rng);
+
+    void reportGame(StrategyPtr players[4], const GameOutcome& outcome, Scores& scores);
+
+    void reportMatch(uint128_t dealIndex, const GameOutcome outcomes[kGamesPerMatch], float playerScores[2]);
+
 private:
     StrategyPtr mChampion;
     StrategyPtr mOpponent;
     bool mQuiet;
     bool mSaveMoonDeals;
-    RandomGenerator mRng;
+    unsigned mNumThreads;
+
+    StrategyPtr mSeatings[kGamesPerMatch][4];
+    // A match is six games with the same deal of cards to the four positions (N, E, S, W)
+    // The two player strategies each occupy two of the table positions.
+    // There are six unique arrangements of the two player strategies.
 };
 
 // This Scores struct is useful for analyzing the results of one match.
@@ -1,5 +1,6 @@
 #include "lib/TwoOpponentsGetSuit.h"
 #include "lib/combinatorics.h"
+#include "lib/DealSampler.h"
 #include "lib/Deal.h"
 
 TwoOpponents TwoOpponentsToGetCards(unsigned player, const VoidBits& voidBits, Suit suit)
@@ -25,41 +26,31 @@ TwoOpponentsGetSuit::TwoOpponentsGetSuit(unsigned player, const VoidBits& voidBi
 , mRemainingOfSuit(remainingOfSuit)
 , mOtherRemaining(otherRemaining)
 , mOpponents(TwoOpponentsToGetCards(player, voidBits, suit))
+, mWays(WayAllocator(Arena::ThreadSpecific()))
 {
   const unsigned remaining = remainingOfSuit.Size();
+  mWays.reserve(remaining + 1);
   for (unsigned i=0; i<=remaining; ++i) {
-    PossibilityAnalyzer* ways = 0;
+    std::shared_ptr<PossibilityAnalyzer> ways;
     if (hands[mOpponents.p[0]].AvailableCapacity() < i)
-      ways = new Impossible();
+      ways = MakeAnalyzer<Impossible>();
     else if (hands[mOpponents.p[1]].AvailableCapacity() < remaining-i)
-      ways = new Impossible();
+      ways = MakeAnalyzer<Impossible>();
     else
-      ways = new Ways(mPlayer, mVoidBits, suit, mRemainingOfSuit, mOtherRemaining, hands, mOpponents, i);
+      ways = MakeAnalyzer<Ways>(mPlayer, mVoidBits, suit, mRemainingOfSuit, mOtherRemaining, hands, mOpponents, i);
     mWays.push_back(ways);
   }
 }
 
 TwoOpponentsGetSuit::~TwoOpponentsGetSuit()
 {
-  for (auto it = mWays.begin(); it!=mWays.end(); ++it) {
-    PossibilityAnalyzer* way = (*it);
-    delete way;
-  }
-}
-
-uint128_t TwoOpponentsGetSuit::Possibilities() const
-{
-  uint128_t possibilities = 0;
-  for (auto it = mWays.begin(); it!=mWays.end(); ++it)
-    possibilities += (*it)->Possibilities();
-  return possibilities;
 }
 
 void TwoOpponentsGetSuit::ActualizePossibility(uint128_t possibility_index, CardHands& hands) const
 {
   mVoidBits.VerifyVoids(hands);
   for (auto it=mWays.begin(); it!=mWays.end(); ++it) {
-    PossibilityAnalyzer* way = (*it);
+    const PossibilityAnalyzer* way = it->get();
     const uint128_t wayPossibles = way->Possibilities();
     if (possibility_index < wayPossibles) {
       way->ActualizePossibility(possibility_index, hands);
@@ -73,10 +64,30 @@ void TwoOpponentsGetSuit::ActualizePossibility(uint128_t possibility_index, Card
 void TwoOpponentsGetSuit::AddStage(const CardDeck& other_remaining, PriorityList& list)
 {
   const unsigned remaining = mRemainingOfSuit.Size();
+  mPossibilities = 0;
   for (unsigned i=0; i<=remaining; ++i) {
     PriorityList prioList(list);
     mWays[i]->AddStage(other_remaining, prioList);
+    mPossibilities += mWays[i]->Possibilities();
   }
+
+  // The expectation over all of the ways is the average of the ways, weighted by their possibilities.
+  for (const auto& way : mWays) {
+    if (way->Possibilities() == 0)
+      continue;
+    const double weight = double(way->Possibilities()) / double(mPossibilities);
+    for (Suit suit=0; suit<4; ++suit)
+      for (unsigned p=0; p<4; ++p)
+        mExpectedCards[suit][p] += weight * way->ExpectedCards(suit, p);
+  }
+}
+
+unsigned TwoOpponentsGetSuit::AddToSampler(DealSampler& sampler) const
+{
+  std::vector<const PossibilityAnalyzer*> ways;
+  for (const auto& way : mWays)
+    ways.push_back(way.get());
+  return sampler.AddChooseWay(ways);
 }
 
 void TwoOpponentsGetSuit::RenderDot(std::ostream& stream) const
@@ -85,12 +96,12 @@ void TwoOpponentsGetSuit::RenderDot(std::ostream& stream) const
   const unsigned remaining = mRemainingOfSuit.Size();
   for (unsigned i=0; i<=remaining; ++i)
   {
-    stream << "id_" << uint64_t(this) << " -> id_" << uint64_t(mWays[i]) << ";" << std::endl;
+    stream << "id_" << uint64_t(this) << " -> id_" << uint64_t(mWays[i].get()) << ";" << std::endl;
     mWays[i]->RenderDot(stream);
   }
 }
 
-void TwoOpponentsGetSuit::ExpectedDistribution(Distribution& distribution, CardHands& hands)
+void TwoOpponentsGetSuit::ExpectedDistribution(Distribution& distribution, CardHands& hands) const
 {
   assert(hands.TotalCapacity() == mRemainingOfSuit.Size() + mOtherRemaining.Size());
 
@@ -98,7 +109,7 @@ void TwoOpponentsGetSuit::ExpectedDistribution(Distribution& distribution, CardH
   // distribution.Print();
 
   for (auto it=mWays.begin(); it!=mWays.end(); ++it) {
-    PossibilityAnalyzer* way = (*it);
+    const PossibilityAnalyzer* way = it->get();
     if (way->Possibilities() > 0) {
       Distribution nextDist;
       CardHands nextHands(hands);
@@ -122,7 +133,7 @@ Ways::Ways(unsigned player, const VoidBits& voidBits, Suit suit, const CardDeck&
 , A(opponents.p[0])
 , B(opponents.p[1])
 , mNumFirstPlayer(numFirstPlayer)
-, mNextStage(0)
+, mNextStage()
 , mHands(hands)
 {
   assert(A != B);
@@ -134,14 +145,6 @@ Ways::Ways(unsigned player, const VoidBits& voidBits, Suit suit, const CardDeck&
 
 Ways::~Ways()
 {
-  delete mNextStage;
-}
-
-uint128_t Ways::Possibilities() const
-{
-  const uint128_t arrangements = combinations128(mRemainingOfSuit.Size(), mNumFirstPlayer);
-  const uint128_t nextPossibles = mNextStage->Possibilities();
-  return arrangements * nextPossibles;
 }
 
 void Ways::ActualizePossibility(uint128_t possibilityIndex, CardHands& hands) const
@@ -190,22 +193,32 @@ void Ways::AddStage(const CardDeck& other_remaining, PriorityList& prioList)
       hand.Insert(it.next());
     } else {
       assert(hand.AvailableCapacity() == 0);
-      mNextStage = new Impossible();
+      mNextStage = MakeAnalyzer<Impossible>();
+      mPossibilities = 0;
       return;
     }
   }
 
   mNextStage = BuildAnalyzer(mPlayer, mVoidBits, prioList, other_remaining, hands);
+  mPossibilities = combinations128(mRemainingOfSuit.Size(), mNumFirstPlayer) * mNextStage->Possibilities();
+  SetExpectedCards(*mNextStage);
+  mExpectedCards[mSuit][A] += mNumFirstPlayer;
+  mExpectedCards[mSuit][B] += mRemainingOfSuit.Size() - mNumFirstPlayer;
+}
+
+unsigned Ways::AddToSampler(DealSampler& sampler) const
+{
+  return sampler.AddSplitSuit(A, B, mRemainingOfSuit, mNumFirstPlayer, *mNextStage);
 }
 
 void Ways::RenderDot(std::ostream& stream) const
 {
   stream << "id_" << uint64_t(this) << " [label=\"Ways suit(" << NameOfSuit(mSuit) << ") count(" << int(mRemainingOfSuit.Size())  <<  ")\"];" << std::endl;
-  stream << "id_" << uint64_t(this) << " -> id_" << uint64_t(mNextStage) << std::endl;
+  stream << "id_" << uint64_t(this) << " -> id_" << uint64_t(mNextStage.get()) << std::endl;
   mNextStage->RenderDot(stream);
 }
 
-void Ways::ExpectedDistribution(Distribution& distribution, CardHands& hands)
+void Ways::ExpectedDistribution(Distribution& distribution, CardHands& hands) const
 {
   assert(hands.TotalCapacity() == mRemainingOfSuit.Size() + mOtherRemaining.Size());
 
@@ -14,15 +14,15 @@ public:
                     , const CardDeck& otherRemaining, const CardHands& hands);
   virtual ~TwoOpponentsGetSuit();
 
-  virtual uint128_t Possibilities() const;
-
   virtual void ActualizePossibility(uint128_t possibility_index, CardHands& hands) const;
 
   virtual void AddStage(const CardDeck& other_remaining, PriorityList& list);
 
+  virtual unsigned AddToSampler(DealSampler& sampler) const;
+
   virtual void RenderDot(std::ostream& stream) const;
 
-  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands);
+  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands) const;
 
 private:
   const unsigned mPlayer;
@@ -32,7 +32,8 @@ private:
   const CardDeck mOtherRemaining;
   const TwoOpponents mOpponents;
 
-  std::vector<PossibilityAnalyzer*>  mWays;
+  typedef ArenaAllocator<std::shared_ptr<PossibilityAnalyzer>> WayAllocator;
+  std::vector<std::shared_ptr<PossibilityAnalyzer>, WayAllocator> mWays;
 };
 
 class Ways: public PossibilityAnalyzer
@@ -43,15 +44,15 @@ public:
 
   virtual ~Ways();
 
-  virtual uint128_t Possibilities() const;
-
   virtual void ActualizePossibility(uint128_t possibility_index, CardHands& hands) const;
 
   virtual void AddStage(const CardDeck& other_remaining, PriorityList& list);
 
+  virtual unsigned AddToSampler(DealSampler& sampler) const;
+
   virtual void RenderDot(std::ostream& stream) const;
 
-  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands);
+  virtual void ExpectedDistribution(Distribution& distribution, CardHands& hands) const;
 
 private:
   const unsigned mPlayer;
@@ -62,6 +63,6 @@ private:
   const unsigned A; // the first opponent who still may have suit
   const unsigned B; // the second opponent who still may have suit
   const unsigned mNumFirstPlayer;
-  PossibilityAnalyzer* mNextStage;
+  PossibilityAnalyzerPtr mNextStage;
   CardHands mHands;
 };
@@ -29,6 +29,8 @@ public:
 
   void operator=(const VoidBits& other) { mBits = other.mBits; }
 
+  uint16_t Bits() const { return mBits; }
+
   VoidBits ForOthers(int currentPlayer) const { return VoidBits(OthersKnownVoid(currentPlayer)); }
 
   PriorityList MakePriorityList(int currentPlayer, const CardDeck& unknownCardsRemaining) const;
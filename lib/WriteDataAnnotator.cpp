@@ -48,7 +48,7 @@ WriteDataAnnotator::WriteDataAnnotator(bool validateMode)
 }
 
 void WriteDataAnnotator::On_DnnMonteCarlo_choosePlay(const KnowableState& state
-                                  , PossibilityAnalyzer* analyzer
+                                  , const PossibilityAnalyzer* analyzer
                                   , const float expectedScore[13], const float moonProb[13][3])
 {
 }
@@ -72,7 +72,7 @@ std::string FixedPointToString(int x)
   }
 }
 
-void WriteDataAnnotator::OnWriteData(const KnowableState& state, PossibilityAnalyzer* analyzer, const float expectedScore[13]
+void WriteDataAnnotator::OnWriteData(const KnowableState& state, const PossibilityAnalyzer* analyzer, const float expectedScore[13]
                           , const float moonProb[13][3], const float winsTrickProb[13])
 {
   FILE* out = mFiles[state.PlayNumber()];
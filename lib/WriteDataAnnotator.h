@@ -9,12 +9,12 @@ public:
   ~WriteDataAnnotator();
   WriteDataAnnotator(bool validateMode=false);
 
-  virtual void On_DnnMonteCarlo_choosePlay(const KnowableState& state, PossibilityAnalyzer* analyzer
+  virtual void On_DnnMonteCarlo_choosePlay(const KnowableState& state, const PossibilityAnalyzer* analyzer
                                  , const float expectedScore[13], const float moonProb[13][3]);
 
   virtual void OnGameStateBeforePlay(const GameState& state);
 
-  virtual void OnWriteData(const KnowableState& state, PossibilityAnalyzer* analyzer, const float expectedScore[13]
+  virtual void OnWriteData(const KnowableState& state, const PossibilityAnalyzer* analyzer, const float expectedScore[13]
   , const float moonProb[13][3], const float winsTrickProb[13]);
 
 private:
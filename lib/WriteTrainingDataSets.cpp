@@ -2,30 +2,79 @@
 
 #include "lib/WriteTrainingDataSets.h"
 #include "lib/GameState.h"
+#include "lib/IoThread.h"
 #include "lib/KnowableState.h"
 #include "lib/PossibilityAnalyzer.h"
 #include "lib/random.h"
 
+#include <algorithm>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
 #include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
 
 WriteTrainingDataSets::~WriteTrainingDataSets()
 {
+  if (mWriter)
+    FinishShard();
+  const int manifest = mManifest;
+  IoThread::Shared().Post([manifest]() { ::close(manifest); });
 }
 
-const std::string dataDirPath("data/");
+WriteTrainingDataSets::WriteTrainingDataSets(const std::string& dirPath, size_t maxShardBytes, Layout layout)
+: mDirPath(dirPath)
+, mHash(asHexString(RandomGenerator::Random128()))
+, mLayout(layout)
+, kMaxShardRows(std::max(size_t(1), maxShardBytes / BytesPerRow(layout)))
+, mNumShards(0)
+, mManifest(::open((dirPath+mHash+"-manifest.txt").c_str(), O_CREAT|O_WRONLY|O_TRUNC|O_APPEND, 0644))
+{
+  if (mManifest == -1) {
+    throw std::system_error(std::error_code(), "Error opening manifest file for write access" );
+  }
+}
 
-WriteTrainingDataSets::WriteTrainingDataSets()
-: mHash(asHexString(RandomGenerator::Random128()))
-, mMainDataWriter(dataDirPath+mHash+"-main.npy", std::vector<int>({52, 10}))
-, mExpectedScoreWriter(dataDirPath+mHash+"-score.npy", std::vector<int>({52}))
-, mMoonProbWriter(dataDirPath+mHash+"-moon.npy", std::vector<int>({52, 3}))
-, mWinTrickProbWriter(dataDirPath+mHash+"-trick.npy", std::vector<int>({52}))
+void WriteTrainingDataSets::StartShard()
 {
+  char shard[16];
+  snprintf(shard, sizeof(shard), "-%04u", mNumShards);
+  // The state comes first, so that its uint64s are aligned: the records start at multiples of 8 bytes.
+  const RecordSchema schema = {
+    {"state", {sizeof(PackedKnowableState)}, kUint8},
+    mLayout == kStateOnly ? RecordField{"pad", {kStateOnlyPadBytes}, kUint8}
+                          : RecordField{"features", {sizeof(CompactFeatures)}, kUint8},
+    {"score", {kCardsPerHand}},
+    {"moon", {kCardsPerHand, 3}},
+    {"trick", {kCardsPerHand}},
+  };
+  mWriter.reset(new RecordWriter(mDirPath + mHash + shard + ".hrec", schema, true));
+  assert(mWriter->Stride() == BytesPerRow(mLayout));
+}
+
+void WriteTrainingDataSets::FinishShard()
+{
+  char line[64];
+  snprintf(line, sizeof(line), "%s-%04u %u\n", mHash.c_str(), mNumShards, unsigned(mWriter->NumRecords()));
+  ++mNumShards;
+  mWriter.reset();
+
+  // Listed after the writer has posted the last writes of the shard, so that every shard listed is complete.
+  const int manifest = mManifest;
+  const std::string entry(line);
+  IoThread::Shared().Post([manifest, entry]() {
+    if (::write(manifest, entry.data(), entry.size()) != ssize_t(entry.size())) {
+      fprintf(stderr, "Failed to write manifest: %s\n", strerror(errno));
+      exit(1);
+    }
+  });
 }
 
 void WriteTrainingDataSets::On_DnnMonteCarlo_choosePlay(const KnowableState& state
-                                  , PossibilityAnalyzer* analyzer
+                                  , const PossibilityAnalyzer* analyzer
                                   , const float expectedScore[13], const float moonProb[13][3])
 {
 }
@@ -34,35 +83,27 @@ void WriteTrainingDataSets::OnGameStateBeforePlay(const GameState& state)
 {
 }
 
-void WriteTrainingDataSets::OnWriteData(const KnowableState& state, PossibilityAnalyzer* analyzer, const float expectedScore[13]
+void WriteTrainingDataSets::OnWriteData(const KnowableState& state, const PossibilityAnalyzer* analyzer, const float expectedScore[13]
                           , const float moonProb[13][3], const float winsTrickProb[13])
 {
-  FloatMatrix mainData = state.AsFloatMatrix();
-  mMainDataWriter.Append(mainData);
-
-  const CardHand choices = state.LegalPlays();
-
-  FloatVector scoreData(kCardsPerDeck);
-  scoreData.setZero();
-  FloatVector trickData(kCardsPerDeck);
-  trickData.setZero();
-  FloatMatrix moonData(kCardsPerDeck, 3);
-  moonData.setZero();
+  if (!mWriter)
+    StartShard();
 
-  CardHand::iterator it(choices);
-  int i = 0;
-  while (!it.done()) {
-    Card card = it.next();
-    scoreData(card) = expectedScore[i];
-    trickData(card) = winsTrickProb[i];
-
-    for (int j=0; j<3; ++j) {
-      moonData(card, j) = moonProb[i][j];
-    }
-    ++i;
+  // The whole sample is filled in place in one record, which starts out as zeros.
+  char* record = mWriter->Append(state.PlayNumber());
+  *mWriter->Field<PackedKnowableState>(record, kStateField) = PackedKnowableState(state);
+  if (mLayout == kWithFeatures) {
+    float mainData[KnowableState::kNumFeatures];
+    state.EncodeFeatures(mainData);
+    *mWriter->Field<CompactFeatures>(record, kFeaturesField) = CompactFeatures(mainData);
   }
 
-  mExpectedScoreWriter.Append(scoreData);
-  mMoonProbWriter.Append(moonData);
-  mWinTrickProbWriter.Append(trickData);
+  // The outputs are only kept for the legal plays, in card order. The rest of the record stays zero.
+  const unsigned numChoices = state.LegalPlays().Size();
+  memcpy(mWriter->Field<float>(record, kScoreField), expectedScore, numChoices * sizeof(float));
+  memcpy(mWriter->Field<float>(record, kMoonField), moonProb, numChoices * 3 * sizeof(float));
+  memcpy(mWriter->Field<float>(record, kTrickField), winsTrickProb, numChoices * sizeof(float));
+
+  if (mWriter->NumRecords() == kMaxShardRows)
+    FinishShard();
 }
@@ -2,25 +2,81 @@
 #pragma once
 
 #include "lib/Annotator.h"
-#include "lib/NumpyWriter.h"
+#include "lib/CompactFeatures.h"
+#include "lib/PackedKnowableState.h"
+#include "lib/RecordFile.h"
 
+#include <memory>
+
+// WriteTrainingDataSets writes the training data in shards, each a record file (see RecordFile.h) named
+// <hash>-<shard>.hrec, where hash is a random 128-bit hex string chosen for each writer. A record holds one sample:
+// the PackedKnowableState it was computed from, its features as CompactFeatures, and the score, moon and trick
+// outputs of each legal play, in card order (as passed to OnWriteData()). The index of the file holds the play number
+// of each sample.
+//
+// The state lets the features be computed again when their definition changes, without generating the data again.
+// The features are kept beside it by default, since reading them back needs only numpy, while computing them from
+// the state needs the engine (python/featurize.py). With kStateOnly the features are left out, and a record is
+// 296 bytes instead of 448.
+// A shard is finished once it holds maxShardBytes of data, and it is then listed in <hash>-manifest.txt, one line
+// per shard of the name prefix (<hash>-<shard>) and the number of rows.
+//
+// The files are written by the IoThread, so a writer should only be used by one thread. Each thread generating
+// data has a writer of its own, and none of them wait for the others or for the file system.
 class WriteTrainingDataSets : public Annotator {
 public:
   ~WriteTrainingDataSets();
-  WriteTrainingDataSets();
+  enum Layout { kWithFeatures, kStateOnly };
+
+  WriteTrainingDataSets(const std::string& dirPath = "data/", size_t maxShardBytes = kDefaultMaxShardBytes
+                      , Layout layout = kWithFeatures);
+    // dirPath must end with a slash.
 
-  virtual void On_DnnMonteCarlo_choosePlay(const KnowableState& state, PossibilityAnalyzer* analyzer
+  virtual void On_DnnMonteCarlo_choosePlay(const KnowableState& state, const PossibilityAnalyzer* analyzer
                                  , const float expectedScore[13], const float moonProb[13][3]);
 
   virtual void OnGameStateBeforePlay(const GameState& state);
 
-  virtual void OnWriteData(const KnowableState& state, PossibilityAnalyzer* analyzer, const float expectedScore[13]
+  virtual void OnWriteData(const KnowableState& state, const PossibilityAnalyzer* analyzer, const float expectedScore[13]
   , const float moonProb[13][3], const float winsTrickProb[13]);
 
+  static constexpr size_t kDefaultMaxShardBytes = size_t(256) << 20;
+
+  static constexpr size_t kBytesPerRow = sizeof(PackedKnowableState) + sizeof(CompactFeatures)
+                                      + sizeof(float) * (13 + 13*3 + 13);
+    // The bytes of one record: 448, where the full 52x10 main input and 52 outputs of each kind would be 3120.
+  static_assert(kBytesPerRow % alignof(PackedKnowableState) == 0, "Each record's state should be aligned");
+
+  static constexpr size_t kStateOnlyPadBytes = 4;
+  static constexpr size_t kStateOnlyBytesPerRow = sizeof(PackedKnowableState) + kStateOnlyPadBytes
+                                               + sizeof(float) * (13 + 13*3 + 13);
+    // The bytes of one kStateOnly record: 296. The padding keeps the stride a multiple of 8, so that each state is
+    // aligned.
+  static_assert(kStateOnlyBytesPerRow % alignof(PackedKnowableState) == 0, "Each record's state should be aligned");
+
+  static constexpr size_t BytesPerRow(Layout layout)
+  {
+    return layout == kStateOnly ? kStateOnlyBytesPerRow : kBytesPerRow;
+  }
+
 private:
+  enum Field { kStateField, kFeaturesField, kScoreField, kMoonField, kTrickField };
+    // The fields of a record, in the order of the schema. With kStateOnly, kFeaturesField is the padding.
+
+  void StartShard();
+
+  void FinishShard();
+    // Finishes the file of the current shard and adds it to the manifest.
+
+private:
+  const std::string mDirPath;
   const std::string mHash;
-  NumpyWriter<2> mMainDataWriter;
-  NumpyWriter<1> mExpectedScoreWriter;
-  NumpyWriter<2> mMoonProbWriter;
-  NumpyWriter<1> mWinTrickProbWriter;
+  const Layout mLayout;
+  const unsigned kMaxShardRows;
+  unsigned mNumShards;
+  int mManifest;
+    // The file descriptor of the manifest, written by the IoThread.
+
+  std::unique_ptr<RecordWriter> mWriter;
+    // The writer of the current shard, or null between shards.
 };
@@ -1,11 +1,47 @@
 #pragma once
 
+#include <stdint.h>
 #include <string>
 #include "lib/math.h"
 
-uint128_t combinations128(unsigned n, unsigned k);
-  // Returns n things taken k at a time.
-  // No attempt is made to detect overflow, but 128 bits is big enough for Hearts.
+// Binomial coefficients for up to a deck of cards, computed at compile time. Every count of ways to deal
+// cards in Hearts is a product of these, so none of them need to be computed at run time.
 
-uint128_t possibleDistinguishableDeals();
+const unsigned kMaxCombinationsN = 52;
+
+struct BinomialTable64
+{
+  constexpr BinomialTable64() : mTable() {
+    for (unsigned n=0; n<=kMaxCombinationsN; ++n) {
+      mTable[n][0] = 1;
+      for (unsigned k=1; k<=n; ++k)
+        mTable[n][k] = mTable[n-1][k-1] + mTable[n-1][k];
+    }
+  }
+
+  uint64_t mTable[kMaxCombinationsN+1][kMaxCombinationsN+1];
+    // mTable[n][k] is n things taken k at a time, and 0 when k > n. The largest, C(52, 26), needs 49 bits.
+};
+
+inline constexpr BinomialTable64 kBinomialTable64;
+
+constexpr uint64_t combinations64(unsigned n, unsigned k) { return kBinomialTable64.mTable[n][k]; }
+  // Returns n things taken k at a time, for n <= kMaxCombinationsN, from a table computed at compile time.
+
+constexpr uint128_t combinations128(unsigned n, unsigned k) { return combinations64(n, k); }
+  // Returns n things taken k at a time, for n <= kMaxCombinationsN, widened for use in 128-bit products.
+  // Every binomial coefficient in the table fits in 64 bits, so there is no separate 128-bit table.
+
+constexpr uint128_t multinomial128(unsigned a, unsigned b, unsigned c, unsigned d)
+{
+  // The number of ways to deal a+b+c+d distinguishable cards into four hands that take a, b, c and d cards.
+  return combinations128(a+b+c+d, a) * combinations64(b+c+d, b) * combinations64(c+d, c);
+}
+
+inline uint128_t multinomial128(const unsigned capacities[4])
+{
+  return multinomial128(capacities[0], capacities[1], capacities[2], capacities[3]);
+}
+
+constexpr uint128_t possibleDistinguishableDeals() { return multinomial128(13, 13, 13, 13); }
   // Returns 52! / 13!^4
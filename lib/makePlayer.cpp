@@ -0,0 +1,150 @@
+// lib/makePlayer.cpp
+// loadIntuition() and makePlayer() are kept apart from Strategy.cpp because they need the inference library.
+
+#include "lib/Strategy.h"
+#include "lib/DnnModelIntuition.h"
+#include "lib/EndgameDoubleDummy.h"
+#include "lib/EndgameSolver.h"
+#include "lib/MonteCarlo.h"
+#include "lib/RandomStrategy.h"
+
+#include <algorithm>
+#include <sstream>
+
+StrategyPtr loadIntuition(const std::string& intuitionNameOrPath, bool pooled)
+{
+    if (intuitionNameOrPath == "random")
+    {
+        StrategyPtr intuition(new RandomStrategy());
+        return intuition;
+    }
+    else
+    {
+        StrategyPtr intuition(new DnnModelIntuition(intuitionNameOrPath, pooled));
+        return intuition;
+    }
+}
+
+std::vector<std::string> split(const std::string& s, char delimiter = ' ')
+{
+    std::vector<std::string> tokens;
+    std::string token;
+    std::istringstream tokenStream(s);
+    while (std::getline(tokenStream, token, delimiter))
+    {
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+StrategyPtr makePlayer(const std::string& intuitionName, int rollouts, unsigned threadBudget, bool earlyStopping,
+    bool commonRandomNumbers, unsigned endgameTricks)
+{
+    // endgame-dds is a player of its own rather than an intuition, with rollouts the number of deals it solves (at
+    // least 1). The options of MonteCarlo rollouts don't apply to it.
+    if (intuitionName == "endgame-dds")
+    {
+        if (earlyStopping || commonRandomNumbers || endgameTricks > 0)
+        {
+            fprintf(stderr, "The endgame-dds player only takes the threads option\n");
+            exit(1);
+        }
+        StrategyPtr doubleDummy(new EndgameDoubleDummy(std::max(rollouts, 1), threadBudget));
+        return doubleDummy;
+    }
+
+    // The parallel MonteCarlo calls its intuition from many threads at once, so let their predictions be batched.
+    const bool kPooled = rollouts != 0;
+    StrategyPtr intuition = loadIntuition(intuitionName, kPooled);
+    if (rollouts == 0)
+    {
+        return intuition;
+    }
+    else
+    {
+        AnnotatorPtr kNoAnnotator(0);
+        const bool kParallel = true;
+        MonteCarlo* monteCarlo = new MonteCarlo(intuition, rollouts, kParallel, kNoAnnotator, threadBudget);
+        if (earlyStopping)
+            monteCarlo->EnableEarlyStopping();
+        if (commonRandomNumbers)
+            monteCarlo->EnableCommonRandomNumbers();
+        if (endgameTricks > 0)
+            monteCarlo->EnableEndgameSolver(endgameTricks);
+        return StrategyPtr(monteCarlo);
+    }
+}
+
+StrategyPtr makePlayer(const std::string& playerArg)
+{
+    const int kDefaultRollouts = 40;
+
+    // Options follow the player, e.g. "random#1000:threads=8:adaptive:crn:endgame=3"
+    std::vector<std::string> options = split(playerArg, ':');
+    assert(options.size() > 0);
+    const std::string arg = options[0];
+
+    unsigned threadBudget = 0;
+    bool earlyStopping = false;
+    bool commonRandomNumbers = false;
+    unsigned endgameTricks = 0;
+    for (unsigned i = 1; i < options.size(); ++i)
+    {
+        std::vector<std::string> option = split(options[i], '=');
+        if (option.size() == 2 && option[0] == "threads")
+        {
+            threadBudget = std::stoi(option[1]);
+        }
+        else if (option.size() == 2 && option[0] == "endgame")
+        {
+            endgameTricks = std::stoi(option[1]);
+            if (endgameTricks > EndgameSolver::kMaxTricks)
+            {
+                fprintf(stderr, "The endgame option is limited to %u tricks in %s\n", EndgameSolver::kMaxTricks,
+                    playerArg.c_str());
+                exit(1);
+            }
+        }
+        else if (options[i] == "adaptive")
+        {
+            earlyStopping = true;
+        }
+        else if (options[i] == "crn")
+        {
+            commonRandomNumbers = true;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown player option %s in %s\n", options[i].c_str(), playerArg.c_str());
+            exit(1);
+        }
+    }
+
+    std::string intuitionName;
+    int rollouts;
+
+    const char kSep = '#';
+    if (arg[arg.size() - 1] == kSep)
+    {
+        intuitionName = arg.substr(0, arg.size() - 1);
+        rollouts = kDefaultRollouts;
+    }
+    else
+    {
+        std::vector<std::string> parts = split(arg, '#');
+        assert(parts.size() > 0);
+        assert(parts.size() <= 2);
+
+        intuitionName = parts[0];
+
+        if (parts.size() == 1)
+        {
+            rollouts = 0;
+        }
+        else
+        {
+            rollouts = std::stoi(parts[1]);
+        }
+    }
+    return makePlayer(intuitionName, rollouts, threadBudget, earlyStopping, commonRandomNumbers, endgameTricks);
+}
@@ -1,4 +1,5 @@
 #include "lib/random.h"
+#include "lib/SplitMix64.h"
 
 #include <stdlib.h>
 #include <assert.h>
@@ -23,6 +24,19 @@ RandomGenerator::RandomGenerator()
   mP = 0;
 }
 
+RandomGenerator::RandomGenerator(uint64_t seed)
+{
+  Seed(seed);
+}
+
+void RandomGenerator::Seed(uint64_t seed)
+{
+  // Expand the seed with splitmix64, which never makes a state that is everywhere zero.
+  for (int i = 0; i < 16; ++i)
+    mS[i] = SplitMix64(seed);
+  mP = 0;
+}
+
 uint64_t RandomGenerator::random64() const
 {
   // see https://en.wikipedia.org/wiki/Xorshift
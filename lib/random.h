@@ -7,6 +7,13 @@ class RandomGenerator
 {
 public:
   RandomGenerator();
+    // Seeded from /dev/urandom.
+
+  explicit RandomGenerator(uint64_t seed);
+    // A generator that makes the same sequence of random numbers for the same seed.
+
+  void Seed(uint64_t seed);
+    // Restarts the sequence of random numbers for the given seed, as in RandomGenerator(seed).
 
   uint64_t random64() const;
 
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+
+# The C++ engine's batch operations for training input pipelines, with the extension module heartsnn (see
+# lib/PythonModule.cpp). Each function handles a whole numpy array of states in one call, on the engine's threads,
+# and releases the GIL meanwhile, so a tf.data or thread pool pipeline can keep other work running.
+
+import glob
+import os
+import sys
+import numpy as np
+
+from constants import MAIN_INPUT_SHAPE
+from featurize import PACKED_KNOWABLE_STATE, as_states
+
+# The layout of PackedGameState (see lib/PackedGameState.h).
+PACKED_GAME_STATE = np.dtype([
+    ('hands', '<u8', (4,)),
+    ('trick', 'u1', (3,)),
+    ('next_play', 'u1'),
+    ('lead', 'u1'),
+    ('score', 'u1', (4,)),
+    ('point_tricks', 'u1', (4,)),
+    ('void_bits', '<u2'),
+], align=True)
+
+def find_module_dir():
+    """ The directory of the heartsnn module: $HEARTSNN_MODULE_DIR, or the lib directory of a build in builds/."""
+    path = os.environ.get('HEARTSNN_MODULE_DIR')
+    if path:
+        return path
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    candidates = sorted(glob.glob(os.path.join(root, 'builds', '*', 'lib', 'heartsnn.so')))
+    if not candidates:
+        raise ImportError('heartsnn.so not found: build it, or set HEARTSNN_MODULE_DIR')
+    return os.path.dirname(candidates[0])
+
+_module = None
+
+def module():
+    global _module
+    if _module is None:
+        sys.path.insert(0, find_module_dir())
+        try:
+            import heartsnn
+        finally:
+            sys.path.pop(0)
+        assert heartsnn.PACKED_GAME_STATE_BYTES == PACKED_GAME_STATE.itemsize
+        assert heartsnn.PACKED_KNOWABLE_STATE_BYTES == PACKED_KNOWABLE_STATE.itemsize
+        assert heartsnn.NUM_FEATURES == np.prod(MAIN_INPUT_SHAPE)
+        _module = heartsnn
+    return _module
+
+def as_game_states(states):
+    """ Views an array of packed game states, as PACKED_GAME_STATE records or as (N, 48) bytes, as a contiguous
+    array of PACKED_GAME_STATE."""
+    states = np.ascontiguousarray(states)
+    if states.dtype != PACKED_GAME_STATE:
+        states = states.view(PACKED_GAME_STATE).reshape(len(states))
+    return states
+
+def featurize(states, exact_probabilities=False):
+    """ Returns the (N, 52, 10) float32 main input for the packed knowable states."""
+    states = as_states(states)
+    main = np.empty((len(states),) + MAIN_INPUT_SHAPE, dtype=np.float32)
+    module().encode_features(states, main, exact_probabilities=exact_probabilities)
+    return main
+
+def deal(deal_indexes):
+    """ Returns the PACKED_GAME_STATE at the start of each deal. The 128-bit deal indexes are given as (N, 2)
+    uint64s, the low half first, or as N python ints."""
+    deal_indexes = np.asarray(deal_indexes)
+    if deal_indexes.dtype == object or deal_indexes.ndim == 1:
+        deal_indexes = np.array([(int(i) & (2**64 - 1), int(i) >> 64) for i in deal_indexes], dtype='<u8')
+    deal_indexes = np.ascontiguousarray(deal_indexes, dtype='<u8').reshape(-1, 2)
+    states = np.empty(len(deal_indexes), dtype=PACKED_GAME_STATE)
+    module().deal(deal_indexes, states)
+    return states
+
+def rollouts(states, num_rollouts, seed):
+    """ Plays each packed game state out randomly num_rollouts times, and returns the (N, 4) float32 mean points
+    taken by each player. The results depend only on the states and the seed."""
+    states = as_game_states(states)
+    points = np.empty((len(states), 4), dtype=np.float32)
+    module().rollouts(states, num_rollouts, seed, points)
+    return points
+
+def sample_deals(states, samples_per_state, seed):
+    """ Returns (N, samples_per_state) PACKED_GAME_STATEs for the packed knowable states, dealing the unknown cards
+    so that each possible deal is equally likely. The results depend only on the states and the seed."""
+    states = as_states(states)
+    deals = np.empty((len(states), samples_per_state), dtype=PACKED_GAME_STATE)
+    module().sample_deals(states, samples_per_state, seed, deals)
+    return deals
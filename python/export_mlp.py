@@ -0,0 +1,168 @@
+"""
+Export a model trained by train.py to the dense MLP format read by the C++ DenseMlpBackend (lib/DenseMlpBackend.h).
+
+The C++ backend evaluates only dense layers, so at export time:
+ * each BatchNormalization is folded into a per-output scale and shift, using its moving mean and variance
+ * each convolution over ranks is lowered to an equivalent dense layer. The layer is block diagonal, one block
+   per suit, and is mostly zeros, which costs little since the trunk is small compared to the heads.
+
+Usage:
+    python3 export_mlp.py <model_dir> <output.mlp>
+
+The resulting .mlp file can be passed anywhere the C++ apps accept a model path, e.g. `hearts -m <output.mlp>`.
+"""
+
+import struct
+import sys
+
+import numpy as np
+
+from constants import *
+
+MAGIC = b'HNNMLP01'
+
+LINEAR = 0
+RELU = 1
+SOFTMAX_MOON_CLASSES = 2
+
+HAS_AFFINE = 1
+
+# The default epsilon of tf.keras.layers.BatchNormalization
+BATCH_NORM_EPSILON = 1e-3
+
+
+class Layer:
+    """ One dense layer: y = act(weights @ x + bias) * scale + shift, plus the input of layer residual_from. """
+    def __init__(self, weights, bias, activation=RELU, scale=None, shift=None, residual_from=-1):
+        self.weights = np.asarray(weights, dtype=np.float32)  # shape (outputs, inputs)
+        self.bias = np.asarray(bias, dtype=np.float32)
+        self.activation = activation
+        self.scale = None if scale is None else np.asarray(scale, dtype=np.float32)
+        self.shift = None if shift is None else np.asarray(shift, dtype=np.float32)
+        self.residual_from = residual_from
+        assert self.bias.shape == (self.weights.shape[0],)
+
+
+def bn_to_affine(gamma, beta, mean, variance, epsilon=BATCH_NORM_EPSILON):
+    """ Returns the (scale, shift) equivalent to an inference mode BatchNormalization. """
+    scale = gamma / np.sqrt(variance + epsilon)
+    shift = beta - mean * scale
+    return scale, shift
+
+
+def conv_to_dense(kernel, bias, input_height, num_suits=NUM_SUITS):
+    """
+    Lowers one convolution of one_conv_layer() in model.py to a dense layer.
+
+    The convolution is applied to each suit independently. Its input for one suit is (input_height, F) and the
+    kernel has shape (R, F, 1, K), with valid padding, so the output for one suit is (input_height-R+1, K).
+    Both the input and output are flattened in the order (suit, height, feature), which is the order used by
+    KnowableState for the model input, and by the reshape/flatten at the end of convolution_layers().
+    Returns (weights, bias) with weights of shape (outputs, inputs).
+    """
+    ranks, features, channels, filters = kernel.shape
+    assert channels == 1
+    output_height = input_height - ranks + 1
+    suit_inputs = input_height * features
+    suit_outputs = output_height * filters
+
+    weights = np.zeros((num_suits * suit_outputs, num_suits * suit_inputs), dtype=np.float32)
+    for suit in range(num_suits):
+        for h in range(output_height):
+            rows = suit * suit_outputs + h * filters
+            for r in range(ranks):
+                cols = suit * suit_inputs + (h + r) * features
+                weights[rows:rows+filters, cols:cols+features] = kernel[r, :, 0, :].T
+    return weights, np.tile(np.tile(bias, output_height), num_suits), output_height
+
+
+def write_mlp(path, trunk, score_head, moon_head):
+    """ Writes the three stacks, each a list of Layer, in the format documented in lib/DenseMlpBackend.h """
+    def u32(f, value):
+        f.write(struct.pack('<I', value))
+
+    with open(path, 'wb') as f:
+        f.write(MAGIC)
+        u32(f, TOTAL_SCALAR_FEATURES)
+        for layers, output_activation in [(trunk, LINEAR), (score_head, RELU), (moon_head, SOFTMAX_MOON_CLASSES)]:
+            u32(f, len(layers))
+            u32(f, output_activation)
+            for layer in layers:
+                outputs, inputs = layer.weights.shape
+                has_affine = layer.scale is not None
+                for value in (inputs, outputs, layer.activation, HAS_AFFINE if has_affine else 0):
+                    u32(f, value)
+                f.write(struct.pack('<i', layer.residual_from))
+                f.write(layer.weights.astype('<f4').tobytes())
+                f.write(layer.bias.astype('<f4').tobytes())
+                if has_affine:
+                    f.write(layer.scale.astype('<f4').tobytes())
+                    f.write(layer.shift.astype('<f4').tobytes())
+
+
+def dense_norm_layer(values, residual_from=-1):
+    """ Converts the 6 variables of dense_norm() in model.py (kernel, bias, gamma, beta, mean, variance). """
+    kernel, bias, gamma, beta, mean, variance = values
+    scale, shift = bn_to_affine(gamma, beta, mean, variance)
+    return Layer(kernel.T, bias, RELU, scale, shift, residual_from)
+
+
+def head_stack(values):
+    """ Converts the variables of head_layers() in model.py: one dense_norm, then residual layers of two each. """
+    assert len(values) % 6 == 0
+    layers = [dense_norm_layer(values[0:6])]
+    for i in range(6, len(values), 12):
+        # The residual adds the input of the first dense_norm of the pair to the output of the second.
+        first = len(layers)
+        layers.append(dense_norm_layer(values[i:i+6]))
+        layers.append(dense_norm_layer(values[i+6:i+12], residual_from=first))
+    return layers
+
+
+def trunk_stack(values):
+    """ Converts the variables of convolution_layers() in model.py. Each convolution has 6 variables. """
+    assert len(values) % 6 == 0
+    layers = []
+    height = NUM_RANKS
+    for i in range(0, len(values), 6):
+        kernel, bias, gamma, beta, mean, variance = values[i:i+6]
+        weights, dense_bias, height = conv_to_dense(kernel, bias, height)
+        # The batch norm normalizes each filter, which repeats for each suit and output rank.
+        scale, shift = bn_to_affine(gamma, beta, mean, variance)
+        repeats = weights.shape[0] // len(scale)
+        layers.append(Layer(weights, dense_bias, RELU, np.tile(scale, repeats), np.tile(shift, repeats)))
+    return layers
+
+
+def export_from_model_dir(model_dir, path):
+    """
+    Rebuilds the inference graph of model.py, restores the latest checkpoint from model_dir, and writes path.
+    Variables are read in creation order, which for each layer is the kernel, bias, and batch norm
+    gamma, beta, moving mean and moving variance.
+    """
+    import tensorflow as tf
+    from model import model_fn
+
+    with tf.Graph().as_default():
+        features = {MAIN_DATA: tf.placeholder(tf.float32, (None,) + MAIN_INPUT_SHAPE)}
+        params = {'hidden_width': 0, 'hidden_depth': 0, 'num_batches': 1, 'activation': 'relu'}
+        model_fn(features, None, tf.estimator.ModeKeys.PREDICT, params)
+
+        with tf.Session() as sess:
+            tf.train.Saver().restore(sess, tf.train.latest_checkpoint(model_dir))
+            variables = tf.global_variables()
+            values = sess.run(variables)
+
+    def scope_values(scope):
+        return [v for var, v in zip(variables, values) if var.name.startswith(scope + '/')]
+
+    assert SCORE and MOON, 'The C++ backend requires both the expected score and moon heads'
+    write_mlp(path, trunk_stack(scope_values('convolution_layers')),
+              head_stack(scope_values(EXPECTED_SCORE)), head_stack(scope_values(MOON_PROB)))
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print('Usage: export_mlp.py <model_dir> <output.mlp>')
+        sys.exit(1)
+    export_from_model_dir(sys.argv[1], sys.argv[2])
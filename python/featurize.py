@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+
+# Computing the main input features from packed knowable states, as stored in the `state` field of the record
+# files written by `hearts`, with the C++ engine's libheartsnn (see lib/HeartsCApi.h).
+# The features are always those of the engine that is loaded, so changing KnowableState::EncodeFeatures() does not
+# require generating the data again.
+
+import ctypes
+import glob
+import os
+import numpy as np
+
+from constants import MAIN_INPUT_SHAPE
+
+# The layout of PackedKnowableState (see lib/PackedKnowableState.h).
+PACKED_KNOWABLE_STATE = np.dtype([
+    ('hand', '<u8'),
+    ('unplayed', '<u8'),
+    ('trick', 'u1', (3,)),
+    ('next_play', 'u1'),
+    ('lead', 'u1'),
+    ('score', 'u1', (4,)),
+    ('point_tricks', 'u1', (4,)),
+    ('void_bits', '<u2'),
+], align=True)
+
+def find_library():
+    """ The path of libheartsnn: $HEARTSNN_LIB, or the library of a build in builds/."""
+    path = os.environ.get('HEARTSNN_LIB')
+    if path:
+        return path
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    candidates = sorted(glob.glob(os.path.join(root, 'builds', '*', 'lib', 'libheartsnn.so')))
+    if not candidates:
+        raise OSError('libheartsnn.so not found: build it, or set HEARTSNN_LIB')
+    return candidates[0]
+
+_lib = None
+
+def library():
+    global _lib
+    if _lib is None:
+        lib = ctypes.CDLL(find_library())
+        lib.heartsnn_packed_knowable_state_bytes.restype = ctypes.c_size_t
+        lib.heartsnn_num_features.restype = ctypes.c_size_t
+        lib.heartsnn_encode_features.argtypes = [ctypes.c_void_p, ctypes.c_size_t, ctypes.c_void_p, ctypes.c_int]
+        lib.heartsnn_encode_features.restype = None
+        assert lib.heartsnn_packed_knowable_state_bytes() == PACKED_KNOWABLE_STATE.itemsize
+        assert lib.heartsnn_num_features() == np.prod(MAIN_INPUT_SHAPE)
+        _lib = lib
+    return _lib
+
+def as_states(states):
+    """ Views an array of packed states, either as PACKED_KNOWABLE_STATE records or as (N, 32) bytes, such as the
+    `state` field of a record file, as a contiguous array of PACKED_KNOWABLE_STATE."""
+    states = np.ascontiguousarray(states)
+    if states.dtype != PACKED_KNOWABLE_STATE:
+        states = states.view(PACKED_KNOWABLE_STATE).reshape(len(states))
+    return states
+
+def featurize(states, exact_probabilities=False):
+    """ Returns the (N, 52, 10) float32 main input for the packed states. The states are encoded in parallel on
+    the engine's threads, in one call."""
+    states = as_states(states)
+    main = np.empty((len(states),) + MAIN_INPUT_SHAPE, dtype=np.float32)
+    library().heartsnn_encode_features(states.ctypes.data, len(states), main.ctypes.data, int(exact_probabilities))
+    return main
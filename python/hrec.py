@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+
+# Reading record files (.hrec), as written by the C++ RecordWriter (see lib/RecordFile.h).
+# A record file holds one fixed-stride record per sample, so it maps directly to a numpy structured array.
+
+import ast
+import struct
+import sys
+import numpy as np
+
+from constants import CARDS_IN_DECK, INPUT_FEATURES, NUM_RANKS
+
+MAGIC = b'\x93HREC\x01\x00\x00'
+FIXED_HEADER = struct.Struct('<8sIIQQ')
+
+def read_header(path):
+    """ Returns (dtype, header_bytes, num_records, index_offset) for the record file at `path`."""
+    with open(path, 'rb') as f:
+        fixed = f.read(FIXED_HEADER.size)
+        magic, header_bytes, stride, num_records, index_offset = FIXED_HEADER.unpack(fixed)
+        if magic != MAGIC:
+            raise ValueError('{} is not a record file'.format(path))
+        descr = f.read(header_bytes - FIXED_HEADER.size).rstrip(b'\0').decode('ascii')
+    dtype = np.dtype(ast.literal_eval(descr))
+    if dtype.itemsize != stride:
+        raise ValueError('{}: the schema does not match the stride'.format(path))
+    return dtype, header_bytes, num_records, index_offset
+
+def load_hrec(path):
+    """ Maps the record file at `path`. Returns (records, index): records is a read-only structured array with one
+    field per field of the schema (such as records['main'], of shape (N, 52, 10)), and index is the array of uint32
+    keys of the records, or None if the file has no index."""
+    dtype, header_bytes, num_records, index_offset = read_header(path)
+    if num_records == 0:
+        return np.zeros(0, dtype=dtype), (np.zeros(0, dtype='<u4') if index_offset != 0 else None)
+    records = np.memmap(path, mode='r', dtype=dtype, offset=header_bytes, shape=(num_records,))
+    index = None
+    if index_offset != 0:
+        index = np.memmap(path, mode='r', dtype='<u4', offset=index_offset, shape=(num_records,))
+    return records, index
+
+# The layout of the features field of the records written by WriteTrainingDataSets (see lib/CompactFeatures.h):
+# a byte of flags per card, then two quantized probabilities per card.
+LEGAL_PLAY, HELD_BY_PLAYER, UNKNOWN, POINTS, ON_TABLE, HIGH_CARD_IN_TRICK, PLAYER_NOT_RULED_OUT, OTHER_NOT_RULED_OUT = range(8)
+PROBABILITY_SCALE = 240
+QUEEN_OF_SPADES = 2*NUM_RANKS + 10
+POINTS_FEATURE = np.full(CARDS_IN_DECK, 1.0/26.0, dtype=np.float32)
+POINTS_FEATURE[QUEEN_OF_SPADES] = 13.0/26.0
+
+def expand_features(features):
+    """ Expands the (N, 156) uint8 compact features to the (N, 52, 10) float32 main input, the same floats as
+    KnowableState::EncodeFeatures() (and CompactFeatures::Decode())."""
+    n = len(features)
+    flags = np.asarray(features[:, :CARDS_IN_DECK])
+    q = np.asarray(features[:, CARDS_IN_DECK:], dtype=np.int32).reshape(n, CARDS_IN_DECK, 2)
+    bits = np.unpackbits(flags[..., np.newaxis], axis=-1, bitorder='little').astype(np.float32)
+    scale = np.float32(PROBABILITY_SCALE)
+
+    main = np.zeros((n, CARDS_IN_DECK, INPUT_FEATURES), dtype=np.float32)
+    main[..., 0] = bits[..., LEGAL_PLAY]
+    main[..., 1] = bits[..., HELD_BY_PLAYER]
+    main[..., 2] = q[..., 0].astype(np.float32) / scale
+    main[..., 3] = q[..., 1].astype(np.float32) / scale
+    main[..., 4] = bits[..., UNKNOWN] * ((PROBABILITY_SCALE - q[..., 0] - q[..., 1]).astype(np.float32) / scale)
+    main[..., 5] = bits[..., POINTS] * POINTS_FEATURE
+    main[..., 6:10] = bits[..., ON_TABLE:]
+    return main
+
+def expand_outputs(values, legal):
+    """ Expands outputs kept for the legal plays only, (N, 13) or (N, 13, 3), to outputs for every card, (N, 52) or
+    (N, 52, 3), given the (N, 52) legal play flags."""
+    legal = legal.astype(bool)
+    index = np.clip(np.cumsum(legal, axis=1) - 1, 0, NUM_RANKS - 1)
+    if values.ndim == 3:
+        index = index[..., np.newaxis]
+        legal = legal[..., np.newaxis]
+    expanded = np.take_along_axis(np.asarray(values), index, axis=1)
+    return np.where(legal, expanded, np.float32(0)).astype(np.float32)
+
+def expand_records(records):
+    """ Returns the main input and the score, moon and trick outputs of the records, as full float32 arrays.
+    Records written without features (`hearts ... --state-only`) are featurized from their states with the engine."""
+    if 'main' in records.dtype.names:
+        return {kind: np.asarray(records[kind]) for kind in ['main', 'score', 'moon', 'trick']}
+    if 'features' in records.dtype.names:
+        main = expand_features(records['features'])
+    else:
+        from featurize import featurize
+        main = featurize(records['state'])
+    legal = main[..., 0]
+    return {
+        'main': main,
+        'score': expand_outputs(records['score'], legal),
+        'moon': expand_outputs(records['moon'], legal),
+        'trick': expand_outputs(records['trick'], legal),
+    }
+
+if __name__ == '__main__':
+    for path in sys.argv[1:]:
+        records, index = load_hrec(path)
+        print(path, len(records), records.dtype, 'indexed' if index is not None else 'not indexed')
@@ -6,6 +6,7 @@
 # i.e. one containing gamestates for all 47 possible play numbers.
 
 import glob
+import hrec
 import memmap
 import numpy as np
 import os
@@ -17,18 +18,37 @@ def extract_hash(path):
     assert m is not None
     return m[1]
 
-def merge_kind(group, purpose, kind, hashes):
-    group[kind] = []
-    for hash in hashes:
-        a = np.load('data/{}-{}.npy'.format(hash, kind))
-        group[kind].append(a)
-    group[kind] = np.concatenate(group[kind])
-    print(kind, group[kind].shape)
+def shard_prefixes():
+    """ The name prefixes of all complete shards: those listed in the manifests, and unsharded files
+    written before there were manifests."""
+    prefixes = []
+    for manifest in glob.glob('data/*-manifest.txt'):
+        with open(manifest) as f:
+            for line in f:
+                prefix, rows = line.split()
+                prefixes.append(prefix)
+    for path in glob.glob('data/*-main.npy'):
+        if re.match(r'data/[\da-f]+-main.npy', path):
+            prefixes.append(extract_hash(path))
+    return prefixes
+
+KINDS = ['main', 'moon', 'score', 'trick']
+
+def load_shard(prefix):
+    """ The four kinds of data of a shard: expanded from its record file, or the numpy files of shards written
+    before there were record files."""
+    path = 'data/{}.hrec'.format(prefix)
+    if os.path.exists(path):
+        records, index = hrec.load_hrec(path)
+        return hrec.expand_records(records)
+    return {kind: np.load('data/{}-{}.npy'.format(prefix, kind)) for kind in KINDS}
 
 def merge_dataset(purpose, hashes):
+    shards = [load_shard(hash) for hash in hashes]
     group = {}
-    for kind in ['main', 'moon', 'score', 'trick']:
-        merge_kind(group, purpose, kind, hashes)
+    for kind in KINDS:
+        group[kind] = np.concatenate([shard[kind] for shard in shards])
+        print(kind, group[kind].shape)
 
     N = len(group['main'])
     assert N == len(group['moon'])
@@ -39,8 +59,7 @@ def merge_dataset(purpose, hashes):
 
 if __name__ == '__main__':
 
-    main_files = glob.glob('data/*-main.npy')
-    hashes = [extract_hash(path) for path in main_files]
+    hashes = shard_prefixes()
 
     num_datasets = len(hashes)
     N = num_datasets // 2
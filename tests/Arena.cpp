@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+
+#include "lib/Arena.h"
+
+#include <stdint.h>
+#include <thread>
+
+TEST(Arena, Allocate) {
+  Arena arena;
+  char* prev = 0;
+  for (unsigned i = 0; i < 10000; ++i) {
+    const size_t alignment = size_t(1) << (i % 5);
+    char* p = (char*) arena.Allocate(24, alignment);
+    EXPECT_EQ(0u, uintptr_t(p) % alignment);
+    if (prev != 0) {
+      EXPECT_TRUE(p >= prev + 24 || p + 24 <= prev);
+    }
+    prev = p;
+  }
+  EXPECT_GE(arena.BytesReserved(), 10000u * 24u);
+
+  // Large allocations get their own block.
+  const size_t reserved = arena.BytesReserved();
+  arena.Allocate(3 * Arena::kBlockSize, 16);
+  EXPECT_EQ(reserved + 3 * Arena::kBlockSize, arena.BytesReserved());
+}
+
+TEST(Arena, LivesWithItsObjects) {
+  std::weak_ptr<Arena> weak;
+  std::shared_ptr<uint64_t> object;
+  {
+    ArenaPtr arena = std::make_shared<Arena>();
+    weak = arena;
+    object = std::allocate_shared<uint64_t>(ArenaAllocator<uint64_t>(arena), 42);
+  }
+  EXPECT_FALSE(weak.expired());
+  EXPECT_EQ(42u, *object);
+  object.reset();
+  EXPECT_TRUE(weak.expired());
+}
+
+TEST(Arena, ThreadSpecific) {
+  const Arena* mine = Arena::ThreadSpecific().get();
+  EXPECT_EQ(mine, Arena::ThreadSpecific().get());
+
+  const Arena* theirs = 0;
+  std::thread other([&theirs]() { theirs = Arena::ThreadSpecific().get(); });
+  other.join();
+  EXPECT_NE(mine, theirs);
+
+  // A full arena is replaced.
+  std::weak_ptr<Arena> weak = Arena::ThreadSpecific();
+  while (Arena::ThreadSpecific().get() == mine)
+    Arena::ThreadSpecific()->Allocate(Arena::kBlockSize, 16);
+  EXPECT_TRUE(weak.expired());
+}
@@ -53,6 +53,18 @@ TEST(GreatestSetBitIndex, Zero) {
   EXPECT_EQ(-1, GreatestSetBitIndex(kZero));
 }
 
+TEST(NthSetBitIndex, nominal) {
+  const uint64_t bits = 0x8000100000A00001ul;
+  EXPECT_EQ(0, NthSetBitIndex(bits, 0));
+  EXPECT_EQ(21, NthSetBitIndex(bits, 1));
+  EXPECT_EQ(23, NthSetBitIndex(bits, 2));
+  EXPECT_EQ(44, NthSetBitIndex(bits, 3));
+  EXPECT_EQ(63, NthSetBitIndex(bits, 4));
+  for (unsigned i=0; i<64; ++i) {
+    EXPECT_EQ(i, NthSetBitIndex(~kZero, i));
+  }
+}
+
 TEST(CountBits, nominal) {
   EXPECT_EQ(0, CountBits(kZero));
   EXPECT_EQ(1, CountBits(8));
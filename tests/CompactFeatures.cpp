@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+
+#include "lib/CompactFeatures.h"
+#include "lib/GameState.h"
+#include "lib/KnowableState.h"
+#include "lib/random.h"
+
+#include <string.h>
+
+// The features of AsProbabilities() decode to exactly the same floats, at every play of random games.
+TEST(CompactFeatures, RoundTrip) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 200; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      const KnowableState state(gameState);
+      float expected[KnowableState::kNumFeatures];
+      state.EncodeFeatures(expected);
+
+      const CompactFeatures compact(expected);
+      float actual[KnowableState::kNumFeatures + 1];
+      actual[KnowableState::kNumFeatures] = -1.0f;
+      compact.Decode(actual);
+      ASSERT_EQ(0, memcmp(expected, actual, sizeof(expected)));
+      ASSERT_EQ(-1.0f, actual[KnowableState::kNumFeatures]);
+
+      const FloatMatrix matrix = compact.AsFloatMatrix();
+      ASSERT_EQ(0, memcmp(expected, matrix.data(), sizeof(expected)));
+
+      gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+}
+
+// The exact probabilities are quantized. The last player's probability takes the rounding of both others.
+TEST(CompactFeatures, ExactProbabilities) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  const float kTolerance = 1.0f / CompactFeatures::kProbabilityScale + 1e-6f;
+
+  for (int game = 0; game < 5; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      const KnowableState state(gameState);
+      float expected[KnowableState::kNumFeatures];
+      state.EncodeFeatures(expected, true);
+
+      float actual[KnowableState::kNumFeatures];
+      CompactFeatures(expected).Decode(actual);
+      for (unsigned i = 0; i < KnowableState::kNumFeatures; ++i)
+        ASSERT_NEAR(expected[i], actual[i], kTolerance) << "feature " << i;
+
+      gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+}
@@ -2,6 +2,7 @@
 
 #include "lib/combinatorics.h"
 #include "lib/Deal.h"
+#include "lib/random.h"
 
 TEST(Deal, defaultConstructor) {
   Deal deal;
@@ -52,3 +53,61 @@ TEST(Deal, deckWithLastIndex) {
     }
   }
 }
+
+// The original 128-bit unranking, which the 32 and 64-bit kernels must reproduce exactly.
+static void ReferenceDealUnknownsToHands(const CardDeck& unknowns, CardHands& hands, uint128_t index)
+{
+  CardArray::iterator it(unknowns);
+  uint128_t K = PossibleDealUnknownsToHands(unknowns, hands);
+  for (unsigned C = unknowns.Size(); C>0; --C) {
+    uint128_t X = 0;
+    for (int i=0; i<4; i++) {
+      index -= X;
+      X = (K * hands[i].AvailableCapacity()) / C;
+      if (index < X) {
+        hands[i].Insert(it.next());
+        break;
+      }
+    }
+    K = X;
+  }
+}
+
+TEST(Deal, unknownsMatchReference) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  // From small counts that use the 32-bit kernel up to the full deck, which uses the 128-bit kernel.
+  for (unsigned numCards = 0; numCards <= 52; ++numCards) {
+    for (int trial = 0; trial < 20; ++trial) {
+      unsigned capacities[4] = {0};
+      for (unsigned c = 0; c < numCards; ++c) {
+        unsigned p = rng.range64(4);
+        while (capacities[p] == 13)
+          p = (p + 1) % 4;
+        ++capacities[p];
+      }
+
+      CardDeck deck(kFull, kCardsPerDeck);
+      CardDeck unknowns;
+      unknowns.PrepForDeal(numCards);
+      for (unsigned c = 0; c < numCards; ++c) {
+        const Card card = deck.aCardAtRandom(rng);
+        deck.RemoveCard(card);
+        unknowns.Insert(card);
+      }
+
+      CardHands hands;
+      for (int p = 0; p < 4; ++p)
+        hands[p].PrepForDeal(capacities[p]);
+      const uint128_t possible = PossibleDealUnknownsToHands(unknowns, hands);
+
+      for (uint128_t index : {uint128_t(0), rng.range128(possible), possible - 1}) {
+        CardHands dealt(hands), reference(hands);
+        DealUnknownsToHands(unknowns, dealt, index);
+        ReferenceDealUnknownsToHands(unknowns, reference, index);
+        for (int p = 0; p < 4; ++p)
+          ASSERT_EQ(reference[p].Bits(), dealt[p].Bits());
+      }
+    }
+  }
+}
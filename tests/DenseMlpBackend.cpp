@@ -0,0 +1,186 @@
+#include "gtest/gtest.h"
+
+#include "lib/DenseMlpBackend.h"
+#include "lib/KnowableState.h"
+
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <unistd.h>
+
+namespace {
+
+struct TestLayer {
+  unsigned inputs;
+  unsigned outputs;
+  unsigned activation;
+  bool affine;
+  int residualFrom;
+  std::vector<float> weights;  // [outputs][inputs]
+  std::vector<float> bias, scale, shift;
+};
+
+struct TestStack {
+  unsigned outputActivation;
+  std::vector<TestLayer> layers;
+};
+
+TestLayer RandomLayer(std::mt19937& rng, unsigned inputs, unsigned outputs, unsigned activation, bool affine,
+                      int residualFrom) {
+  std::normal_distribution<float> normal(0.0f, 1.0f / sqrtf(inputs));
+  std::uniform_real_distribution<float> uniform(0.5f, 1.5f);
+  TestLayer layer{inputs, outputs, activation, affine, residualFrom};
+  for (unsigned i = 0; i < inputs * outputs; ++i)
+    layer.weights.push_back(normal(rng));
+  for (unsigned o = 0; o < outputs; ++o) {
+    layer.bias.push_back(normal(rng));
+    layer.scale.push_back(uniform(rng));
+    layer.shift.push_back(normal(rng));
+  }
+  return layer;
+}
+
+void WriteModel(const std::string& path, const std::vector<TestStack>& stacks) {
+  FILE* file = fopen(path.c_str(), "wb");
+  ASSERT_TRUE(file != 0);
+  auto put = [file](const void* data, size_t bytes) { fwrite(data, 1, bytes, file); };
+  auto putU32 = [&put](uint32_t value) { put(&value, sizeof(value)); };
+
+  put(DenseMlpBackend::kMagic, 8);
+  putU32(KnowableState::kNumFeatures);
+  for (const TestStack& stack : stacks) {
+    putU32(stack.layers.size());
+    putU32(stack.outputActivation);
+    for (const TestLayer& layer : stack.layers) {
+      putU32(layer.inputs);
+      putU32(layer.outputs);
+      putU32(layer.activation);
+      putU32(layer.affine ? DenseMlpBackend::kHasAffine : 0);
+      const int32_t residualFrom = layer.residualFrom;
+      put(&residualFrom, sizeof(residualFrom));
+      put(layer.weights.data(), layer.weights.size() * sizeof(float));
+      put(layer.bias.data(), layer.bias.size() * sizeof(float));
+      if (layer.affine) {
+        put(layer.scale.data(), layer.scale.size() * sizeof(float));
+        put(layer.shift.data(), layer.shift.size() * sizeof(float));
+      }
+    }
+  }
+  fclose(file);
+}
+
+// A straightforward evaluation of one row, to check the optimized kernels against.
+std::vector<float> ReferenceStack(const TestStack& stack, const std::vector<float>& input) {
+  std::vector<std::vector<float>> layerInputs;
+  std::vector<float> x = input;
+  for (const TestLayer& layer : stack.layers) {
+    layerInputs.push_back(x);
+    std::vector<float> y(layer.outputs);
+    for (unsigned o = 0; o < layer.outputs; ++o) {
+      double sum = layer.bias[o];
+      for (unsigned i = 0; i < layer.inputs; ++i)
+        sum += double(layer.weights[o * layer.inputs + i]) * x[i];
+      float v = float(sum);
+      if (layer.activation == DenseMlpBackend::kRelu)
+        v = std::max(v, 0.0f);
+      if (layer.affine)
+        v = v * layer.scale[o] + layer.shift[o];
+      if (layer.residualFrom >= 0)
+        v += layerInputs[layer.residualFrom][o];
+      y[o] = v;
+    }
+    x = y;
+  }
+
+  if (stack.outputActivation == DenseMlpBackend::kRelu) {
+    for (float& v : x)
+      v = std::max(v, 0.0f);
+  } else if (stack.outputActivation == DenseMlpBackend::kSoftmaxMoonClasses) {
+    for (unsigned c = 0; c < x.size(); c += kNumMoonClasses) {
+      double sum = 0;
+      for (unsigned k = 0; k < kNumMoonClasses; ++k)
+        sum += exp(x[c + k]);
+      for (unsigned k = 0; k < kNumMoonClasses; ++k)
+        x[c + k] = float(exp(x[c + k]) / sum);
+    }
+  }
+  return x;
+}
+
+}  // namespace
+
+TEST(DenseMlpBackend, MatchesReference) {
+  const unsigned kFeatures = KnowableState::kNumFeatures;
+  const unsigned kWidth = 40;  // Deliberately not a multiple of any SIMD width
+  std::mt19937 rng(12345);
+
+  TestStack trunk{DenseMlpBackend::kLinear};
+  trunk.layers.push_back(RandomLayer(rng, kFeatures, kWidth, DenseMlpBackend::kRelu, true, -1));
+  trunk.layers.push_back(RandomLayer(rng, kWidth, kWidth, DenseMlpBackend::kRelu, true, -1));
+  trunk.layers.push_back(RandomLayer(rng, kWidth, kWidth, DenseMlpBackend::kLinear, false, 1));
+
+  TestStack score{DenseMlpBackend::kRelu};
+  score.layers.push_back(RandomLayer(rng, kWidth, 24, DenseMlpBackend::kRelu, true, -1));
+  score.layers.push_back(RandomLayer(rng, 24, 24, DenseMlpBackend::kRelu, false, 1));
+  score.layers.push_back(RandomLayer(rng, 24, kScoresPerRow, DenseMlpBackend::kLinear, false, -1));
+
+  TestStack moon{DenseMlpBackend::kSoftmaxMoonClasses};
+  moon.layers.push_back(RandomLayer(rng, kWidth, kWidth, DenseMlpBackend::kRelu, false, 0));
+  moon.layers.push_back(RandomLayer(rng, kWidth, kMoonProbsPerRow, DenseMlpBackend::kLinear, true, -1));
+
+  char path[] = "/tmp/DenseMlpBackendTestXXXXXX";
+  const int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  WriteModel(path, {trunk, score, moon});
+  DenseMlpBackend backend(path);
+  unlink(path);
+  EXPECT_EQ(8u, backend.NumLayers());
+
+  // Sparse 0/1 inputs, like the features of a KnowableState.
+  const unsigned kMaxRows = 150;
+  std::bernoulli_distribution bit(0.1);
+  std::vector<float> input(kMaxRows * kFeatures);
+  for (float& x : input)
+    x = bit(rng) ? 1.0f : 0.0f;
+
+  for (unsigned numRows : {1u, 3u, 4u, 7u, 64u, 65u, 150u}) {
+    std::vector<float> expectedScore(numRows * kScoresPerRow);
+    std::vector<float> moonProbs(numRows * kMoonProbsPerRow);
+    backend.Run(input.data(), numRows, expectedScore.data(), moonProbs.data());
+
+    for (unsigned row = 0; row < numRows; ++row) {
+      const std::vector<float> rowInput(input.begin() + row * kFeatures, input.begin() + (row + 1) * kFeatures);
+      const std::vector<float> features = ReferenceStack(trunk, rowInput);
+      const std::vector<float> refScore = ReferenceStack(score, features);
+      const std::vector<float> refMoon = ReferenceStack(moon, features);
+      for (unsigned c = 0; c < kScoresPerRow; ++c)
+        ASSERT_NEAR(refScore[c], expectedScore[row * kScoresPerRow + c], 1e-3) << numRows << " " << row << " " << c;
+      for (unsigned c = 0; c < kMoonProbsPerRow; ++c)
+        ASSERT_NEAR(refMoon[c], moonProbs[row * kMoonProbsPerRow + c], 1e-4) << numRows << " " << row << " " << c;
+    }
+  }
+}
+
+// Run() applies the output activation of the heads only, so a trunk with any other output is rejected.
+TEST(DenseMlpBackend, RejectsTrunkOutputActivation) {
+  const unsigned kWidth = 8;
+  std::mt19937 rng(54321);
+  TestStack score{DenseMlpBackend::kRelu};
+  score.layers.push_back(RandomLayer(rng, kWidth, kScoresPerRow, DenseMlpBackend::kLinear, false, -1));
+  TestStack moon{DenseMlpBackend::kSoftmaxMoonClasses};
+  moon.layers.push_back(RandomLayer(rng, kWidth, kMoonProbsPerRow, DenseMlpBackend::kLinear, false, -1));
+
+  for (unsigned activation : {DenseMlpBackend::kRelu, DenseMlpBackend::kSoftmaxMoonClasses}) {
+    TestStack trunk{activation};
+    trunk.layers.push_back(RandomLayer(rng, KnowableState::kNumFeatures, kWidth, DenseMlpBackend::kRelu, false, -1));
+
+    char path[] = "/tmp/DenseMlpBackendTestXXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    WriteModel(path, {trunk, score, moon});
+    EXPECT_EXIT(DenseMlpBackend backend(path), ::testing::ExitedWithCode(1), "the trunk must have a linear output");
+    unlink(path);
+  }
+}
@@ -0,0 +1,140 @@
+#include "gtest/gtest.h"
+
+#include "lib/combinatorics.h"
+#include "lib/Distribution.h"
+#include "lib/random.h"
+
+#include <atomic>
+
+namespace {
+
+CardHands FourHands(unsigned capacity)
+{
+  CardHands hands;
+  for (int p=0; p<4; ++p)
+    hands[p].PrepForDeal(capacity);
+  return hands;
+}
+
+}  // namespace
+
+TEST(Distribution, staysNarrowWhileCountsFit) {
+  Distribution distribution;
+  const CardDeck spades(CardHand::SuitMask(kSpades), kEmpty);
+  distribution.DistributeRemainingToPlayer(spades, 2, 1000);
+  distribution *= 3;
+  EXPECT_FALSE(distribution.IsWide());
+  EXPECT_EQ(uint128_t(3000), distribution.Count(CardFor(kAce, kSpades), 2));
+  EXPECT_EQ(uint128_t(0), distribution.Count(CardFor(kAce, kSpades), 1));
+  EXPECT_EQ(uint128_t(0), distribution.Count(CardFor(kAce, kHearts), 2));
+}
+
+TEST(Distribution, widensWhenCountsOverflow64Bits) {
+  const uint128_t big = uint128_t(1) << 63;
+  const CardDeck clubs(CardHand::SuitMask(kClubs), kEmpty);
+
+  Distribution a;
+  a.DistributeRemainingToPlayer(clubs, 0, big);
+  EXPECT_FALSE(a.IsWide());
+
+  // Adding two narrow distributions whose sum needs 65 bits.
+  Distribution b(a);
+  b += a;
+  EXPECT_TRUE(b.IsWide());
+  EXPECT_EQ(big * 2, b.Count(CardFor(kTwo, kClubs), 0));
+
+  // Multiplying a narrow distribution by more than fits.
+  Distribution c(a);
+  c *= 6;
+  EXPECT_TRUE(c.IsWide());
+  EXPECT_EQ(big * 6, c.Count(CardFor(kTwo, kClubs), 0));
+
+  // Adding to a wide distribution carries into the high halves.
+  c += a;
+  EXPECT_EQ(big * 7, c.Count(CardFor(kTwo, kClubs), 0));
+  c += b;
+  EXPECT_EQ(big * 9, c.Count(CardFor(kTwo, kClubs), 0));
+
+  Distribution d;
+  d.DistributeRemainingToPlayer(clubs, 0, big * 9);
+  EXPECT_TRUE(d == c);
+  EXPECT_FALSE(d == b);
+}
+
+TEST(Distribution, distributeRemainingMatchesPerPlayerShares) {
+  // 52 unknown cards, 13 to each player: every player holds each card in a quarter of the deals,
+  // and a quarter of the possibilities needs more than 64 bits.
+  const CardHands hands = FourHands(kCardsPerHand);
+  const CardDeck all(CardHand::SuitMask(kClubs) | CardHand::SuitMask(kDiamonds)
+                   | CardHand::SuitMask(kSpades) | CardHand::SuitMask(kHearts), kEmpty);
+  const uint128_t possibles = possibleDistinguishableDeals();
+
+  Distribution distribution;
+  distribution.DistributeRemaining(all, possibles, hands);
+  EXPECT_TRUE(distribution.IsWide());
+  distribution.Validate(all, possibles);
+  for (Card c=0; c<kCardsPerDeck; ++c)
+    for (unsigned p=0; p<4; ++p)
+      ASSERT_EQ(possibles / 4, distribution.Count(c, p));
+
+  float prob[52][4];
+  distribution.AsProbabilities(prob);
+  double dprob[52][4];
+  distribution.AsProbabilities(dprob);
+  for (Card c=0; c<kCardsPerDeck; ++c) {
+    for (unsigned p=0; p<4; ++p) {
+      EXPECT_FLOAT_EQ(0.25, prob[c][p]);
+      EXPECT_DOUBLE_EQ(0.25, dprob[c][p]);
+    }
+  }
+}
+
+TEST(Distribution, asProbabilitiesOfUndealtCardsIsZero) {
+  Distribution distribution;
+  const CardDeck hearts(CardHand::SuitMask(kHearts), kEmpty);
+  distribution.DistributeRemainingToPlayer(hearts, 1, 30);
+  distribution.DistributeRemainingToPlayer(hearts, 3, 10);
+
+  double prob[52][4];
+  distribution.AsProbabilities(prob);
+  for (Card c=0; c<kCardsPerDeck; ++c) {
+    const bool dealt = hearts.HasCard(c);
+    EXPECT_EQ(0.0, prob[c][0]);
+    EXPECT_EQ(dealt ? 0.75 : 0.0, prob[c][1]);
+    EXPECT_EQ(0.0, prob[c][2]);
+    EXPECT_EQ(dealt ? 0.25 : 0.0, prob[c][3]);
+  }
+}
+
+TEST(Distribution, parallelAccumulateMatchesSerial) {
+  const unsigned kNumDeals = 1000;
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  std::vector<CardHands> deals(kNumDeals);
+  for (CardHands& hands : deals) {
+    hands = FourHands(kCardsPerHand);
+    CardDeck deck(CardHand::SuitMask(kClubs) | CardHand::SuitMask(kDiamonds)
+                | CardHand::SuitMask(kSpades) | CardHand::SuitMask(kHearts), kEmpty);
+    for (int p=0; p<4; ++p)
+      for (unsigned i=0; i<kCardsPerHand; ++i) {
+        const Card card = deck.aCardAtRandom(rng);
+        deck.RemoveCard(card);
+        hands[p].InsertCard(card);
+      }
+  }
+
+  Distribution serial;
+  for (const CardHands& hands : deals)
+    serial.CountOccurrences(hands);
+
+  for (unsigned numSlots : {1u, 2u, 4u}) {
+    Distribution parallel;
+    std::atomic<unsigned> calls(0);
+    Distribution::ParallelAccumulate(parallel, kNumDeals, numSlots, [&](unsigned i, Distribution& distribution) {
+      ++calls;
+      distribution.CountOccurrences(deals[i]);
+    });
+    EXPECT_EQ(kNumDeals, calls);
+    EXPECT_TRUE(serial == parallel);
+    parallel.Validate(CardDeck(~0ul >> 12, kEmpty), kNumDeals);
+  }
+}
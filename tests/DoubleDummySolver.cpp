@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+
+#include "lib/DoubleDummySolver.h"
+#include "lib/EndgameDoubleDummy.h"
+#include "lib/FastRollout.h"
+#include "lib/GameState.h"
+#include "lib/KnowableState.h"
+#include "lib/random.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// A plain paranoid minimax over every legal play, without the table, equivalent cards or any cutoffs.
+float ReferenceScore(const FastRollout& state, unsigned player)
+{
+  if (state.Done())
+    return state.Outcome().ZeroMeanStandardScore(player);
+
+  const bool maximize = state.CurrentPlayer() != player;
+  float best = maximize ? -100.0 : 100.0;
+  for (uint64_t choices = state.LegalPlays(); choices != 0; choices &= choices - 1) {
+    FastRollout next(state);
+    next.PlayCard(__builtin_ctzl(choices));
+    const float score = ReferenceScore(next, player);
+    best = maximize ? std::max(best, score) : std::min(best, score);
+  }
+  return best;
+}
+
+std::vector<GameState> Positions(unsigned numGames, unsigned numTricks)
+{
+  // Every position of the last numTricks tricks of random games.
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  std::vector<GameState> positions;
+  for (unsigned game = 0; game < numGames; ++game) {
+    GameState state;
+    while (!state.Done()) {
+      if (state.InEndgame(numTricks))
+        positions.push_back(state);
+      state.PlayCard(state.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+  return positions;
+}
+
+}  // namespace
+
+TEST(DoubleDummySolver, MatchesReference) {
+  DoubleDummySolver solver(16);
+  for (const GameState& state : Positions(30, 3)) {
+    const FastRollout fast(state);
+    for (unsigned p = 0; p < kNumPlayers; ++p)
+      EXPECT_EQ(ReferenceScore(fast, p), solver.Score(fast, p));
+  }
+}
+
+TEST(DoubleDummySolver, TableCollisions) {
+  // With a tiny table nearly every store replaces another position, which must not change any result.
+  DoubleDummySolver tiny(2);
+  DoubleDummySolver large(16);
+  for (const GameState& state : Positions(20, 5)) {
+    const FastRollout fast(state);
+    const unsigned player = state.CurrentPlayer();
+    EXPECT_EQ(large.Score(fast, player), tiny.Score(fast, player));
+  }
+}
+
+TEST(EndgameDoubleDummy, PlaysOutGames) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  const EndgameDoubleDummy player(2);
+  for (const GameState& start : Positions(3, 4)) {
+    if (start.PlayNumber() != kCardsPerDeck - 16)
+      continue;
+    GameState state(start);
+    while (!state.Done() && state.PointsPlayed() != kMaxPointsPerHand) {
+      const KnowableState knowable(state);
+      float expected[13];
+      const Card card = player.predictOutcomes(knowable, rng, expected);
+      ASSERT_TRUE(knowable.LegalPlays().HasCard(card));
+      for (unsigned i = 0; i < knowable.LegalPlays().Size(); ++i) {
+        EXPECT_GE(expected[i], -19.5);
+        EXPECT_LE(expected[i], 18.5);
+      }
+      state.PlayCard(card);
+    }
+  }
+}
@@ -0,0 +1,137 @@
+#include "gtest/gtest.h"
+
+#include "lib/EndgameSolver.h"
+#include "lib/FastRollout.h"
+#include "lib/GameState.h"
+#include "lib/TaskExecutor.h"
+#include "lib/random.h"
+
+#include <array>
+#include <vector>
+
+namespace {
+
+// A plain max^n search over every legal play, without the table or equivalent cards.
+// (GameOutcome has no copy constructor, so the outcome is assigned to an argument.)
+void ReferenceSolve(const FastRollout& state, GameOutcome& best, Card* bestPlay = 0)
+{
+  if (state.Done()) {
+    best = state.Outcome();
+    return;
+  }
+
+  const unsigned player = state.CurrentPlayer();
+  float bestScore = 0.0;
+  bool first = true;
+  for (uint64_t choices = state.LegalPlays(); choices != 0; choices &= choices - 1) {
+    const Card card = __builtin_ctzl(choices);
+    FastRollout next(state);
+    next.PlayCard(card);
+    GameOutcome outcome;
+    ReferenceSolve(next, outcome);
+    const float score = outcome.ZeroMeanStandardScore(player);
+    if (first || score < bestScore) {
+      best = outcome;
+      bestScore = score;
+      first = false;
+      if (bestPlay)
+        *bestPlay = card;
+    }
+  }
+}
+
+std::vector<GameState> EndgamePositions(unsigned numGames, unsigned numTricks)
+{
+  // Every position of the last numTricks tricks of random games, before all of the points have been taken.
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  std::vector<GameState> positions;
+  for (unsigned game = 0; game < numGames; ++game) {
+    GameState state;
+    while (!state.Done()) {
+      if (state.InEndgame(numTricks) && state.PointsPlayed() != kMaxPointsPerHand)
+        positions.push_back(state);
+      state.PlayCard(state.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+  return positions;
+}
+
+void ExpectSameOutcome(const GameOutcome& expected, const GameOutcome& actual)
+{
+  EXPECT_EQ(expected.shotTheMoon(), actual.shotTheMoon());
+  for (unsigned p = 0; p < kNumPlayers; ++p)
+    EXPECT_EQ(expected.PointsTaken(p), actual.PointsTaken(p));
+}
+
+std::array<unsigned, 4> PointsTaken(const GameOutcome& outcome)
+{
+  std::array<unsigned, 4> points;
+  for (unsigned p = 0; p < kNumPlayers; ++p)
+    points[p] = outcome.PointsTaken(p);
+  return points;
+}
+
+}  // namespace
+
+TEST(EndgameSolver, MatchesReference) {
+  EndgameSolver solver(16);
+  for (const GameState& state : EndgamePositions(100, 3)) {
+    const FastRollout fast(state);
+    Card expectedPlay = 0;
+    GameOutcome expected;
+    ReferenceSolve(fast, expected, &expectedPlay);
+    ExpectSameOutcome(expected, solver.Solve(fast));
+    EXPECT_EQ(expectedPlay, solver.BestPlay(fast));
+  }
+}
+
+TEST(EndgameSolver, TableCollisions) {
+  // With a tiny table nearly every store replaces another position, which must not change any result.
+  EndgameSolver tiny(2);
+  EndgameSolver large(16);
+  for (const GameState& state : EndgamePositions(50, 4)) {
+    const FastRollout fast(state);
+    ExpectSameOutcome(large.Solve(fast), tiny.Solve(fast));
+    EXPECT_EQ(large.BestPlay(fast), tiny.BestPlay(fast));
+  }
+}
+
+TEST(EndgameSolver, Hash) {
+  EndgameSolver solver(4);
+  const std::vector<GameState> positions = EndgamePositions(20, 4);
+  for (const GameState& state : positions) {
+    // Positions reached by different orders of play hash the same, and different positions almost never do.
+    EXPECT_EQ(solver.Hash(FastRollout(state)), solver.Hash(FastRollout(GameState(state))));
+  }
+  for (unsigned i = 1; i < positions.size(); ++i)
+    EXPECT_NE(solver.Hash(FastRollout(positions[i - 1])), solver.Hash(FastRollout(positions[i])));
+}
+
+TEST(EndgameSolver, SharedByThreads) {
+  const std::vector<GameState> positions = EndgamePositions(100, 4);
+  std::vector<std::array<unsigned, 4>> expected(positions.size());
+  EndgameSolver single(16);
+  for (unsigned i = 0; i < positions.size(); ++i)
+    expected[i] = PointsTaken(single.Solve(FastRollout(positions[i])));
+
+  EndgameSolver shared(10);
+  std::vector<std::array<unsigned, 4>> actual(positions.size());
+  TaskExecutor executor(4);
+  executor.ParallelFor(positions.size(), executor.MaxSlots(), [&](unsigned i, unsigned) {
+    actual[i] = PointsTaken(shared.Solve(FastRollout(positions[i])));
+  });
+  for (unsigned i = 0; i < positions.size(); ++i)
+    EXPECT_EQ(expected[i], actual[i]);
+}
+
+TEST(EndgameSolver, PlayOutGameMonteCarlo) {
+  // A rollout that switches to the solver ends with the solver's outcome, whatever the opponent strategy.
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  const StrategyPtr kNoStrategy;
+  for (const GameState& state : EndgamePositions(50, 3)) {
+    GameState game(state);
+    const GameOutcome outcome = game.PlayOutGameMonteCarlo(kNoStrategy, rng, 3);
+    EXPECT_TRUE(game.Done());
+    ExpectSameOutcome(EndgameSolver::Shared().Solve(FastRollout(state)), outcome);
+  }
+}
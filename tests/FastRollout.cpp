@@ -0,0 +1,133 @@
+#include "gtest/gtest.h"
+
+#include "lib/FastRollout.h"
+#include "lib/GameState.h"
+#include "lib/MultiRollout.h"
+#include "lib/random.h"
+
+// Plays random games with both GameState and FastRollout, checking that they agree on every step.
+TEST(FastRollout, MatchesGameState) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 200; ++game) {
+    GameState gameState;
+    FastRollout fast(gameState);
+
+    unsigned trickWins = 0;
+    gameState.TrackTrickWinner(&trickWins);
+    const unsigned firstPlayer = gameState.CurrentPlayer();
+
+    while (!gameState.Done()) {
+      ASSERT_EQ(gameState.CurrentPlayer(), fast.CurrentPlayer());
+      const CardHand choices = gameState.LegalPlays();
+      if (gameState.PointsPlayed() != kMaxPointsPerHand) {
+        ASSERT_EQ(choices.Bits(), fast.LegalPlays());
+      }
+
+      const Card card = choices.aCardAtRandom(rng);
+      gameState.PlayCard(card);
+      fast.PlayCard(card);
+
+      // A FastRollout constructed mid game agrees with the one that played the whole game.
+      if (!gameState.Done()) {
+        FastRollout copy(gameState);
+        ASSERT_EQ(fast.LegalPlays(), copy.LegalPlays());
+      }
+    }
+    EXPECT_TRUE(fast.Done());
+    EXPECT_EQ(trickWins, fast.FirstTrickWinner() == int(firstPlayer) ? 1u : 0u);
+
+    const GameOutcome expected = gameState.CheckForShootTheMoon();
+    const GameOutcome actual = fast.PlayOutRandomly(rng);
+    EXPECT_EQ(expected.shotTheMoon(), actual.shotTheMoon());
+    for (unsigned p = 0; p < kNumPlayers; ++p)
+      EXPECT_EQ(expected.PointsTaken(p), actual.PointsTaken(p));
+  }
+}
+
+TEST(FastRollout, PlayOutRandomly) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 200; ++game) {
+    GameState gameState;
+    const unsigned numPlays = rng.range64(kCardsPerDeck);
+    for (unsigned i = 0; i < numPlays; ++i)
+      gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+
+    FastRollout fast(gameState);
+    const GameOutcome outcome = fast.PlayOutRandomly(rng);
+
+    unsigned total = 0;
+    for (unsigned p = 0; p < kNumPlayers; ++p) {
+      EXPECT_GE(outcome.PointsTaken(p), gameState.GetScoreFor(p));
+      total += outcome.PointsTaken(p);
+    }
+    EXPECT_EQ(kMaxPointsPerHand, total);
+    if (gameState.PointsPlayed() != kMaxPointsPerHand) {
+      EXPECT_GE(fast.FirstTrickWinner(), 0);
+    }
+  }
+}
+
+// Plays games from many different positions at the same play number in one MultiRollout.
+TEST(FastRollout, MultiRollout) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (unsigned numPlays = 0; numPlays < kCardsPerDeck; numPlays += 3) {
+    std::vector<GameState> games(2 * MultiRollout::kLanes + 1);
+    MultiRollout multi;
+    for (GameState& gameState : games) {
+      for (unsigned i = 0; i < numPlays; ++i)
+        gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+      multi.Add(FastRollout(gameState), rng.random64());
+    }
+    ASSERT_EQ(games.size(), multi.Size());
+    multi.PlayOutRandomly();
+
+    for (unsigned g = 0; g < games.size(); ++g) {
+      const GameState& gameState = games[g];
+      const GameOutcome outcome = multi.Outcome(g);
+      unsigned total = 0;
+      for (unsigned p = 0; p < kNumPlayers; ++p) {
+        EXPECT_GE(outcome.PointsTaken(p), gameState.GetScoreFor(p));
+        total += outcome.PointsTaken(p);
+      }
+      EXPECT_EQ(kMaxPointsPerHand, total);
+      if (gameState.PointsPlayed() != kMaxPointsPerHand) {
+        EXPECT_GE(multi.FirstTrickWinner(g), 0);
+      }
+
+      // In the last trick there is only one way to play out the game.
+      if (numPlays >= kCardsPerDeck - kNumPlayers) {
+        FastRollout fast(gameState);
+        const GameOutcome expected = fast.PlayOutRandomly(rng);
+        EXPECT_EQ(expected.shotTheMoon(), outcome.shotTheMoon());
+        for (unsigned p = 0; p < kNumPlayers; ++p)
+          EXPECT_EQ(expected.PointsTaken(p), outcome.PointsTaken(p));
+        EXPECT_EQ(fast.FirstTrickWinner(), multi.FirstTrickWinner(g));
+      }
+    }
+  }
+}
+
+// Games added with the same seed make the same random choices.
+TEST(FastRollout, MultiRolloutSeeds) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 20; ++game) {
+    GameState gameState;
+    const FastRollout fast(gameState);
+    const uint64_t seed = rng.random64();
+
+    MultiRollout multi;
+    for (unsigned i = 0; i < MultiRollout::kLanes + 1; ++i)
+      multi.Add(fast, seed);
+    multi.PlayOutRandomly();
+
+    for (unsigned i = 1; i < multi.Size(); ++i) {
+      for (unsigned p = 0; p < kNumPlayers; ++p)
+        EXPECT_EQ(multi.Outcome(0).PointsTaken(p), multi.Outcome(i).PointsTaken(p));
+      EXPECT_EQ(multi.FirstTrickWinner(0), multi.FirstTrickWinner(i));
+    }
+  }
+}
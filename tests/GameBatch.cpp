@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+
+#include "lib/Deal.h"
+#include "lib/GameBatch.h"
+#include "lib/GameState.h"
+#include "lib/KnowableState.h"
+#include "lib/random.h"
+
+#include <vector>
+
+namespace {
+
+std::vector<uint64_t> RandomDealIndexes(unsigned numDeals)
+{
+  std::vector<uint64_t> indexes;
+  for (unsigned i = 0; i < numDeals; ++i) {
+    const uint128_t index = Deal::RandomDealIndex();
+    indexes.push_back(uint64_t(index));
+    indexes.push_back(uint64_t(index >> 64));
+  }
+  return indexes;
+}
+
+// The game states at every play of random games, starting from the given deals.
+std::vector<PackedGameState> PlayOut(const std::vector<PackedGameState>& deals)
+{
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  std::vector<PackedGameState> states;
+  for (const PackedGameState& deal : deals) {
+    GameState gameState(deal);
+    while (!gameState.Done()) {
+      states.emplace_back(gameState);
+      gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+  return states;
+}
+
+}  // namespace
+
+TEST(GameBatch, DealBatch) {
+  const unsigned kNumDeals = 200;
+  const std::vector<uint64_t> indexes = RandomDealIndexes(kNumDeals);
+  std::vector<PackedGameState> states(kNumDeals);
+  DealBatch(indexes.data(), kNumDeals, states.data());
+
+  for (unsigned i = 0; i < kNumDeals; ++i) {
+    const uint128_t index = (uint128_t(indexes[2*i + 1]) << 64) | indexes[2*i];
+    ASSERT_EQ(PackedGameState(GameState(Deal(index))), states[i]) << "deal " << i;
+  }
+}
+
+// Every rollout ends the game, so the points taken always total 26, and the results depend only on the seed.
+TEST(GameBatch, RolloutBatch) {
+  std::vector<PackedGameState> deals(5);
+  DealBatch(RandomDealIndexes(deals.size()).data(), deals.size(), deals.data());
+  const std::vector<PackedGameState> states = PlayOut(deals);
+
+  std::vector<float> points(4 * states.size());
+  RolloutBatch(states.data(), states.size(), 10, 42, points.data());
+  for (unsigned i = 0; i < states.size(); ++i) {
+    const float total = points[4*i] + points[4*i + 1] + points[4*i + 2] + points[4*i + 3];
+    ASSERT_NEAR(26.0f, total, 1e-4) << "state " << i;
+  }
+
+  std::vector<float> again(points.size());
+  RolloutBatch(states.data(), states.size(), 10, 42, again.data());
+  EXPECT_EQ(points, again);
+}
+
+// Each sampled deal agrees with everything the current player knows.
+TEST(GameBatch, SampleDealBatch) {
+  std::vector<PackedGameState> deals(3);
+  DealBatch(RandomDealIndexes(deals.size()).data(), deals.size(), deals.data());
+  std::vector<PackedKnowableState> states;
+  for (const PackedGameState& state : PlayOut(deals))
+    states.emplace_back(KnowableState(GameState(state)));
+
+  const unsigned kSamplesPerState = 4;
+  std::vector<PackedGameState> samples(states.size() * kSamplesPerState);
+  SampleDealBatch(states.data(), states.size(), kSamplesPerState, 7, samples.data());
+  for (unsigned i = 0; i < samples.size(); ++i) {
+    const PackedGameState& sample = samples[i];
+    uint64_t dealt = 0;
+    for (unsigned p = 0; p < 4; ++p) {
+      ASSERT_EQ(0u, dealt & sample.mHands[p]) << "sample " << i;
+      dealt |= sample.mHands[p];
+    }
+    ASSERT_EQ(states[i / kSamplesPerState], PackedKnowableState(KnowableState(GameState(sample)))) << "sample " << i;
+  }
+
+  std::vector<PackedGameState> again(samples.size());
+  SampleDealBatch(states.data(), states.size(), kSamplesPerState, 7, again.data());
+  for (unsigned i = 0; i < samples.size(); ++i)
+    ASSERT_EQ(samples[i], again[i]);
+}
@@ -1,7 +1,15 @@
 #include "gtest/gtest.h"
 
 #include "lib/KnowableState.h"
+#include "lib/DealSampler.h"
+#include "lib/Distribution.h"
 #include "lib/GameState.h"
+#include "lib/random.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <string.h>
 
 TEST(KnowableState, nominal) {
   GameState gameState;
@@ -13,3 +21,247 @@ TEST(KnowableState, HypotheticalState) {
   KnowableState knowableState(gameState);
   GameState derived = knowableState.HypotheticalState();
 }
+
+namespace {
+
+const unsigned kFeatures = KnowableState::kNumFeaturesPerCard;
+
+// The features of each card, worked out card by card from the public accessors as the encoder did before it
+// wrote rows directly, so that EncodeFeatures() is checked against an independent implementation.
+void ReferenceFeatures(const KnowableState& state, bool exactProbabilities, float features[kCardsPerDeck][kFeatures])
+{
+  const unsigned current = state.CurrentPlayer();
+  const CardHand legal = state.LegalPlays();
+  float prob[kCardsPerDeck][kNumPlayers];
+  if (exactProbabilities)
+    state.ExactProbabilities(prob);
+  else
+    state.AsProbabilities(prob);
+
+  // Nobody can shoot the moon once the points are split. Before any are taken anybody can, and after that only
+  // the player who has taken them all.
+  const unsigned pointsPlayed = state.PointsPlayed();
+  const bool split = state.PointsSplit();
+  const bool currentCanShoot = !split && pointsPlayed > 0 && state.GetScoreFor(current) == pointsPlayed;
+  const bool leading = state.PlayInTrick() == 0;
+  const bool pointsOnTable = state.PointsOnTable() > 0;
+  const Card kNoPlay = kCardsPerDeck;
+  Card shooterPlay = kNoPlay;
+  for (unsigned i = 0; i < state.PlayInTrick(); ++i) {
+    if (state.GetScoreFor((state.PlayerLeadingTrick() + i) % kNumPlayers) != 0)
+      shooterPlay = state.GetTrickPlay(i);
+  }
+
+  for (Card card = 0; card < kCardsPerDeck; ++card) {
+    float* f = features[card];
+    std::fill(f, f + kFeatures, 0.0f);
+    f[eLegalPlay] = legal.HasCard(card);
+    for (unsigned p = 0; p < kNumPlayers; ++p)
+      f[eCardProbPlayer0 + p] = prob[card][(current + p) % kNumPlayers];
+    if (state.UnplayedCards().HasCard(card) || state.IsCardOnTable(card))
+      f[eCardPoints] = float(PointsFor(card)) / 26.0;
+    f[eCardOnTable] = state.IsCardOnTable(card);
+    f[eCardIsHighCardInTrick] = !leading && card == state.HighCardOnTable();
+
+    if (!legal.HasCard(card) || split)
+      continue;
+    const bool points = PointsFor(card) > 0;
+    const bool will = state.WillCardTakeTrick(card);
+    const bool might = state.MightCardTakeTrick(card);
+    bool player = false;
+    bool other = false;
+    if (pointsPlayed == 0) {
+      if (leading) {
+        player = !points || will;
+        other = !points || !will;
+      } else if (pointsOnTable) {
+        player = might;
+        other = !will;
+      } else if (!points) {
+        player = other = true;
+      } else if (SuitOf(card) != kHearts && state.TrickSuit() == kSpades) {
+        // The queen of spades, following in spades.
+        player = might;
+        other = !will;
+      } else {
+        // A heart, or the queen of spades, sluffed.
+        other = true;
+      }
+    } else if (currentCanShoot) {
+      player = leading ? (!points || will) : pointsOnTable ? might : !points;
+    } else if (leading) {
+      other = !will;
+    } else if (!pointsOnTable) {
+      other = !points || shooterPlay == kNoPlay || !might;
+    } else if (shooterPlay != kNoPlay) {
+      other = shooterPlay == state.HighCardOnTable() && !might;
+    } else {
+      other = !will;
+    }
+    f[ePlayerNotRuledOutForMoon] = player;
+    f[eOtherNotRuledOutForMoon] = other;
+  }
+}
+
+}  // namespace
+
+TEST(KnowableState, EncodeFeatures) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 20; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      KnowableState knowableState(gameState);
+
+      for (bool exact : {false, true}) {
+        // Every float of the row must be written, so start with garbage.
+        float row[KnowableState::kNumFeatures];
+        std::fill(row, row + KnowableState::kNumFeatures, -1.0f);
+        knowableState.EncodeFeatures(row, exact);
+
+        float expected[kCardsPerDeck][kFeatures];
+        ReferenceFeatures(knowableState, exact, expected);
+        for (Card card = 0; card < kCardsPerDeck; ++card) {
+          for (unsigned column = 0; column < kFeatures; ++column) {
+            ASSERT_EQ(expected[card][column], row[card * kFeatures + column])
+                << "card " << NameOf(card) << " column " << column << (exact ? " (exact)" : "");
+          }
+        }
+      }
+
+      gameState.PlayCard(knowableState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+}
+
+TEST(KnowableState, AnalyzerCache) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 20; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      KnowableState knowableState(gameState);
+
+      // The same constraints give the same tree, with the same counts as a tree built from scratch.
+      const PossibilityAnalyzerPtr analyzer = knowableState.Analyze();
+      EXPECT_EQ(analyzer, knowableState.Analyze());
+      EXPECT_GT(AnalyzerCacheSize(), 0u);
+
+      ClearAnalyzerCache();
+      const PossibilityAnalyzerPtr rebuilt = knowableState.Analyze();
+      EXPECT_NE(analyzer, rebuilt);
+      ASSERT_TRUE(analyzer->Possibilities() == rebuilt->Possibilities());
+
+      const uint128_t last = analyzer->Possibilities() - 1;
+      for (uint128_t index : {uint128_t(0), last / 2, last}) {
+        CardHands hands, rebuiltHands;
+        knowableState.PrepareHands(hands);
+        knowableState.PrepareHands(rebuiltHands);
+        analyzer->ActualizePossibility(index, hands);
+        rebuilt->ActualizePossibility(index, rebuiltHands);
+        for (unsigned p = 0; p < kNumPlayers; ++p)
+          EXPECT_EQ(hands[p].Bits(), rebuiltHands[p].Bits());
+      }
+
+      gameState.PlayCard(knowableState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+}
+
+TEST(KnowableState, DealSampler) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  unsigned numChecked = 0;
+  for (int game = 0; game < 50; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      KnowableState knowableState(gameState);
+      const PossibilityAnalyzerPtr analyzer = knowableState.Analyze();
+      const uint128_t kPossibilities = analyzer->Possibilities();
+      const DealSampler sampler(*analyzer);
+
+      // Enumerate the possibilities of the smaller trees, and check that sampling draws each of them about
+      // equally often, and nothing else.
+      if (kPossibilities <= 50) {
+        typedef std::array<uint64_t, kNumPlayers> DealBits;
+        std::map<DealBits, unsigned> counts;
+        for (uint128_t i = 0; i < kPossibilities; ++i) {
+          CardHands hands;
+          knowableState.PrepareHands(hands);
+          analyzer->ActualizePossibility(i, hands);
+          counts[DealBits{hands[0].Bits(), hands[1].Bits(), hands[2].Bits(), hands[3].Bits()}] = 0;
+        }
+        ASSERT_EQ(kPossibilities, counts.size());
+
+        const unsigned kSamplesPerPossibility = 400;
+        for (unsigned i = 0; i < kPossibilities * kSamplesPerPossibility; ++i) {
+          CardHands hands;
+          knowableState.PrepareHands(hands);
+          sampler.Sample(rng, hands);
+          knowableState.IsVoidBits().VerifyVoids(hands);
+          auto it = counts.find(DealBits{hands[0].Bits(), hands[1].Bits(), hands[2].Bits(), hands[3].Bits()});
+          ASSERT_TRUE(it != counts.end());
+          ++it->second;
+        }
+        for (const auto& count : counts) {
+          EXPECT_GT(count.second, kSamplesPerPossibility / 2);
+          EXPECT_LT(count.second, kSamplesPerPossibility * 3 / 2);
+        }
+        ++numChecked;
+      } else {
+        CardHands hands;
+        knowableState.PrepareHands(hands);
+        sampler.Sample(rng, hands);
+        for (unsigned p = 0; p < kNumPlayers; ++p)
+          EXPECT_EQ(0u, hands[p].AvailableCapacity());
+        GameState hypothetical(hands, knowableState);
+      }
+
+      gameState.PlayCard(knowableState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+  EXPECT_GT(numChecked, 0u);
+}
+
+TEST(KnowableState, ExactProbabilities) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 20; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      KnowableState knowableState(gameState);
+
+      // The exact counts of every possibility, as WriteDataAnnotator computes them.
+      const PossibilityAnalyzerPtr analyzer = knowableState.Analyze();
+      Distribution distribution;
+      CardHands hands;
+      knowableState.PrepareHands(hands);
+      analyzer->ExpectedDistribution(distribution, hands);
+      distribution.DistributeRemainingToPlayer(knowableState.CurrentPlayersHand(), knowableState.CurrentPlayer()
+                                             , analyzer->Possibilities());
+      float expected[kCardsPerDeck][kNumPlayers];
+      distribution.AsProbabilities(expected);
+
+      float prob[kCardsPerDeck][kNumPlayers];
+      knowableState.ExactProbabilities(prob);
+
+      float row[KnowableState::kNumFeatures];
+      knowableState.EncodeFeatures(row, true);
+
+      const unsigned current = knowableState.CurrentPlayer();
+      for (Card card = 0; card < kCardsPerDeck; ++card) {
+        float sum = 0.0;
+        for (unsigned p = 0; p < kNumPlayers; ++p) {
+          ASSERT_NEAR(expected[card][p], prob[card][p], 1e-5);
+          EXPECT_EQ(prob[card][(current + p) % 4], row[card * KnowableState::kNumFeaturesPerCard + eCardProbPlayer0 + p]);
+          sum += prob[card][p];
+        }
+        if (knowableState.UnplayedCards().HasCard(card)) {
+          EXPECT_NEAR(1.0, sum, 1e-5);
+        }
+      }
+
+      gameState.PlayCard(knowableState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+}
@@ -0,0 +1,140 @@
+#include "gtest/gtest.h"
+
+#include "lib/FastRollout.h"
+#include "lib/GameState.h"
+#include "lib/PackedGameState.h"
+#include "lib/random.h"
+
+#include <string.h>
+
+namespace {
+
+void ExpectSameState(const GameState& expected, const GameState& actual)
+{
+  ASSERT_EQ(expected.PlayNumber(), actual.PlayNumber());
+  ASSERT_EQ(expected.PlayerLeadingTrick(), actual.PlayerLeadingTrick());
+  ASSERT_EQ(expected.CurrentPlayer(), actual.CurrentPlayer());
+  ASSERT_EQ(expected.PointsPlayed(), actual.PointsPlayed());
+  ASSERT_EQ(expected.IsVoidBits().Bits(), actual.IsVoidBits().Bits());
+  ASSERT_EQ(expected.UnplayedCards().Bits(), actual.UnplayedCards().Bits());
+  for (unsigned p = 0; p < kNumPlayers; ++p) {
+    ASSERT_EQ(expected.HandForPlayer(p).Bits(), actual.HandForPlayer(p).Bits());
+    ASSERT_EQ(expected.GetScoreFor(p), actual.GetScoreFor(p));
+    ASSERT_EQ(expected.GetPointTricksFor(p), actual.GetPointTricksFor(p));
+  }
+  for (unsigned i = 0; i < expected.PlayInTrick(); ++i)
+    ASSERT_EQ(expected.GetTrickPlay(i), actual.GetTrickPlay(i));
+  if (!expected.Done()) {
+    ASSERT_EQ(expected.TrickSuit(), actual.TrickSuit());
+    ASSERT_EQ(expected.LegalPlays().Bits(), actual.LegalPlays().Bits());
+  }
+}
+
+}  // namespace
+
+// Packs and unpacks the state at every play of random games.
+TEST(PackedGameState, RoundTrip) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 200; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      const PackedGameState packed(gameState);
+      EXPECT_EQ(gameState.PlayNumber(), packed.PlayNumber());
+      EXPECT_EQ(gameState.CurrentPlayer(), packed.CurrentPlayer());
+
+      const GameState unpacked(packed);
+      ExpectSameState(gameState, unpacked);
+      EXPECT_EQ(packed, PackedGameState(unpacked));
+
+      // A copy made with memcpy is as good as the original.
+      PackedGameState copy;
+      memcpy(&copy, &packed, sizeof(copy));
+      EXPECT_EQ(packed, copy);
+
+      // A FastRollout made from the packed state agrees with one made from the game state.
+      FastRollout fast(gameState);
+      FastRollout fastFromPacked(packed);
+      EXPECT_EQ(fast.CurrentPlayer(), fastFromPacked.CurrentPlayer());
+      EXPECT_EQ(fast.LegalPlays(), fastFromPacked.LegalPlays());
+
+      const Card card = gameState.LegalPlays().aCardAtRandom(rng);
+      fast.PlayCard(card);
+      fastFromPacked.PlayCard(card);
+      EXPECT_EQ(fast.FirstTrickWinner(), fastFromPacked.FirstTrickWinner());
+
+      gameState.PlayCard(card);
+    }
+    EXPECT_TRUE(PackedGameState(gameState).Done());
+  }
+}
+
+// Games continued from an unpacked state have the same outcome as the original game.
+TEST(PackedGameState, PlayOutUnpacked) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 200; ++game) {
+    GameState gameState;
+    const unsigned numPlays = rng.range64(kCardsPerDeck);
+    for (unsigned i = 0; i < numPlays; ++i)
+      gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+
+    GameState unpacked{PackedGameState(gameState)};
+    while (!gameState.Done()) {
+      const Card card = gameState.LegalPlays().aCardAtRandom(rng);
+      gameState.PlayCard(card);
+      unpacked.PlayCard(card);
+    }
+
+    const GameOutcome expected = gameState.CheckForShootTheMoon();
+    const GameOutcome actual = unpacked.CheckForShootTheMoon();
+    EXPECT_EQ(expected.shotTheMoon(), actual.shotTheMoon());
+    for (unsigned p = 0; p < kNumPlayers; ++p)
+      EXPECT_EQ(expected.PointsTaken(p), actual.PointsTaken(p));
+  }
+}
+
+// The states of real games are valid, and breaking any one invariant makes them invalid.
+TEST(PackedGameState, IsValid) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 20; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      const PackedGameState packed(gameState);
+      ASSERT_TRUE(packed.IsValid());
+
+      PackedGameState broken = packed;
+      broken.mLead = 4;
+      EXPECT_FALSE(broken.IsValid());
+
+      broken = packed;
+      broken.mNextPlay = kCardsPerDeck;
+      EXPECT_FALSE(broken.IsValid());
+
+      // A card in two hands.
+      broken = packed;
+      const unsigned current = packed.CurrentPlayer();
+      broken.mHands[(current + 1) % 4] |= IsolateLeastBit(packed.mHands[current]);
+      EXPECT_FALSE(broken.IsValid());
+
+      // A card moved from one hand to another.
+      broken = packed;
+      const uint64_t card = IsolateLeastBit(packed.mHands[current]);
+      broken.mHands[current] &= ~card;
+      broken.mHands[(current + 1) % 4] |= card;
+      EXPECT_FALSE(broken.IsValid());
+
+      broken = packed;
+      broken.mScore[game % 4] += 1;
+      EXPECT_FALSE(broken.IsValid());
+
+      // Void in a suit the player holds.
+      broken = packed;
+      broken.mVoidBits |= 1u << (4*SuitOf(Card(LeastSetBitIndex(card))) + current);
+      EXPECT_FALSE(broken.IsValid());
+
+      gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+}
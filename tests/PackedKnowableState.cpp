@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+
+#include "lib/FeatureBatch.h"
+#include "lib/GameState.h"
+#include "lib/KnowableState.h"
+#include "lib/PackedKnowableState.h"
+#include "lib/random.h"
+
+#include <string.h>
+#include <vector>
+
+namespace {
+
+std::vector<PackedKnowableState> RandomStates(unsigned numGames)
+{
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+  std::vector<PackedKnowableState> states;
+  for (unsigned game = 0; game < numGames; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      states.emplace_back(KnowableState(gameState));
+      gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+  return states;
+}
+
+}  // namespace
+
+// Packs and unpacks the knowable state at every play of random games.
+TEST(PackedKnowableState, RoundTrip) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 200; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      const KnowableState state(gameState);
+      const PackedKnowableState packed(state);
+      EXPECT_EQ(state.PlayNumber(), packed.PlayNumber());
+      EXPECT_EQ(state.CurrentPlayer(), packed.CurrentPlayer());
+
+      const KnowableState unpacked(packed);
+      ASSERT_EQ(state.CurrentPlayersHand().Bits(), unpacked.CurrentPlayersHand().Bits());
+      ASSERT_EQ(state.UnplayedCards().Bits(), unpacked.UnplayedCards().Bits());
+      ASSERT_EQ(state.PointsPlayed(), unpacked.PointsPlayed());
+      ASSERT_EQ(state.IsVoidBits().Bits(), unpacked.IsVoidBits().Bits());
+      ASSERT_EQ(state.LegalPlays().Bits(), unpacked.LegalPlays().Bits());
+      EXPECT_EQ(packed, PackedKnowableState(unpacked));
+
+      float expected[KnowableState::kNumFeatures];
+      float actual[KnowableState::kNumFeatures];
+      state.EncodeFeatures(expected);
+      unpacked.EncodeFeatures(actual);
+      ASSERT_EQ(0, memcmp(expected, actual, sizeof(expected)));
+
+      gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+}
+
+// The batch is encoded in parallel, but each row is the features of its own state.
+TEST(PackedKnowableState, EncodeFeatureBatch) {
+  const std::vector<PackedKnowableState> states = RandomStates(20);
+  for (bool exact : {false, true}) {
+    std::vector<float> rows(states.size() * KnowableState::kNumFeatures);
+    EncodeFeatureBatch(states.data(), states.size(), rows.data(), exact);
+
+    float expected[KnowableState::kNumFeatures];
+    for (unsigned i = 0; i < states.size(); ++i) {
+      KnowableState(states[i]).EncodeFeatures(expected, exact);
+      ASSERT_EQ(0, memcmp(expected, &rows[i * KnowableState::kNumFeatures], sizeof(expected))) << "state " << i;
+    }
+  }
+}
+
+// The knowable states of real games are valid, and breaking any one invariant makes them invalid.
+TEST(PackedKnowableState, IsValid) {
+  const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+
+  for (int game = 0; game < 20; ++game) {
+    GameState gameState;
+    while (!gameState.Done()) {
+      const PackedKnowableState packed{KnowableState(gameState)};
+      ASSERT_TRUE(packed.IsValid());
+
+      PackedKnowableState broken = packed;
+      broken.mLead = 4;
+      EXPECT_FALSE(broken.IsValid());
+
+      // A card in the hand that was played.
+      const uint64_t played = ~packed.mUnplayed & kAllCardsMask;
+      if (played != 0) {
+        broken = packed;
+        broken.mHand |= IsolateLeastBit(played);
+        EXPECT_FALSE(broken.IsValid());
+      }
+
+      broken = packed;
+      broken.mScore[game % 4] += 1;
+      EXPECT_FALSE(broken.IsValid());
+
+      // All three other players void in a suit with unknown cards: there is no possible deal.
+      const uint64_t unknown = packed.mUnplayed & ~packed.mHand;
+      if (unknown != 0) {
+        broken = packed;
+        const Suit suit = SuitOf(Card(LeastSetBitIndex(unknown)));
+        for (unsigned p = 0; p < 4; ++p) {
+          if (p != packed.CurrentPlayer())
+            broken.mVoidBits |= 1u << (4*suit + p);
+        }
+        EXPECT_FALSE(broken.IsValid());
+      }
+
+      gameState.PlayCard(gameState.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+}
@@ -0,0 +1,136 @@
+#include "gtest/gtest.h"
+
+#include "lib/KnowableState.h"
+#include "lib/Predictor.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const unsigned kNumFeatures = KnowableState::kNumFeatures;
+
+// A backend whose outputs for a row are computed from the row's first feature, so each caller can check that it
+// got its own rows back.
+class TaggingBackend : public InferenceBackend
+{
+public:
+  virtual void Run(const float* mainData, unsigned numRows, float* expectedScore, float* moonProbs) const
+  {
+    ++mNumRuns;
+    mNumRows += numRows;
+    for (unsigned r = 0; r < numRows; ++r) {
+      const float tag = mainData[r * kNumFeatures];
+      for (unsigned c = 0; c < kScoresPerRow; ++c)
+        expectedScore[r * kScoresPerRow + c] = tag + c;
+      for (unsigned c = 0; c < kMoonProbsPerRow; ++c)
+        moonProbs[r * kMoonProbsPerRow + c] = -tag - c;
+    }
+  }
+
+  mutable std::atomic<unsigned> mNumRuns{0};
+  mutable std::atomic<unsigned> mNumRows{0};
+};
+
+// Predicts numRows rows tagged with first, first+1, ..., and checks the outputs.
+void PredictAndCheck(const Predictor& predictor, float first, unsigned numRows)
+{
+  std::vector<float> input(numRows * kNumFeatures, 0.0f);
+  for (unsigned r = 0; r < numRows; ++r)
+    input[r * kNumFeatures] = first + r;
+  std::vector<float> score(numRows * kScoresPerRow);
+  std::vector<float> moon(numRows * kMoonProbsPerRow);
+  predictor.Predict(input.data(), numRows, score.data(), moon.data());
+
+  for (unsigned r = 0; r < numRows; ++r) {
+    ASSERT_EQ(first + r, score[r * kScoresPerRow]) << "row " << r;
+    ASSERT_EQ(first + r + kScoresPerRow - 1, score[r * kScoresPerRow + kScoresPerRow - 1]) << "row " << r;
+    ASSERT_EQ(-(first + r) - (kMoonProbsPerRow - 1), moon[r * kMoonProbsPerRow + kMoonProbsPerRow - 1]) << "row " << r;
+  }
+}
+
+}  // namespace
+
+// Requests from several threads are batched together, including requests split across batches, and each caller
+// gets its own rows back.
+TEST(PooledPredictor, EachCallerGetsItsOwnRows) {
+  const auto backend = std::make_shared<TaggingBackend>();
+  const unsigned kThreads = 8;
+  const unsigned kRequestsPerThread = 50;
+  unsigned expectedRows = 0;
+  for (unsigned t = 0; t < kThreads; ++t)
+    for (unsigned i = 0; i < kRequestsPerThread; ++i)
+      expectedRows += 1 + (t * 37 + i * 11) % 100;
+  {
+    PooledPredictor predictor(backend, 64, 500);
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&predictor, t]() {
+        for (unsigned i = 0; i < kRequestsPerThread; ++i) {
+          // Up to 100 rows, so some requests are larger than a batch.
+          const unsigned numRows = 1 + (t * 37 + i * 11) % 100;
+          PredictAndCheck(predictor, float(t * 100000 + i * 100), numRows);
+        }
+      });
+    }
+    for (std::thread& thread : threads)
+      thread.join();
+
+    // Every row was run once. The batch counters are updated after the callers are released, so they may lag.
+    EXPECT_EQ(kThreads * kRequestsPerThread, predictor.GetCounters().requests);
+    EXPECT_EQ(expectedRows, backend->mNumRows.load());
+  }
+}
+
+// An empty request returns at once, without running the backend.
+TEST(PooledPredictor, EmptyRequest) {
+  const auto backend = std::make_shared<TaggingBackend>();
+  {
+    PooledPredictor predictor(backend, 64, 500);
+    PredictAndCheck(predictor, 1.0f, 0);
+    PredictAndCheck(predictor, 1.0f, 5);
+  }
+  EXPECT_EQ(1u, backend->mNumRuns.load());
+  EXPECT_EQ(5u, backend->mNumRows.load());
+}
+
+// A submission that fills the batch wakes the batching thread from its wait for more requests.
+TEST(PooledPredictor, FullBatchRunsAtOnce) {
+  const auto backend = std::make_shared<TaggingBackend>();
+  const unsigned kTenSeconds = 10 * 1000 * 1000;
+  PooledPredictor predictor(backend, 4, kTenSeconds);
+
+  std::thread first([&]() { PredictAndCheck(predictor, 1.0f, 2); });
+  while (predictor.GetCounters().requests == 0)
+    usleep(1000);
+  usleep(10 * 1000);
+  PredictAndCheck(predictor, 3.0f, 2);
+  first.join();
+  EXPECT_EQ(1u, backend->mNumRuns.load());
+}
+
+// A partial batch waits for more requests for up to maxWaitMicros, but shutting down runs it at once.
+TEST(PooledPredictor, FlushesOnShutdown) {
+  const auto backend = std::make_shared<TaggingBackend>();
+  const unsigned kTenSeconds = 10 * 1000 * 1000;
+  std::unique_ptr<PooledPredictor> predictor(new PooledPredictor(backend, 1024, kTenSeconds));
+
+  std::atomic<bool> done(false);
+  std::thread caller([&]() {
+    PredictAndCheck(*predictor, 7.0f, 3);
+    done = true;
+  });
+  while (predictor->GetCounters().requests == 0)
+    usleep(1000);
+  usleep(50 * 1000);
+  EXPECT_FALSE(done);
+  EXPECT_EQ(0u, backend->mNumRuns.load());
+
+  predictor.reset();
+  caller.join();
+  EXPECT_TRUE(done);
+  EXPECT_EQ(1u, backend->mNumRuns.load());
+}
@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+
+#include "lib/IoThread.h"
+#include "lib/RecordFile.h"
+
+#include <fstream>
+#include <stdexcept>
+#include <stdlib.h>
+
+namespace {
+
+std::string TempPath(const char* name)
+{
+  char path[] = "/tmp/RecordFileXXXXXX";
+  EXPECT_TRUE(mkdtemp(path) != 0);
+  return std::string(path) + "/" + name;
+}
+
+const RecordSchema kSchema = {
+  {"main", {52, 10}},
+  {"score", {52}},
+  {"moon", {52, 3}},
+  {"flags", {52}, kUint8},
+};
+
+}  // namespace
+
+TEST(RecordFile, descrRoundTrips) {
+  const std::string descr = RecordFile::Descr(kSchema);
+  EXPECT_EQ("[('main', '<f4', (52, 10)), ('score', '<f4', (52,)), ('moon', '<f4', (52, 3)), ('flags', '|u1', (52,))]"
+          , descr);
+
+  const RecordSchema schema = RecordFile::ParseDescr(descr);
+  ASSERT_EQ(kSchema.size(), schema.size());
+  for (unsigned i = 0; i < schema.size(); ++i) {
+    EXPECT_EQ(kSchema[i].mName, schema[i].mName);
+    EXPECT_EQ(kSchema[i].mShape, schema[i].mShape);
+    EXPECT_EQ(kSchema[i].mType, schema[i].mType);
+  }
+
+  EXPECT_TRUE(RecordFile::ParseDescr("").empty());
+  EXPECT_TRUE(RecordFile::ParseDescr("[('main', '<f8', (52,))]").empty());
+  EXPECT_TRUE(RecordFile::ParseDescr("[('main', '<f4', (52,))").empty());
+}
+
+TEST(RecordFile, readsWhatWasWritten) {
+  // Enough records for several blocks, with and without an index.
+  const unsigned kStride = (52*10 + 52 + 52*3) * sizeof(float) + 52;
+  const unsigned kNumRecords = 3 * BlockWriter::kBlockBytes / kStride + 5;
+
+  for (bool withIndex : {false, true}) {
+    const std::string path = TempPath("records.hrec");
+    {
+      RecordWriter writer(path, kSchema, withIndex);
+      EXPECT_EQ(kStride, writer.Stride());
+      for (unsigned i = 0; i < kNumRecords; ++i) {
+        char* record = writer.Append(i % 48);
+        for (unsigned j = 0; j < kStride; ++j)
+          ASSERT_EQ(0, record[j]);
+        writer.Field<float>(record, 0)[0] = float(i);
+        writer.Field<float>(record, 1)[51] = float(i) + 0.5f;
+        writer.Field<float>(record, 2)[52*3 - 1] = -float(i);
+        writer.Field<uint8_t>(record, 3)[51] = uint8_t(i);
+      }
+      EXPECT_EQ(kNumRecords, writer.NumRecords());
+    }
+    IoThread::Shared().Wait();
+
+    const RecordReader reader(path);
+    ASSERT_EQ(kNumRecords, reader.NumRecords());
+    EXPECT_EQ(kStride, reader.Stride());
+    ASSERT_EQ(4u, reader.Schema().size());
+    EXPECT_EQ(2, reader.FieldIndex("moon"));
+    EXPECT_EQ(-1, reader.FieldIndex("trick"));
+    EXPECT_EQ(withIndex, reader.HasIndex());
+    for (unsigned i = 0; i < kNumRecords; ++i) {
+      ASSERT_EQ(float(i), reader.Field<float>(i, 0)[0]);
+      ASSERT_EQ(float(i) + 0.5f, reader.Field<float>(i, 1)[51]);
+      ASSERT_EQ(-float(i), reader.Field<float>(i, 2)[52*3 - 1]);
+      ASSERT_EQ(uint8_t(i), reader.Field<uint8_t>(i, 3)[51]);
+      if (withIndex) {
+        ASSERT_EQ(i % 48, reader.Key(i));
+      }
+    }
+  }
+}
+
+TEST(RecordFile, rejectsOtherFiles) {
+  const std::string path = TempPath("records.hrec");
+  EXPECT_THROW(RecordReader reader(path), std::runtime_error);
+
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << std::string(RecordFile::kHeaderBytes, 'x');
+  }
+  EXPECT_THROW(RecordReader reader(path), std::runtime_error);
+
+  // A file that is shorter than its header says.
+  {
+    RecordWriter writer(path, kSchema);
+    writer.Append();
+  }
+  IoThread::Shared().Wait();
+  ASSERT_EQ(0, truncate(path.c_str(), RecordFile::kHeaderBytes + 4));
+  EXPECT_THROW(RecordReader reader(path), std::runtime_error);
+}
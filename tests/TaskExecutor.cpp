@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+
+#include "lib/TaskExecutor.h"
+
+#include <atomic>
+#include <vector>
+
+TEST(TaskExecutor, RunsEachTaskOnce) {
+  TaskExecutor executor(4);
+
+  for (unsigned numSlots = 1; numSlots <= executor.MaxSlots() + 1; ++numSlots) {
+    const unsigned kNumTasks = 1000;
+    std::vector<std::atomic<unsigned>> runs(kNumTasks);
+    for (auto& r : runs)
+      r = 0;
+
+    // Per slot sums need no locking, since each slot is used by one thread at a time.
+    std::vector<uint64_t> slotSums(numSlots, 0);
+    std::atomic<bool> badSlot(false);
+
+    executor.ParallelFor(kNumTasks, numSlots, [&](unsigned task, unsigned slot) {
+      ++runs[task];
+      if (slot >= numSlots)
+        badSlot = true;
+      else
+        slotSums[slot] += task;
+    });
+
+    EXPECT_FALSE(badSlot);
+    uint64_t sum = 0;
+    for (uint64_t s : slotSums)
+      sum += s;
+    EXPECT_EQ(uint64_t(kNumTasks) * (kNumTasks - 1) / 2, sum);
+    for (unsigned i = 0; i < kNumTasks; ++i)
+      ASSERT_EQ(1u, runs[i]);
+  }
+}
+
+TEST(TaskExecutor, Nested) {
+  TaskExecutor executor(3);
+
+  // Every worker can be busy in an outer task that waits for inner tasks. The waiting threads run the
+  // inner tasks themselves, so this can't deadlock.
+  std::atomic<unsigned> count(0);
+  executor.ParallelFor(16, executor.MaxSlots(), [&](unsigned, unsigned) {
+    executor.ParallelFor(50, executor.MaxSlots(), [&](unsigned, unsigned) { ++count; });
+  });
+  EXPECT_EQ(16u * 50u, count);
+}
+
+TEST(TaskExecutor, Shared) {
+  TaskExecutor& executor = TaskExecutor::Shared();
+  EXPECT_EQ(&executor, &TaskExecutor::Shared());
+  EXPECT_GE(executor.NumThreads(), 1u);
+  EXPECT_EQ(executor.NumThreads() + 1, executor.MaxSlots());
+}
@@ -0,0 +1,205 @@
+#include "gtest/gtest.h"
+
+#include "lib/CompactFeatures.h"
+#include "lib/GameState.h"
+#include "lib/IoThread.h"
+#include "lib/KnowableState.h"
+#include "lib/NumpyWriter.h"
+#include "lib/RecordFile.h"
+#include "lib/WriteTrainingDataSets.h"
+#include "lib/random.h"
+
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+std::string TempDir()
+{
+  char path[] = "/tmp/WriteTrainingDataSetsXXXXXX";
+  EXPECT_TRUE(mkdtemp(path) != 0);
+  return std::string(path) + "/";
+}
+
+std::string ReadFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+const size_t kNumpyHeaderBytes = 6 * 16;
+
+}  // namespace
+
+TEST(NumpyWriter, writesBlocksInOrder) {
+  // Enough rows for several blocks, so that both blocks are reused.
+  const unsigned kNumRows = 3 * BlockWriter::kBlockBytes / (8 * sizeof(float)) + 5;
+  const std::string path = TempDir() + "rows.npy";
+  {
+    NumpyWriter<1> writer(path, std::vector<int>({8}));
+    Eigen::Tensor<float, 1, Eigen::RowMajor> row(8);
+    for (unsigned i = 0; i < kNumRows; ++i) {
+      for (int j = 0; j < 8; ++j)
+        row(j) = float(i * 8 + j);
+      writer.Append(row);
+    }
+    EXPECT_EQ(kNumRows, writer.NumTensors());
+  }
+  IoThread::Shared().Wait();
+
+  const std::string contents = ReadFile(path);
+  ASSERT_EQ(kNumpyHeaderBytes + kNumRows * 8 * sizeof(float), contents.size());
+  std::ostringstream shape;
+  shape << "'shape': (" << kNumRows << ", 8)";
+  EXPECT_NE(std::string::npos, contents.substr(0, kNumpyHeaderBytes).find(shape.str()));
+  EXPECT_EQ('\n', contents[kNumpyHeaderBytes - 1]);
+
+  const float* data = reinterpret_cast<const float*>(contents.data() + kNumpyHeaderBytes);
+  for (unsigned i = 0; i < kNumRows * 8; ++i)
+    ASSERT_EQ(float(i), data[i]);
+}
+
+TEST(WriteTrainingDataSets, rotatesShardsAndListsThemInManifest) {
+  const std::string dir = TempDir();
+  const unsigned kRowsPerShard = 10;
+  const unsigned kNumRows = 25;
+  std::vector<unsigned> plays;
+  std::vector<unsigned> numChoices;
+  std::vector<float> features;
+  {
+    WriteTrainingDataSets writer(dir, kRowsPerShard * WriteTrainingDataSets::kBytesPerRow);
+    const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+    float expectedScore[13];
+    float moonProb[13][3];
+    float winsTrickProb[13];
+    for (unsigned i = 0; i < 13; ++i) {
+      expectedScore[i] = float(i + 1);
+      winsTrickProb[i] = float(i + 1) / 16;
+      for (unsigned j = 0; j < 3; ++j)
+        moonProb[i][j] = float(j + 1) / 4;
+    }
+    unsigned numRows = 0;
+    while (numRows < kNumRows) {
+      GameState state;
+      while (!state.Done() && numRows < kNumRows) {
+        const KnowableState knowable(state);
+        plays.push_back(state.PlayNumber());
+        numChoices.push_back(knowable.LegalPlays().Size());
+        features.resize(features.size() + KnowableState::kNumFeatures);
+        knowable.EncodeFeatures(&features[features.size() - KnowableState::kNumFeatures]);
+        writer.OnWriteData(knowable, 0, expectedScore, moonProb, winsTrickProb);
+        ++numRows;
+        state.PlayCard(state.LegalPlays().aCardAtRandom(rng));
+      }
+    }
+  }
+  IoThread::Shared().Wait();
+
+  // One manifest, listing three shards of 10, 10 and 5 rows.
+  std::string hash;
+  DIR* listing = opendir(dir.c_str());
+  while (struct dirent* entry = readdir(listing)) {
+    const std::string name(entry->d_name);
+    const size_t suffix = name.find("-manifest.txt");
+    if (suffix != std::string::npos) {
+      EXPECT_TRUE(hash.empty());
+      hash = name.substr(0, suffix);
+    }
+  }
+  closedir(listing);
+  ASSERT_FALSE(hash.empty());
+
+  std::istringstream manifest(ReadFile(dir + hash + "-manifest.txt"));
+  const unsigned kExpectedRows[3] = {10, 10, 5};
+  for (unsigned shard = 0; shard < 3; ++shard) {
+    std::string prefix;
+    unsigned rows = 0;
+    ASSERT_TRUE(bool(manifest >> prefix >> rows));
+    char expectedPrefix[64];
+    snprintf(expectedPrefix, sizeof(expectedPrefix), "%s-%04u", hash.c_str(), shard);
+    EXPECT_EQ(expectedPrefix, prefix);
+    EXPECT_EQ(kExpectedRows[shard], rows);
+
+    const RecordReader reader(dir + prefix + ".hrec");
+    ASSERT_EQ(rows, reader.NumRecords());
+    EXPECT_EQ(WriteTrainingDataSets::kBytesPerRow, reader.Stride());
+    ASSERT_EQ(5u, reader.Schema().size());
+    EXPECT_EQ(std::vector<int>({156}), reader.Schema()[reader.FieldIndex("features")].mShape);
+    EXPECT_EQ(std::vector<int>({13, 3}), reader.Schema()[reader.FieldIndex("moon")].mShape);
+    ASSERT_TRUE(reader.HasIndex());
+    for (unsigned i = 0; i < rows; ++i) {
+      const unsigned row = shard * kRowsPerShard + i;
+      EXPECT_EQ(plays[row], reader.Key(i));
+
+      float decoded[KnowableState::kNumFeatures];
+      reader.Field<CompactFeatures>(i, reader.FieldIndex("features"))->Decode(decoded);
+      EXPECT_EQ(0, memcmp(&features[row * KnowableState::kNumFeatures], decoded, sizeof(decoded)));
+
+      // The features computed again from the stored state are the same.
+      const KnowableState state(*reader.Field<PackedKnowableState>(i, reader.FieldIndex("state")));
+      EXPECT_EQ(plays[row], state.PlayNumber());
+      state.EncodeFeatures(decoded);
+      EXPECT_EQ(0, memcmp(&features[row * KnowableState::kNumFeatures], decoded, sizeof(decoded)));
+
+      const float* score = reader.Field<float>(i, reader.FieldIndex("score"));
+      const float* moon = reader.Field<float>(i, reader.FieldIndex("moon"));
+      for (unsigned j = 0; j < 13; ++j) {
+        EXPECT_EQ(j < numChoices[row] ? float(j + 1) : 0.0f, score[j]);
+        EXPECT_EQ(j < numChoices[row] ? 0.75f : 0.0f, moon[j*3 + 2]);
+      }
+    }
+  }
+  std::string extra;
+  EXPECT_FALSE(bool(manifest >> extra));
+}
+
+TEST(WriteTrainingDataSets, writesStateOnlyRecords) {
+  const std::string dir = TempDir();
+  const unsigned kNumRows = 30;
+  std::vector<PackedKnowableState> states;
+  std::vector<unsigned> numChoices;
+  {
+    WriteTrainingDataSets writer(dir, WriteTrainingDataSets::kDefaultMaxShardBytes, WriteTrainingDataSets::kStateOnly);
+    const RandomGenerator& rng = RandomGenerator::ThreadSpecific();
+    float expectedScore[13];
+    float moonProb[13][3] = {};
+    float winsTrickProb[13] = {};
+    for (unsigned i = 0; i < 13; ++i)
+      expectedScore[i] = float(i + 1);
+    GameState state;
+    while (states.size() < kNumRows) {
+      const KnowableState knowable(state);
+      states.emplace_back(knowable);
+      numChoices.push_back(knowable.LegalPlays().Size());
+      writer.OnWriteData(knowable, 0, expectedScore, moonProb, winsTrickProb);
+      state.PlayCard(state.LegalPlays().aCardAtRandom(rng));
+    }
+  }
+  IoThread::Shared().Wait();
+
+  std::string shard;
+  DIR* listing = opendir(dir.c_str());
+  while (struct dirent* entry = readdir(listing)) {
+    const std::string name(entry->d_name);
+    if (name.size() > 5 && name.substr(name.size() - 5) == ".hrec")
+      shard = name;
+  }
+  closedir(listing);
+  ASSERT_FALSE(shard.empty());
+
+  const RecordReader reader(dir + shard);
+  ASSERT_EQ(kNumRows, reader.NumRecords());
+  EXPECT_EQ(WriteTrainingDataSets::kStateOnlyBytesPerRow, reader.Stride());
+  EXPECT_EQ(-1, reader.FieldIndex("features"));
+  for (unsigned i = 0; i < kNumRows; ++i) {
+    EXPECT_EQ(states[i], *reader.Field<PackedKnowableState>(i, reader.FieldIndex("state")));
+    const float* score = reader.Field<float>(i, reader.FieldIndex("score"));
+    for (unsigned j = 0; j < 13; ++j)
+      EXPECT_EQ(j < numChoices[i] ? float(j + 1) : 0.0f, score[j]);
+  }
+}
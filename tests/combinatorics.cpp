@@ -52,3 +52,34 @@ TEST(asHexString, fill) {
   EXPECT_EQ(std::string("0ad55e315634dda658bf49200"), asHexString(N, 25));
   EXPECT_EQ(std::string("00ad55e315634dda658bf49200"), asHexString(N, 26));
 }
+
+TEST(combinations64, table) {
+  static_assert(combinations64(52, 13) == 635013559600u, "computed at compile time");
+  for (unsigned n = 0; n <= kMaxCombinationsN; ++n) {
+    // C(n, k) = C(n, k-1) * (n-k+1) / k, which is exact and can't overflow 128 bits for these n.
+    uint128_t expected = 1;
+    for (unsigned k = 0; k <= n; ++k) {
+      if (k > 0)
+        expected = expected * (n - k + 1) / k;
+      ASSERT_TRUE(expected == combinations64(n, k)) << n << " " << k;
+      ASSERT_TRUE(expected == combinations128(n, k)) << n << " " << k;
+    }
+    if (n < kMaxCombinationsN) {
+      EXPECT_EQ(0u, combinations64(n, n + 1));
+    }
+  }
+  EXPECT_EQ(495918532948104u, combinations64(52, 26));
+}
+
+TEST(multinomial128, handCapacities) {
+  static_assert(multinomial128(13, 13, 13, 13) == possibleDistinguishableDeals(), "computed at compile time");
+  EXPECT_EQ(1u, (unsigned) multinomial128(0, 0, 0, 0));
+  EXPECT_EQ(6u, (unsigned) multinomial128(1, 1, 1, 0));
+
+  // The order of the hands doesn't matter.
+  const unsigned capacities[4] = {3, 12, 7, 0};
+  const uint128_t expected = multinomial128(capacities);
+  EXPECT_TRUE(expected == multinomial128(12, 0, 3, 7));
+  EXPECT_TRUE(expected == multinomial128(0, 7, 12, 3));
+  EXPECT_TRUE(expected == combinations128(22, 3) * combinations128(19, 12));
+}
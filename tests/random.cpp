@@ -74,3 +74,23 @@ TEST(random, range128bot8Bits) {
   printf("range128bot8Bits %f %f\n", lo, hi);
 }
 
+
+TEST(random, seeded) {
+  RandomGenerator a(12345);
+  RandomGenerator b(12345);
+  RandomGenerator c(12346);
+
+  unsigned same = 0;
+  for (int i=0; i<100; i++) {
+    const uint64_t x = a.random64();
+    EXPECT_EQ(x, b.random64());
+    if (x == c.random64())
+      ++same;
+  }
+  EXPECT_EQ(0u, same);
+
+  // Seed() restarts the sequence.
+  const uint64_t first = RandomGenerator(7).random64();
+  a.Seed(7);
+  EXPECT_EQ(first, a.random64());
+}